@@ -0,0 +1,159 @@
+#pragma once
+
+// Minimal microbenchmark harness for audio-server-microbench.
+//
+// Each case is calibrated so one sample takes roughly SAMPLE_TARGET, then
+// timed over several samples. The median is reported as the headline number
+// (robust to the occasional preemption) along with min and relative MAD.
+
+#include "JsonBuilder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+namespace bench {
+
+// Keeps the compiler from optimizing away a computed value
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+// Forces pending memory writes to be treated as observable
+inline void clobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;    // Per sample
+    double nsPerOpMedian = 0.0;
+    double nsPerOpMin = 0.0;
+    double madPercent = 0.0;    // Median absolute deviation relative to the median
+    double bytesPerSecond = 0.0;
+};
+
+class BenchHarness {
+public:
+    static constexpr int SAMPLES = 15;
+    static constexpr auto SAMPLE_TARGET = std::chrono::milliseconds(20);
+
+    explicit BenchHarness(std::string filter = {})
+        : filter_(std::move(filter)) {
+    }
+
+    // fn runs one operation; bytesPerOp is used for the throughput column (0 = none)
+    template<typename Fn>
+    void run(const std::string& name, size_t bytesPerOp, Fn&& fn) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+            return;
+        }
+
+        uint64_t iterations = calibrate(fn);
+
+        std::vector<double> samples;
+        samples.reserve(SAMPLES);
+        for (int s = 0; s < SAMPLES; ++s) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                fn();
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            samples.push_back(elapsed / static_cast<double>(iterations));
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double median = samples[samples.size() / 2];
+
+        std::vector<double> deviations;
+        deviations.reserve(samples.size());
+        for (double v : samples) {
+            deviations.push_back(std::fabs(v - median));
+        }
+        std::sort(deviations.begin(), deviations.end());
+
+        BenchResult result;
+        result.name = name;
+        result.iterations = iterations;
+        result.nsPerOpMedian = median;
+        result.nsPerOpMin = samples.front();
+        result.madPercent = median > 0.0 ? 100.0 * deviations[deviations.size() / 2] / median : 0.0;
+        result.bytesPerSecond = (bytesPerOp > 0 && median > 0.0)
+            ? static_cast<double>(bytesPerOp) * 1.0e9 / median : 0.0;
+
+        std::fprintf(stderr, "%-48s %12.1f ns/op %12.1f min %6.2f%% mad", name.c_str(),
+                     result.nsPerOpMedian, result.nsPerOpMin, result.madPercent);
+        if (result.bytesPerSecond > 0.0) {
+            std::fprintf(stderr, " %10.1f MB/s", result.bytesPerSecond / 1.0e6);
+        }
+        std::fprintf(stderr, "\n");
+
+        results_.push_back(result);
+    }
+
+    const std::vector<BenchResult>& results() const { return results_; }
+
+    std::string toJson() const {
+        JsonBuilder json;
+        json.beginObject()
+            .keyValue("benchmark", "micro")
+            .keyValue("samples", SAMPLES)
+            .key("results").beginArray();
+
+        for (const auto& r : results_) {
+            json.beginObject()
+                .keyValue("name", r.name)
+                .keyValue("iterations", static_cast<double>(r.iterations))
+                .keyValue("nsPerOp", r.nsPerOpMedian)
+                .keyValue("nsPerOpMin", r.nsPerOpMin)
+                .keyValue("madPercent", r.madPercent)
+                .keyValue("bytesPerSecond", r.bytesPerSecond)
+            .endObject();
+        }
+
+        json.endArray().endObject();
+        return json.build();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template<typename Fn>
+    static uint64_t calibrate(Fn& fn) {
+        // Warm caches and branch predictors, then grow until one sample is long enough
+        uint64_t iterations = 1;
+        while (true) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                fn();
+            }
+            auto elapsed = Clock::now() - start;
+            if (elapsed >= SAMPLE_TARGET || iterations >= (uint64_t{1} << 40)) {
+                return iterations;
+            }
+            if (elapsed < SAMPLE_TARGET / 10) {
+                iterations *= 10;
+            } else {
+                iterations *= 2;
+            }
+        }
+    }
+
+    std::string filter_;
+    std::vector<BenchResult> results_;
+};
+
+} // namespace bench
+} // namespace audioserver
@@ -0,0 +1,205 @@
+#pragma once
+
+// Frozen copy of the stringstream-based JsonBuilder that the API server used
+// before the streaming rewrite, kept so audio-server-microbench can compare
+// the two on the same payloads. Not used by the server.
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+
+namespace audioserver {
+namespace bench {
+
+class LegacyJsonBuilder {
+public:
+    LegacyJsonBuilder& beginObject() {
+        maybeComma();
+        append("{");
+        depth_++;
+        needsComma_.push_back(false);
+        return *this;
+    }
+
+    LegacyJsonBuilder& endObject() {
+        depth_--;
+        needsComma_.pop_back();
+        append("}");
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& beginArray() {
+        maybeComma();
+        append("[");
+        depth_++;
+        needsComma_.push_back(false);
+        return *this;
+    }
+
+    LegacyJsonBuilder& endArray() {
+        depth_--;
+        needsComma_.pop_back();
+        append("]");
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& key(const std::string& k) {
+        maybeComma();
+        append("\"" + escape(k) + "\":");
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(const std::string& v) {
+        maybeComma();
+        append("\"" + escape(v) + "\"");
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(const char* v) {
+        return value(std::string(v));
+    }
+
+    LegacyJsonBuilder& value(int v) {
+        maybeComma();
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(uint32_t v) {
+        maybeComma();
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(uint64_t v) {
+        maybeComma();
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(uint16_t v) {
+        maybeComma();
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(bool v) {
+        maybeComma();
+        append(v ? "true" : "false");
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& value(double v) {
+        maybeComma();
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, const std::string& v) {
+        key(k);
+        append("\"" + escape(v) + "\"");
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, const char* v) {
+        return keyValue(k, std::string(v));
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, int v) {
+        key(k);
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, uint32_t v) {
+        key(k);
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, uint64_t v) {
+        key(k);
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, uint16_t v) {
+        key(k);
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, bool v) {
+        key(k);
+        append(v ? "true" : "false");
+        markNeedsComma();
+        return *this;
+    }
+
+    LegacyJsonBuilder& keyValue(const std::string& k, double v) {
+        key(k);
+        append(std::to_string(v));
+        markNeedsComma();
+        return *this;
+    }
+
+    std::string build() const {
+        return ss_.str();
+    }
+
+private:
+    void append(const std::string& s) {
+        ss_ << s;
+    }
+
+    void maybeComma() {
+        if (!needsComma_.empty() && needsComma_.back()) {
+            append(",");
+            needsComma_.back() = false;
+        }
+    }
+
+    void markNeedsComma() {
+        if (!needsComma_.empty()) {
+            needsComma_.back() = true;
+        }
+    }
+
+    std::string escape(const std::string& s) {
+        std::string result;
+        for (char c : s) {
+            switch (c) {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\n': result += "\\n"; break;
+                case '\r': result += "\\r"; break;
+                case '\t': result += "\\t"; break;
+                default: result += c; break;
+            }
+        }
+        return result;
+    }
+
+    std::stringstream ss_;
+    int depth_ = 0;
+    std::vector<bool> needsComma_;
+};
+
+} // namespace bench
+} // namespace audioserver
@@ -0,0 +1,805 @@
+// audio-server-bench: end-to-end sender -> receiver benchmark over loopback.
+//
+// Runs a TcpPcmBackend sender and receiver in-process, streams synthetic audio
+// through them and plays it out of a jitter buffer on a paced consumer thread.
+// Each block carries its index in the first sample so the receiver can match
+// it to the send timestamp. Results for the whole sweep are printed as JSON.
+//
+// --disconnect instead measures how long the receiver takes to notice a
+// sender that goes silent without closing its socket, and how quickly a
+// waiting sender takes over the freed slot.
+//
+// --sync <N> feeds one paced source to N receivers, each behind its own
+// sender, and plays them out on playout threads with different block sizes
+// and phases through PlayoutScheduler. Every frame carries its index, so the
+// offset between receivers is measured from what each one actually plays.
+
+#include "Config.h"
+#include "JsonBuilder.h"
+#include "PlayoutScheduler.h"
+#include "RingBuffer.h"
+#include "ToneGenerator.h"
+#include "transport/TcpPcmBackend.h"
+#include "transport/TcpPcmProtocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define CLOSE_SOCKET closesocket
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<uint32_t> bufferSizes = {32, 64, 128, 256, 512, 1024, 2048, 4096};
+    std::vector<uint16_t> channelCounts = {1, 2, 8, 32, 64};
+    std::vector<uint32_t> sampleRates = {44100, 48000, 96000};
+    uint32_t durationMs = 1000;
+    uint16_t port = 19876;
+    bool unpaced = false;
+    bool disconnect = false;
+    uint32_t syncReceivers = 0;
+    uint32_t syncDelayMs = 100;
+    std::string outputFile;
+};
+
+struct RunResult {
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    uint32_t bufferSize = 0;
+    bool connected = false;
+    double wallSeconds = 0.0;
+    uint32_t blocksSent = 0;
+    uint32_t blocksReceived = 0;
+    uint64_t bytesReceived = 0;
+    double throughputMBps = 0.0;
+    double realtimeFactor = 0.0;
+    double cpuPercent = 0.0;
+    double latencyP50Us = 0.0;
+    double latencyP90Us = 0.0;
+    double latencyP99Us = 0.0;
+    double latencyMaxUs = 0.0;
+    uint32_t packetsLost = 0;
+    uint32_t blockGaps = 0;
+    uint32_t underruns = 0;
+};
+
+struct DisconnectResult {
+    bool connected = false;
+    bool detected = false;
+    double detectMs = 0.0;    // Last byte from the silent peer -> receiver drops it
+    double takeoverMs = 0.0;  // Drop -> waiting sender streaming
+    uint64_t peerTimeouts = 0;
+};
+
+struct SyncReceiverResult {
+    bool connected = false;
+    bool measured = false;
+    int playoutFrames = 0;
+    double phaseUs = 0.0;            // Start of its playout clock after the first receiver's
+    double offsetUs = 0.0;           // Plays this much later than the first receiver, measured
+    audioserver::PlayoutScheduler::Status status;
+    uint64_t clockExchanges = 0;
+    uint32_t underruns = 0;
+};
+
+struct SyncResult {
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    uint32_t bufferSize = 0;
+    uint32_t delayMs = 0;
+    std::vector<SyncReceiverResult> receivers;
+    double maxOffsetUs = 0.0;        // Spread between the earliest and latest receiver
+};
+
+template<typename T>
+std::vector<T> parseList(const std::string& arg) {
+    std::vector<T> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(static_cast<T>(std::stoul(item)));
+    }
+    if (values.empty()) {
+        throw std::runtime_error("Empty list: " + arg);
+    }
+    return values;
+}
+
+void printUsage() {
+    std::cout << R"(audio-server-bench - Loopback sender/receiver benchmark
+
+USAGE:
+    audio-server-bench [OPTIONS]
+
+OPTIONS:
+    --buffer-sizes <LIST>   Comma-separated buffer sizes (default: 32,64,...,4096)
+    --channels <LIST>       Comma-separated channel counts (default: 1,2,8,32,64)
+    --sample-rates <LIST>   Comma-separated sample rates (default: 44100,48000,96000)
+    --duration-ms <MS>      Streaming time per configuration (default: 1000)
+    --port <PORT>           First loopback port, incremented per run (default: 19876)
+    --unpaced               Send as fast as possible to measure peak throughput
+    --disconnect            Measure silent-peer detection instead of the sweep
+    --sync <N>              Measure playout offset between N synchronized receivers
+                            instead of the sweep, using the first rate, channel
+                            count and buffer size given
+    --sync-delay-ms <MS>    Presentation delay for --sync (default: 100)
+    --output <FILE>         Write JSON results to FILE instead of stdout
+    --help, -h              Show this help message
+)";
+}
+
+BenchOptions parseArgs(int argc, char* argv[]) {
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        } else if (arg == "--buffer-sizes" && i + 1 < argc) {
+            options.bufferSizes = parseList<uint32_t>(argv[++i]);
+        } else if (arg == "--channels" && i + 1 < argc) {
+            options.channelCounts = parseList<uint16_t>(argv[++i]);
+        } else if (arg == "--sample-rates" && i + 1 < argc) {
+            options.sampleRates = parseList<uint32_t>(argv[++i]);
+        } else if (arg == "--duration-ms" && i + 1 < argc) {
+            options.durationMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--unpaced") {
+            options.unpaced = true;
+        } else if (arg == "--disconnect") {
+            options.disconnect = true;
+        } else if (arg == "--sync" && i + 1 < argc) {
+            options.syncReceivers = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--sync-delay-ms" && i + 1 < argc) {
+            options.syncDelayMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.outputFile = argv[++i];
+        } else {
+            throw std::runtime_error("Unknown argument: " + arg);
+        }
+    }
+
+    return options;
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+double percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+bool waitForState(const audioserver::TransportBackend& transport,
+                  audioserver::TransportState state,
+                  std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (Clock::now() < deadline) {
+        if (transport.state() == state) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+RunResult runOnce(const BenchOptions& options, uint32_t sampleRate, uint16_t channels,
+                  uint32_t bufferSize, uint16_t port) {
+    RunResult result;
+    result.sampleRate = sampleRate;
+    result.channels = channels;
+    result.bufferSize = bufferSize;
+
+    audioserver::StreamConfig streamConfig;
+    streamConfig.sampleRate = sampleRate;
+    streamConfig.channels = channels;
+    streamConfig.bufferSize = bufferSize;
+
+    const size_t blockSamples = static_cast<size_t>(bufferSize) * channels;
+    const double blockSeconds = static_cast<double>(bufferSize) / sampleRate;
+
+    // Send timestamps indexed by block number; sized for the paced run plus headroom
+    size_t maxBlocks = static_cast<size_t>(options.durationMs / 1000.0 / blockSeconds) * 2 + 16;
+    if (options.unpaced) {
+        maxBlocks *= 64;
+    }
+    std::vector<std::atomic<int64_t>> sendTimes(maxBlocks);
+    for (auto& t : sendTimes) {
+        t.store(0, std::memory_order_relaxed);
+    }
+    std::vector<int64_t> latencies;
+    latencies.reserve(maxBlocks);
+
+    // Receiver side: jitter buffer sized like Main.cpp (one second)
+    audioserver::RingBuffer<float> ringBuffer(static_cast<size_t>(sampleRate) * channels, channels);
+    std::atomic<uint32_t> blocksReceived{0};
+    uint32_t blockGaps = 0;
+    int64_t lastBlock = -1;
+
+    audioserver::TcpPcmBackend receiver;
+    receiver.setAudioReceivedCallback([&](const float* data, int numChannels, int numSamples, int64_t) {
+        int64_t arrival = nowNs();
+        auto block = static_cast<int64_t>(data[0]);
+
+        if (block >= 0 && static_cast<size_t>(block) < sendTimes.size()) {
+            int64_t sent = sendTimes[static_cast<size_t>(block)].load(std::memory_order_acquire);
+            if (sent != 0) {
+                latencies.push_back(arrival - sent);
+            }
+        }
+        if (lastBlock >= 0 && block != lastBlock + 1) {
+            blockGaps++;
+        }
+        lastBlock = block;
+        blocksReceived++;
+
+        ringBuffer.write(data, static_cast<size_t>(numChannels * numSamples));
+    });
+
+    audioserver::TcpPcmBackend sender;
+
+    if (!receiver.startReceiver(port, streamConfig) ||
+        !sender.startSender("127.0.0.1", port, streamConfig) ||
+        !waitForState(sender, audioserver::TransportState::Streaming, std::chrono::seconds(2))) {
+        sender.stop();
+        receiver.stop();
+        return result;
+    }
+    result.connected = true;
+
+    std::atomic<bool> running{true};
+
+    // Paced playout standing in for the output device callback
+    uint32_t underruns = 0;
+    std::thread playoutThread([&]() {
+        std::vector<float> block(blockSamples);
+        auto period = std::chrono::nanoseconds(static_cast<int64_t>(blockSeconds * 1.0e9));
+
+        // Prefill two blocks before starting the clock, as a device would after open
+        while (running && ringBuffer.size() < blockSamples * 2) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        auto nextTime = Clock::now();
+        while (running) {
+            if (options.unpaced) {
+                // Just keep the jitter buffer drained; underruns are meaningless here
+                if (ringBuffer.read(block.data(), blockSamples) == 0) {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            if (ringBuffer.read(block.data(), blockSamples) < blockSamples) {
+                underruns++;
+            }
+            nextTime += period;
+            std::this_thread::sleep_until(nextTime);
+        }
+    });
+
+    // Sender: synthetic tone with the block index stamped into the first sample
+    audioserver::ToneGenerator toneGen(sampleRate, 440, channels);
+    std::vector<std::vector<float>> channelBuffers(channels, std::vector<float>(bufferSize));
+    std::vector<float*> channelPtrs(channels);
+    for (size_t ch = 0; ch < channels; ++ch) {
+        channelPtrs[ch] = channelBuffers[ch].data();
+    }
+
+    auto period = std::chrono::nanoseconds(static_cast<int64_t>(blockSeconds * 1.0e9));
+    auto start = Clock::now();
+    auto end = start + std::chrono::milliseconds(options.durationMs);
+    auto nextTime = start;
+    std::clock_t cpuStart = std::clock();
+
+    uint32_t blocksSent = 0;
+    while (Clock::now() < end && blocksSent < sendTimes.size()) {
+        toneGen.generate(channelPtrs.data(), channels, static_cast<int>(bufferSize));
+        channelPtrs[0][0] = static_cast<float>(blocksSent);
+
+        sendTimes[blocksSent].store(nowNs(), std::memory_order_release);
+        if (!sender.sendAudio(const_cast<const float* const*>(channelPtrs.data()),
+                              channels, static_cast<int>(bufferSize))) {
+            break;
+        }
+        blocksSent++;
+
+        if (!options.unpaced) {
+            nextTime += period;
+            std::this_thread::sleep_until(nextTime);
+        }
+    }
+
+    // Let in-flight chunks land before tearing down
+    auto drainDeadline = Clock::now() + std::chrono::milliseconds(500);
+    while (blocksReceived < blocksSent && Clock::now() < drainDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::clock_t cpuEnd = std::clock();
+    auto wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    running = false;
+    playoutThread.join();
+
+    auto receiverStatus = receiver.getStatus();
+    sender.stop();
+    receiver.stop();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    double audioSeconds = blocksReceived * blockSeconds;
+    result.wallSeconds = wall;
+    result.blocksSent = blocksSent;
+    result.blocksReceived = blocksReceived;
+    result.bytesReceived = receiverStatus.bytesReceived;
+    result.throughputMBps = static_cast<double>(receiverStatus.bytesReceived) / wall / 1.0e6;
+    result.realtimeFactor = audioSeconds / wall;
+    result.cpuPercent = 100.0 * static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC / wall;
+    result.latencyP50Us = percentile(latencies, 0.50);
+    result.latencyP90Us = percentile(latencies, 0.90);
+    result.latencyP99Us = percentile(latencies, 0.99);
+    result.latencyMaxUs = latencies.empty() ? 0.0 : static_cast<double>(latencies.back()) / 1000.0;
+    result.packetsLost = receiverStatus.packetsLost;
+    result.blockGaps = blockGaps;
+    result.underruns = underruns;
+    return result;
+}
+
+// Connects like a sender, streams a few chunks, then goes quiet with the
+// socket still open - what the receiver sees when a sender loses power
+int connectSilentPeer(uint16_t port, const audioserver::StreamConfig& config, int chunks) {
+    auto sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        CLOSE_SOCKET(sock);
+        return -1;
+    }
+
+    auto header = audioserver::StreamHeader::fromConfig(config).serialize();
+    send(sock, reinterpret_cast<const char*>(header.data()), static_cast<int>(header.size()), 0);
+
+    std::vector<float> audio(static_cast<size_t>(config.bufferSize) * config.channels, 0.0f);
+    for (int i = 0; i < chunks; ++i) {
+        audioserver::ChunkHeader chunk;
+        chunk.size = static_cast<uint32_t>(audio.size() * sizeof(float));
+        chunk.sequence = static_cast<uint32_t>(i);
+        auto chunkHeader = chunk.serialize();
+        send(sock, reinterpret_cast<const char*>(chunkHeader.data()), static_cast<int>(chunkHeader.size()), 0);
+        send(sock, reinterpret_cast<const char*>(audio.data()), static_cast<int>(chunk.size), 0);
+    }
+    return static_cast<int>(sock);
+}
+
+DisconnectResult runDisconnect(uint16_t port) {
+    DisconnectResult result;
+
+    // The waiting sender is accepted microseconds after the drop, so take
+    // timestamps from the transport's callbacks rather than polling state
+    std::atomic<int64_t> droppedNs{0};
+    std::atomic<int64_t> resumedNs{0};
+    std::atomic<int> headers{0};
+
+    audioserver::StreamConfig streamConfig;
+    audioserver::TcpPcmBackend receiver;
+    receiver.setConnectionCallback([&](bool connected) {
+        if (!connected && droppedNs == 0) {
+            droppedNs = nowNs();
+        }
+    });
+    receiver.setStreamConfigCallback([&](const audioserver::StreamConfig&) {
+        if (headers++ > 0 && resumedNs == 0) {
+            resumedNs = nowNs();
+        }
+    });
+    if (!receiver.startReceiver(port, streamConfig)) {
+        return result;
+    }
+
+    int silent = connectSilentPeer(port, streamConfig, 8);
+    int64_t lastByteNs = nowNs();
+    if (silent < 0 || !waitForState(receiver, audioserver::TransportState::Streaming, std::chrono::seconds(2))) {
+        if (silent >= 0) {
+            CLOSE_SOCKET(silent);
+        }
+        receiver.stop();
+        return result;
+    }
+    result.connected = true;
+
+    // Queue a healthy sender behind the silent one; it sits in the listen
+    // backlog until the receiver frees the slot
+    audioserver::TcpPcmBackend sender;
+    sender.startSender("127.0.0.1", port, streamConfig);
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(audioserver::DISCONNECT_TIMEOUT_MS * 2);
+    while (resumedNs == 0 && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (droppedNs != 0) {
+        result.detected = true;
+        result.detectMs = static_cast<double>(droppedNs - lastByteNs) / 1.0e6;
+    }
+    if (resumedNs != 0) {
+        result.takeoverMs = static_cast<double>(resumedNs - droppedNs) / 1.0e6;
+    }
+    result.peerTimeouts = receiver.getStats().peerTimeouts;
+
+    sender.stop();
+    CLOSE_SOCKET(silent);
+    receiver.stop();
+    return result;
+}
+
+// One receiver of the --sync run and the sender feeding it
+struct SyncReceiver {
+    audioserver::TcpPcmBackend sender;
+    audioserver::TcpPcmBackend receiver;
+    std::unique_ptr<audioserver::RingBuffer<float>> ringBuffer;
+    audioserver::PlayoutScheduler scheduler;
+    std::thread playoutThread;
+    std::vector<double> positions;  // Frame playing at the common reference time
+    SyncReceiverResult result;
+};
+
+double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    auto middle = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+SyncResult runSync(const BenchOptions& options, uint16_t port) {
+    SyncResult result;
+    result.sampleRate = options.sampleRates.front();
+    result.channels = options.channelCounts.front();
+    result.bufferSize = options.bufferSizes.front();
+    result.delayMs = options.syncDelayMs;
+
+    audioserver::StreamConfig streamConfig;
+    streamConfig.sampleRate = result.sampleRate;
+    streamConfig.channels = result.channels;
+    streamConfig.bufferSize = result.bufferSize;
+
+    const size_t channels = result.channels;
+    const double nsPerFrame = 1.0e9 / result.sampleRate;
+    const auto period = std::chrono::nanoseconds(static_cast<int64_t>(result.bufferSize * nsPerFrame));
+    const size_t capacity = (static_cast<size_t>(result.sampleRate) * (1000 + options.syncDelayMs) / 1000) * channels;
+
+    std::vector<std::unique_ptr<SyncReceiver>> receivers;
+    bool connected = true;
+    for (uint32_t i = 0; i < options.syncReceivers; ++i) {
+        auto rx = std::make_unique<SyncReceiver>();
+        rx->ringBuffer = std::make_unique<audioserver::RingBuffer<float>>(capacity, channels);
+        rx->scheduler.setDelayMs(static_cast<int>(options.syncDelayMs));
+
+        // Devices differ: half, one and two network blocks per callback
+        rx->result.playoutFrames = static_cast<int>(std::max<uint32_t>(result.bufferSize << (i % 3) >> 1, 1));
+
+        auto* state = rx.get();
+        rx->receiver.setAudioReceivedCallback([state, channels, &result](const float* data, int numChannels,
+                                                                         int numSamples, int64_t mediaNs) {
+            size_t written = state->ringBuffer->write(data, static_cast<size_t>(numChannels * numSamples));
+            state->scheduler.written(mediaNs, written / channels, result.sampleRate);
+        });
+
+        auto rxPort = static_cast<uint16_t>(port + i);
+        rx->result.connected = rx->receiver.startReceiver(rxPort, streamConfig)
+                            && rx->sender.startSender("127.0.0.1", rxPort, streamConfig)
+                            && waitForState(rx->sender, audioserver::TransportState::Streaming, std::chrono::seconds(2));
+        connected = connected && rx->result.connected;
+        receivers.push_back(std::move(rx));
+    }
+
+    std::atomic<bool> running{connected};
+    const auto start = Clock::now();
+    const int64_t startNs = nowNs();
+    const int64_t settleNs = startNs + static_cast<int64_t>(options.durationMs) * 1000000 / 2;
+
+    // Paced playout standing in for each output device, started out of phase
+    for (size_t i = 0; i < receivers.size() && connected; ++i) {
+        auto* rx = receivers[i].get();
+        auto phase = period * static_cast<int64_t>(i) / static_cast<int64_t>(receivers.size());
+        rx->result.phaseUs = static_cast<double>(phase.count()) / 1000.0;
+        rx->playoutThread = std::thread([rx, phase, channels, nsPerFrame, startNs, settleNs, &running, &result]() {
+            const int frames = rx->result.playoutFrames;
+            const auto blockPeriod = std::chrono::nanoseconds(static_cast<int64_t>(frames * nsPerFrame));
+            std::vector<float> block(static_cast<size_t>(frames) * channels);
+
+            auto nextTime = Clock::now() + phase;
+            while (running) {
+                std::this_thread::sleep_until(nextTime);
+                int64_t outputNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    nextTime.time_since_epoch()).count();
+                nextTime += blockPeriod;
+
+                auto plan = rx->scheduler.plan(outputNs, frames, rx->receiver.getClockEstimate());
+                const size_t held = static_cast<size_t>(plan.hold) * channels;
+                size_t skipped = rx->ringBuffer->skip(plan.skip * channels);
+                size_t read = rx->ringBuffer->read(block.data() + held, block.size() - held);
+                rx->scheduler.consumed((skipped + read) / channels);
+                if (read < block.size() - held) {
+                    rx->result.underruns++;
+                    continue;
+                }
+
+                // The last frame is always from the buffer; where it sits in
+                // the stream when the clocks say it plays gives this receiver's
+                // position at startNs, comparable across receivers
+                if (outputNs >= settleNs && rx->scheduler.status().aligned) {
+                    double index = block[block.size() - channels];
+                    double playNs = static_cast<double>(outputNs - startNs) + (frames - 1) * nsPerFrame;
+                    rx->positions.push_back(index - playNs / 1.0e9 * result.sampleRate);
+                }
+            }
+        });
+    }
+
+    // Source: one paced stream fanned out to every sender, each frame's
+    // index in channel 0. Senders stamp a block when they are handed it, so
+    // the order rotates; a fixed one would stamp the last sender tens of
+    // microseconds late every time and show up as its receiver's offset.
+    std::vector<std::vector<float>> channelBuffers(channels, std::vector<float>(result.bufferSize, 0.0f));
+    std::vector<const float*> channelPtrs(channels);
+    for (size_t ch = 0; ch < channels; ++ch) {
+        channelPtrs[ch] = channelBuffers[ch].data();
+    }
+
+    auto end = start + std::chrono::milliseconds(options.durationMs);
+    auto nextTime = start;
+    uint64_t frame = 0;
+    while (running && Clock::now() < end) {
+        for (auto& sample : channelBuffers[0]) {
+            sample = static_cast<float>(frame++);
+        }
+        for (size_t i = 0; i < receivers.size(); ++i) {
+            auto& rx = receivers[(frame / result.bufferSize + i) % receivers.size()];
+            rx->sender.sendAudio(channelPtrs.data(), static_cast<int>(channels), static_cast<int>(result.bufferSize));
+        }
+        nextTime += period;
+        std::this_thread::sleep_until(nextTime);
+    }
+
+    running = false;
+    double reference = 0.0;
+    double earliest = 0.0;
+    double latest = 0.0;
+    bool haveReference = false;
+    for (auto& rx : receivers) {
+        if (rx->playoutThread.joinable()) {
+            rx->playoutThread.join();
+        }
+        rx->result.status = rx->scheduler.status();
+        rx->result.clockExchanges = rx->receiver.getStats().clockExchanges;
+        rx->sender.stop();
+        rx->receiver.stop();
+
+        rx->result.measured = !rx->positions.empty();
+        if (!rx->result.measured) {
+            continue;
+        }
+        double position = median(rx->positions);
+        if (!haveReference) {
+            reference = position;
+            haveReference = true;
+        }
+        // Behind in the stream means playing later
+        rx->result.offsetUs = (reference - position) / result.sampleRate * 1.0e6;
+        earliest = std::min(earliest, rx->result.offsetUs);
+        latest = std::max(latest, rx->result.offsetUs);
+    }
+
+    result.maxOffsetUs = latest - earliest;
+    for (auto& rx : receivers) {
+        result.receivers.push_back(rx->result);
+    }
+    return result;
+}
+
+std::string toJson(const SyncResult& r) {
+    audioserver::JsonBuilder json;
+    json.beginObject()
+        .keyValue("benchmark", "sync")
+        .keyValue("sampleRate", r.sampleRate)
+        .keyValue("channels", r.channels)
+        .keyValue("bufferSize", r.bufferSize)
+        .keyValue("delayMs", r.delayMs)
+        .keyValue("maxOffsetUs", r.maxOffsetUs)
+        .key("receivers").beginArray();
+
+    for (const auto& rx : r.receivers) {
+        json.beginObject()
+            .keyValue("connected", rx.connected)
+            .keyValue("measured", rx.measured)
+            .keyValue("playoutFrames", rx.playoutFrames)
+            .keyValue("phaseUs", rx.phaseUs)
+            .keyValue("offsetUs", rx.offsetUs)
+            .keyValue("aligned", rx.status.aligned)
+            .keyValue("clockLocked", rx.status.clockLocked)
+            .keyValue("clockOffsetUs", static_cast<double>(rx.status.clockOffsetNs) / 1000.0)
+            .keyValue("clockRttUs", static_cast<double>(rx.status.clockRttNs) / 1000.0)
+            .keyValue("clockExchanges", rx.clockExchanges)
+            .keyValue("errorUs", static_cast<double>(rx.status.errorNs) / 1000.0)
+            .keyValue("framesSkipped", rx.status.framesSkipped)
+            .keyValue("framesInserted", rx.status.framesInserted)
+            .keyValue("alignFramesSkipped", rx.status.alignFramesSkipped)
+            .keyValue("alignFramesHeld", rx.status.alignFramesHeld)
+            .keyValue("realigns", rx.status.realigns)
+            .keyValue("underruns", rx.underruns)
+        .endObject();
+    }
+
+    json.endArray().endObject();
+    return json.build();
+}
+
+std::string toJson(const DisconnectResult& r) {
+    audioserver::JsonBuilder json;
+    json.beginObject()
+        .keyValue("benchmark", "disconnect")
+        .keyValue("timeoutMs", static_cast<int>(audioserver::DISCONNECT_TIMEOUT_MS))
+        .keyValue("connected", r.connected)
+        .keyValue("detected", r.detected)
+        .keyValue("detectMs", r.detectMs)
+        .keyValue("takeoverMs", r.takeoverMs)
+        .keyValue("peerTimeouts", r.peerTimeouts)
+    .endObject();
+    return json.build();
+}
+
+std::string toJson(const BenchOptions& options, const std::vector<RunResult>& results) {
+    audioserver::JsonBuilder json;
+    json.beginObject()
+        .keyValue("benchmark", "loopback")
+        .keyValue("mode", options.unpaced ? "unpaced" : "paced")
+        .keyValue("durationMs", options.durationMs)
+        .key("results").beginArray();
+
+    for (const auto& r : results) {
+        json.beginObject()
+            .keyValue("sampleRate", r.sampleRate)
+            .keyValue("channels", r.channels)
+            .keyValue("bufferSize", r.bufferSize)
+            .keyValue("connected", r.connected)
+            .keyValue("wallSeconds", r.wallSeconds)
+            .keyValue("blocksSent", r.blocksSent)
+            .keyValue("blocksReceived", r.blocksReceived)
+            .keyValue("bytesReceived", static_cast<double>(r.bytesReceived))
+            .keyValue("throughputMBps", r.throughputMBps)
+            .keyValue("realtimeFactor", r.realtimeFactor)
+            .keyValue("cpuPercent", r.cpuPercent)
+            .key("latencyUs").beginObject()
+                .keyValue("p50", r.latencyP50Us)
+                .keyValue("p90", r.latencyP90Us)
+                .keyValue("p99", r.latencyP99Us)
+                .keyValue("max", r.latencyMaxUs)
+            .endObject()
+            .key("dropouts").beginObject()
+                .keyValue("packetsLost", r.packetsLost)
+                .keyValue("blockGaps", r.blockGaps)
+                .keyValue("underruns", r.underruns)
+            .endObject()
+        .endObject();
+    }
+
+    json.endArray().endObject();
+    return json.build();
+}
+
+// To outputFile, or stdout when none was given
+bool writeJson(const std::string& json, const std::string& outputFile) {
+    if (outputFile.empty()) {
+        std::cout << json << "\n";
+        return true;
+    }
+    std::ofstream out(outputFile);
+    if (!out) {
+        std::cerr << "Failed to write " << outputFile << "\n";
+        return false;
+    }
+    out << json << "\n";
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        options = parseArgs(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    if (options.disconnect) {
+        std::cerr << "Waiting for a silent peer to time out..." << std::flush;
+        auto result = runDisconnect(options.port);
+        std::cerr << (result.detected ? " detected in " + std::to_string(result.detectMs) + " ms\n"
+                                      : " not detected\n");
+        if (!writeJson(toJson(result), options.outputFile)) {
+            return 1;
+        }
+        return result.detected ? 0 : 1;
+    }
+
+    if (options.syncReceivers > 0) {
+        std::cerr << "Playing " << options.syncReceivers << " receivers " << options.syncDelayMs
+                  << " ms behind one source..." << std::flush;
+        auto result = runSync(options, options.port);
+        bool measured = std::all_of(result.receivers.begin(), result.receivers.end(),
+                                    [](const SyncReceiverResult& r) { return r.measured; });
+        std::cerr << (measured ? " within " + std::to_string(result.maxOffsetUs) + " us\n"
+                               : " not all receivers synchronized\n");
+        if (!writeJson(toJson(result), options.outputFile)) {
+            return 1;
+        }
+        return measured ? 0 : 1;
+    }
+
+    std::vector<RunResult> results;
+    uint16_t port = options.port;
+
+    for (uint32_t sampleRate : options.sampleRates) {
+        for (uint16_t channels : options.channelCounts) {
+            for (uint32_t bufferSize : options.bufferSizes) {
+                std::cerr << "Running " << sampleRate << " Hz, " << channels << " ch, "
+                          << bufferSize << " samples..." << std::flush;
+
+                auto result = runOnce(options, sampleRate, channels, bufferSize, port++);
+
+                if (result.connected) {
+                    std::cerr << " p99 " << result.latencyP99Us << " us, "
+                              << result.underruns << " underruns\n";
+                } else {
+                    std::cerr << " failed to connect\n";
+                }
+                results.push_back(result);
+            }
+        }
+    }
+
+    if (!writeJson(toJson(options, results), options.outputFile)) {
+        return 1;
+    }
+
+    bool allConnected = std::all_of(results.begin(), results.end(),
+                                    [](const RunResult& r) { return r.connected; });
+    return allConnected ? 0 : 1;
+}
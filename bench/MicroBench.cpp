@@ -0,0 +1,403 @@
+// audio-server-microbench: microbenchmarks for the hot-path primitives.
+//
+// Covers the jitter buffer, wire protocol headers, (de)interleaving, the test
+// tone generator, the level meter, the /listen tap, the receiver's resampler,
+// channel routing and JSON serialization of the API payloads
+// (compared with the previous JsonBuilder kept in LegacyJsonBuilder.h).
+// Human readable results go to stderr; --json writes the machine readable form.
+
+#include "BenchHarness.h"
+#include "ChannelRouter.h"
+#include "Histogram.h"
+#include "Interleave.h"
+#include "JsonBuilder.h"
+#include "LegacyJsonBuilder.h"
+#include "LevelMeter.h"
+#include "ListenTap.h"
+#include "Resampler.h"
+#include "RingBuffer.h"
+#include "ToneGenerator.h"
+#include "transport/TcpPcmProtocol.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using audioserver::bench::BenchHarness;
+using audioserver::bench::clobberMemory;
+using audioserver::bench::doNotOptimize;
+
+namespace {
+
+// Planar audio with stable pointers, shaped like a device callback buffer
+struct PlanarBuffer {
+    PlanarBuffer(int numChannels, int numSamples)
+        : data(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(numSamples), 0.25f)) {
+        for (auto& ch : data) {
+            ptrs.push_back(ch.data());
+        }
+    }
+
+    std::vector<std::vector<float>> data;
+    std::vector<float*> ptrs;
+};
+
+// Representative /status payload
+template<typename Builder>
+void writeStatusJson(Builder& json) {
+    json.beginObject()
+        .keyValue("mode", "receiver")
+        .keyValue("state", "streaming")
+        .keyValue("device", "MacBook Pro Speakers")
+        .key("stream").beginObject()
+            .keyValue("sampleRate", uint32_t{48000})
+            .keyValue("channels", uint16_t{2})
+            .keyValue("bufferSize", uint32_t{512})
+        .endObject()
+        .key("transport").beginObject()
+            .keyValue("name", "tcp-pcm")
+            .keyValue("peerAddress", "192.168.1.50")
+            .keyValue("peerPort", uint16_t{54321})
+            .keyValue("bytesSent", uint64_t{0})
+            .keyValue("bytesReceived", uint64_t{5368709120})
+            .keyValue("packetsLost", uint64_t{0})
+        .endObject()
+    .endObject();
+}
+
+// Representative /devices payload
+template<typename Builder>
+void writeDevicesJson(Builder& json, const std::vector<std::string>& names) {
+    json.beginObject().key("inputs").beginArray();
+    for (const auto& name : names) {
+        json.beginObject()
+            .keyValue("name", name)
+            .keyValue("type", "ALSA")
+            .keyValue("channels", 2)
+        .endObject();
+    }
+    json.endArray().key("outputs").beginArray();
+    for (const auto& name : names) {
+        json.beginObject()
+            .keyValue("name", name)
+            .keyValue("type", "ALSA")
+            .keyValue("channels", 2)
+        .endObject();
+    }
+    json.endArray().endObject();
+}
+
+void benchRingBuffer(BenchHarness& harness) {
+    const int channels = 2;
+    for (int frames : {32, 512, 4096}) {
+        size_t count = static_cast<size_t>(frames * channels);
+        audioserver::RingBuffer<float> ring(48000 * channels);
+        std::vector<float> in(count, 0.5f);
+        std::vector<float> out(count);
+
+        harness.run("RingBuffer<float>/write+read/" + std::to_string(frames) + "x2",
+                    count * sizeof(float), [&]() {
+            ring.write(in.data(), count);
+            ring.read(out.data(), count);
+            clobberMemory();
+        });
+    }
+}
+
+void benchProtocol(BenchHarness& harness) {
+    audioserver::ChunkHeader chunk;
+    chunk.size = 4096;
+    chunk.sequence = 12345;
+    harness.run("ChunkHeader/serialize", audioserver::CHUNK_HEADER_SIZE, [&]() {
+        auto data = chunk.serialize();
+        doNotOptimize(data.data());
+    });
+
+    uint8_t chunkOut[audioserver::CHUNK_HEADER_SIZE];
+    harness.run("ChunkHeader/serializeInto", audioserver::CHUNK_HEADER_SIZE, [&]() {
+        chunk.serializeInto(chunkOut);
+        doNotOptimize(chunkOut);
+    });
+
+    auto chunkBytes = chunk.serialize();
+    harness.run("ChunkHeader/deserialize", audioserver::CHUNK_HEADER_SIZE, [&]() {
+        audioserver::ChunkHeader out;
+        audioserver::ChunkHeader::deserialize(chunkBytes.data(), chunkBytes.size(), out);
+        doNotOptimize(out);
+    });
+
+    audioserver::StreamHeader stream;
+    harness.run("StreamHeader/serialize", audioserver::STREAM_HEADER_SIZE, [&]() {
+        auto data = stream.serialize();
+        doNotOptimize(data.data());
+    });
+
+    auto streamBytes = stream.serialize();
+    harness.run("StreamHeader/deserialize", audioserver::STREAM_HEADER_SIZE, [&]() {
+        audioserver::StreamHeader out;
+        audioserver::StreamHeader::deserialize(streamBytes.data(), streamBytes.size(), out);
+        doNotOptimize(out);
+    });
+}
+
+void benchInterleave(BenchHarness& harness) {
+    const int frames = 512;
+    for (int channels : {1, 2, 8, 64}) {
+        PlanarBuffer planar(channels, frames);
+        std::vector<float> interleaved(static_cast<size_t>(channels * frames), 0.25f);
+        size_t bytes = interleaved.size() * sizeof(float);
+        std::string shape = std::to_string(frames) + "x" + std::to_string(channels);
+
+        harness.run("interleave/" + shape, bytes, [&]() {
+            audioserver::interleave(planar.ptrs.data(), channels, frames, interleaved.data());
+            clobberMemory();
+        });
+
+        harness.run("deinterleave/" + shape, bytes, [&]() {
+            audioserver::deinterleave(interleaved.data(), channels, frames, planar.ptrs.data());
+            clobberMemory();
+        });
+    }
+}
+
+void benchToneGenerator(BenchHarness& harness) {
+    const int frames = 512;
+    for (int channels : {2, 8}) {
+        PlanarBuffer planar(channels, frames);
+        audioserver::ToneGenerator tone(48000, 440, static_cast<uint16_t>(channels));
+        harness.run("ToneGenerator/generate/" + std::to_string(frames) + "x" + std::to_string(channels),
+                    static_cast<size_t>(channels * frames) * sizeof(float), [&]() {
+            tone.generate(planar.ptrs.data(), channels, frames);
+            clobberMemory();
+        });
+    }
+}
+
+void benchLevelMeter(BenchHarness& harness) {
+    const int frames = 512;
+    for (int channels : {2, 64}) {
+        PlanarBuffer planar(channels, frames);
+        static audioserver::LevelMeter meter;
+        meter.prepare(48000.0);
+        harness.run("LevelMeter/process/" + std::to_string(frames) + "x" + std::to_string(channels),
+                    static_cast<size_t>(channels * frames) * sizeof(float), [&]() {
+            meter.process(planar.ptrs.data(), channels, frames);
+        });
+    }
+}
+
+// What /listen adds to the audio callback, idle and with listeners attached
+void benchListenTap(BenchHarness& harness) {
+    const int frames = 512;
+    const int channels = 2;
+    PlanarBuffer planar(channels, frames);
+    std::vector<float> drained(static_cast<size_t>(channels * frames));
+
+    for (size_t listeners : {size_t{0}, size_t{4}}) {
+        static audioserver::ListenTap tap;
+        tap.prepare(48000.0);
+        tap.push(planar.ptrs.data(), channels, frames);  // Establishes the format
+
+        std::vector<std::shared_ptr<audioserver::ListenTap::Listener>> subscribed;
+        for (size_t i = 0; i < listeners; ++i) {
+            subscribed.push_back(tap.subscribe());
+        }
+
+        harness.run("ListenTap/push/" + std::to_string(frames) + "x" + std::to_string(channels)
+                        + "/" + std::to_string(listeners) + "-listeners",
+                    static_cast<size_t>(channels * frames) * sizeof(float), [&]() {
+            tap.push(planar.ptrs.data(), channels, frames);
+            for (auto& listener : subscribed) {
+                tap.read(*listener, drained.data(), static_cast<size_t>(frames));  // Keeps the queues from filling
+            }
+        });
+
+        for (auto& listener : subscribed) {
+            tap.unsubscribe(listener);
+        }
+    }
+}
+
+// The receive thread's cost when the device runs at another rate than the stream
+void benchResampler(BenchHarness& harness) {
+    const int frames = 512;
+    const int channels = 2;
+    std::vector<float> input(static_cast<size_t>(channels * frames));
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<float>(i % 97) / 97.0f - 0.5f;
+    }
+
+    for (auto rates : {std::make_pair(44100u, 48000u), std::make_pair(96000u, 48000u)}) {
+        audioserver::Resampler resampler(rates.first, rates.second, channels);
+        std::vector<float> output(resampler.maxOutputFrames(frames) * static_cast<size_t>(channels));
+
+        harness.run("Resampler/" + std::to_string(rates.first) + "-" + std::to_string(rates.second)
+                        + "/" + std::to_string(frames) + "x" + std::to_string(channels),
+                    input.size() * sizeof(float), [&]() {
+            doNotOptimize(resampler.process(input.data(), frames, output.data()));
+            clobberMemory();
+        });
+    }
+}
+
+// An 8 channel stream patched twice into a 32 output interface, plus a
+// stereo downmix of it, as the receiver's callback runs it
+void benchChannelRouter(BenchHarness& harness) {
+    const int frames = 512;
+    const int networkChannels = 8;
+    const int deviceChannels = 32;
+    PlanarBuffer network(networkChannels, frames);
+    PlanarBuffer device(deviceChannels, frames);
+
+    audioserver::ChannelRouting routing;
+    std::string error;
+    audioserver::ChannelRouting::parse("0-7:0-7,0-7:16-23,0:30@-3,2:30@-6,4:30@-6,6:30@-6,"
+                                       "1:31@-3,3:31@-6,5:31@-6,7:31@-6", routing, error);
+    std::vector<int> active;
+    for (int ch = 0; ch < deviceChannels; ++ch) {
+        active.push_back(ch);
+    }
+    audioserver::ChannelRouter::Summary summary;
+    auto plan = audioserver::ChannelRouter::compile(routing, false, networkChannels, active, summary);
+
+    harness.run("ChannelRouter/route/" + std::to_string(frames) + "/" + std::to_string(networkChannels)
+                    + "-to-" + std::to_string(deviceChannels),
+                static_cast<size_t>(deviceChannels * frames) * sizeof(float), [&]() {
+        plan->route(network.ptrs.data(), networkChannels, 0, device.ptrs.data(), deviceChannels, 0, frames);
+        clobberMemory();
+    });
+}
+
+void benchHistogram(BenchHarness& harness) {
+    static audioserver::Histogram histogram;
+    uint64_t value = 1;
+    harness.run("Histogram/record", 0, [&]() {
+        histogram.record(value);
+        value = (value * 2654435761u) & 0xFFFFFF;  // Spread across buckets
+    });
+
+    harness.run("Histogram/snapshot+p99", 0, [&]() {
+        auto snap = histogram.snapshot();
+        doNotOptimize(snap.percentile(0.99));
+    });
+}
+
+// The current builder, the same builder reused across documents, and the
+// previous stringstream implementation on identical payloads
+void benchJson(BenchHarness& harness) {
+    using audioserver::JsonBuilder;
+    using audioserver::bench::LegacyJsonBuilder;
+
+    std::vector<std::string> deviceNames;
+    for (int i = 0; i < 8; ++i) {
+        deviceNames.push_back("USB Audio Interface \"Rack\" " + std::to_string(i));
+    }
+
+    JsonBuilder sizing;
+    writeStatusJson(sizing);
+    size_t statusBytes = sizing.str().size();
+    sizing.clear();
+    writeDevicesJson(sizing, deviceNames);
+    size_t devicesBytes = sizing.str().size();
+
+    harness.run("JsonBuilder/status", statusBytes, [&]() {
+        JsonBuilder json;
+        writeStatusJson(json);
+        auto result = json.build();
+        doNotOptimize(result.data());
+    });
+
+    JsonBuilder reused;
+    harness.run("JsonBuilder/status/reused", statusBytes, [&]() {
+        reused.clear();
+        writeStatusJson(reused);
+        doNotOptimize(reused.str().data());
+    });
+
+    harness.run("LegacyJsonBuilder/status", statusBytes, [&]() {
+        LegacyJsonBuilder json;
+        writeStatusJson(json);
+        auto result = json.build();
+        doNotOptimize(result.data());
+    });
+
+    harness.run("JsonBuilder/devices/8", devicesBytes, [&]() {
+        JsonBuilder json;
+        writeDevicesJson(json, deviceNames);
+        auto result = json.build();
+        doNotOptimize(result.data());
+    });
+
+    harness.run("JsonBuilder/devices/8/reused", devicesBytes, [&]() {
+        reused.clear();
+        writeDevicesJson(reused, deviceNames);
+        doNotOptimize(reused.str().data());
+    });
+
+    harness.run("LegacyJsonBuilder/devices/8", devicesBytes, [&]() {
+        LegacyJsonBuilder json;
+        writeDevicesJson(json, deviceNames);
+        auto result = json.build();
+        doNotOptimize(result.data());
+    });
+}
+
+void printUsage() {
+    std::cout << R"(audio-server-microbench - Hot-path microbenchmarks
+
+USAGE:
+    audio-server-microbench [OPTIONS]
+
+OPTIONS:
+    --filter <TEXT>     Only run benchmarks whose name contains TEXT
+    --json <FILE>       Also write results as JSON to FILE
+    --help, -h          Show this help message
+)";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string jsonFile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else {
+            std::cerr << "Error: Unknown argument: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    BenchHarness harness(filter);
+    benchRingBuffer(harness);
+    benchProtocol(harness);
+    benchInterleave(harness);
+    benchToneGenerator(harness);
+    benchLevelMeter(harness);
+    benchListenTap(harness);
+    benchResampler(harness);
+    benchChannelRouter(harness);
+    benchHistogram(harness);
+    benchJson(harness);
+
+    if (!jsonFile.empty()) {
+        std::ofstream out(jsonFile);
+        if (!out) {
+            std::cerr << "Failed to write " << jsonFile << "\n";
+            return 1;
+        }
+        out << harness.toJson() << "\n";
+    }
+
+    return 0;
+}
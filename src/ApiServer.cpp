@@ -1,14 +1,429 @@
 #include "ApiServer.h"
 #include "JsonBuilder.h"
+#include "JsonReader.h"
+#include "MetricsBuilder.h"
+#include "ThreadPolicy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+
+#ifndef AUDIO_SERVER_VERSION
+#define AUDIO_SERVER_VERSION "unknown"
+#endif
 
 namespace audioserver {
 
-ApiServer::ApiServer(AudioEngine& audioEngine, TransportBackend& transport, Config& config)
-    : audioEngine_(audioEngine)
-    , transport_(transport)
-    , config_(config)
+namespace {
+    // Each open /events or /listen stream holds a worker, so leave room for
+    // regular requests
+    constexpr size_t HTTP_THREADS = TelemetryHub::MAX_SUBSCRIBERS + ListenTap::MAX_LISTENERS + 8;
+
+    // Frames copied out of the time-shift buffer per write to the client
+    constexpr uint64_t TIMESHIFT_BLOCK_FRAMES = 4096;
+
+    // /listen moves at most this much per write, and checks back this often
+    // when its queue is empty
+    constexpr size_t LISTEN_BLOCK_FRAMES = 2048;
+    constexpr int LISTEN_POLL_MS = 20;
+
+    enum class ListenFormat { Wav16, WavFloat, Pcm16 };
+
+    // Header for a WAV of unknown length: both sizes are left at their
+    // maximum, which streaming players read as "until the connection closes"
+    std::string streamingWavHeader(uint32_t sampleRate, int channels, bool isFloat) {
+        const uint32_t bits = isFloat ? 32 : 16;
+        const uint32_t blockAlign = static_cast<uint32_t>(channels) * bits / 8;
+
+        std::string header;
+        auto le = [&header](uint32_t v, int size) {
+            for (int i = 0; i < size; ++i) {
+                header.push_back(static_cast<char>(v >> (8 * i)));
+            }
+        };
+        header += "RIFF";
+        le(UINT32_MAX, 4);
+        header += "WAVE";
+        header += "fmt ";
+        le(16, 4);
+        le(isFloat ? 3 : 1, 2);  // IEEE float or PCM
+        le(static_cast<uint32_t>(channels), 2);
+        le(sampleRate, 4);
+        le(sampleRate * blockAlign, 4);
+        le(blockAlign, 2);
+        le(bits, 2);
+        header += "data";
+        le(UINT32_MAX, 4);
+        return header;
+    }
+
+    std::string stateToString(TransportState state) {
+        switch (state) {
+            case TransportState::Disconnected: return "disconnected";
+            case TransportState::Connecting: return "connecting";
+            case TransportState::Connected: return "connected";
+            case TransportState::Streaming: return "streaming";
+            case TransportState::Error: return "error";
+        }
+        return "unknown";
+    }
+
+    // Per-channel levels in dBFS as parallel arrays
+    void appendMeters(JsonBuilder& json, const LevelMeter::Snapshot& snap) {
+        auto appendArray = [&](const char* name, float LevelMeter::ChannelLevels::*field) {
+            json.key(name).beginArray();
+            for (int ch = 0; ch < snap.numChannels; ++ch) {
+                json.value(LevelMeter::toDecibels(snap.channels[static_cast<size_t>(ch)].*field));
+            }
+            json.endArray();
+        };
+
+        appendArray("peak", &LevelMeter::ChannelLevels::peak);
+        appendArray("rms", &LevelMeter::ChannelLevels::rms);
+        appendArray("peakHold", &LevelMeter::ChannelLevels::peakHold);
+        appendArray("truePeak", &LevelMeter::ChannelLevels::truePeak);
+    }
+
+    void appendDeviceList(JsonBuilder& json, const std::vector<AudioDeviceInfo>& devices, bool input) {
+        json.beginArray();
+        for (const auto& device : devices) {
+            json.beginObject()
+                .keyValue("name", device.name)
+                .keyValue("type", device.type)
+                .keyValue("channels", input ? device.numInputChannels : device.numOutputChannels)
+                .keyValue("default", device.isDefault);
+
+            json.key("sampleRates").beginArray();
+            for (double rate : device.sampleRates) {
+                json.value(rate);
+            }
+            json.endArray();
+
+            json.key("bufferSizes").beginArray();
+            for (int size : device.bufferSizes) {
+                json.value(size);
+            }
+            json.endArray();
+
+            json.endObject();
+        }
+        json.endArray();
+    }
+
+    void appendDevices(JsonBuilder& json, const DeviceRegistry::Snapshot& snap) {
+        json.beginObject()
+            .keyValue("generation", snap.generation)
+            .keyValue("scanDurationMs", snap.scanDurationMs);
+        json.key("inputs");
+        appendDeviceList(json, snap.inputs, true);
+        json.key("outputs");
+        appendDeviceList(json, snap.outputs, false);
+        json.endObject();
+    }
+
+    // Percentile summary of a histogram, values divided by scale (e.g. ns -> us)
+    void appendHistogram(JsonBuilder& json, const std::string& name,
+                         const Histogram::Snapshot& snap, double scale) {
+        json.key(name).beginObject()
+            .keyValue("count", snap.count)
+            .keyValue("mean", snap.mean() / scale)
+            .keyValue("p50", static_cast<double>(snap.percentile(0.50)) / scale)
+            .keyValue("p90", static_cast<double>(snap.percentile(0.90)) / scale)
+            .keyValue("p99", static_cast<double>(snap.percentile(0.99)) / scale)
+            .keyValue("max", static_cast<double>(snap.max) / scale)
+        .endObject();
+    }
+
+    // Request bodies are flat JSON objects; an empty body has no fields
+    bool readBody(const httplib::Request& req, JsonReader& body, std::string& error) {
+        if (req.body.find_first_not_of(" \t\r\n") == std::string::npos) {
+            return true;
+        }
+        if (!body.parse(req.body, error)) {
+            error = "Invalid JSON body: " + error;
+            return false;
+        }
+        return true;
+    }
+
+    // Reads an unsigned field from the query string, or failing that from a
+    // flat JSON body ({"sampleRate": 48000, ...}). Absent fields keep value.
+    bool readUnsigned(const httplib::Request& req, const char* name, uint32_t& value, std::string& error) {
+        std::string text;
+        if (req.has_param(name)) {
+            text = req.get_param_value(name);
+        } else {
+            JsonReader body;
+            if (!readBody(req, body, error)) {
+                return false;
+            }
+            const auto* field = body.find(name);
+            if (!field) {
+                return true;
+            }
+            text = field->type == JsonReader::Type::Number ? field->text : std::string();
+        }
+
+        // Digits only: no sign, fraction or exponent
+        if (text.empty() || text.size() > 10 || text.find_first_not_of("0123456789") != std::string::npos
+            || std::stoull(text) > UINT32_MAX) {
+            error = std::string(name) + " must be a non-negative integer";
+            return false;
+        }
+        value = static_cast<uint32_t>(std::stoull(text));
+        return true;
+    }
+
+    // Whether a field was given at all, for fields where empty is meaningful
+    bool hasField(const httplib::Request& req, const char* name) {
+        if (req.has_param(name)) {
+            return true;
+        }
+        JsonReader body;
+        std::string error;
+        return readBody(req, body, error) && body.find(name) != nullptr;
+    }
+
+    // String counterpart of readUnsigned ({"file": "take1.wav"}); numbers and
+    // booleans come as written, null leaves value as it is
+    void readString(const httplib::Request& req, const char* name, std::string& value) {
+        if (req.has_param(name)) {
+            value = req.get_param_value(name);
+            return;
+        }
+        JsonReader body;
+        std::string error;
+        if (!readBody(req, body, error)) {
+            return;
+        }
+        const auto* field = body.find(name);
+        if (field && field->type != JsonReader::Type::Null) {
+            value = field->text;
+        }
+    }
+
+    void appendPlayback(JsonBuilder& json, const FilePlayer::Status& status) {
+        auto toMs = [&](uint64_t frames) {
+            return static_cast<double>(frames) * 1000.0 / status.sampleRate;
+        };
+        json.keyValue("path", status.path)
+            .keyValue("sampleRate", status.sampleRate)
+            .keyValue("channels", status.channels)
+            .keyValue("bitsPerSample", status.bitsPerSample)
+            .keyValue("positionMs", toMs(status.positionFrames))
+            .keyValue("durationMs", toMs(status.lengthFrames))
+            .keyValue("loop", status.loop)
+            .keyValue("finished", status.finished);
+    }
+
+    void appendTimeShift(JsonBuilder& json, const TimeShiftBuffer::Status& status) {
+        json.keyValue("enabled", status.enabled)
+            .keyValue("memoryBytes", status.memoryBytes)
+            .keyValue("sampleRate", status.sampleRate)
+            .keyValue("channels", status.channels)
+            .keyValue("capacitySeconds", status.capacitySeconds)
+            .keyValue("availableSeconds", status.availableSeconds);
+    }
+
+    void appendRouting(JsonBuilder& json, const ChannelRouting& routing, const ChannelRouter::Summary& summary) {
+        json.keyValue("routes", routing.toString())
+            .keyValue("straightThrough", routing.straightThrough());
+        json.key("matrix").beginArray();
+        for (const auto& route : routing.routes) {
+            json.beginObject()
+                .keyValue("source", route.source)
+                .keyValue("destination", route.destination)
+                .keyValue("gainDb", route.gainDb)
+            .endObject();
+        }
+        json.endArray();
+        json.key("deviceChannels").beginArray();
+        for (int channel : summary.deviceChannels) {
+            json.value(channel);
+        }
+        json.endArray();
+        json.keyValue("ignoredRoutes", summary.ignoredRoutes);
+    }
+
+    void appendSync(JsonBuilder& json, const PlayoutScheduler::Status& status) {
+        json.keyValue("enabled", status.enabled)
+            .keyValue("delayMs", static_cast<double>(status.delayNs) / 1.0e6)
+            .keyValue("timestamped", status.timestamped)
+            .keyValue("clockLocked", status.clockLocked)
+            .keyValue("clockOffsetUs", static_cast<double>(status.clockOffsetNs) / 1.0e3)
+            .keyValue("clockRttUs", static_cast<double>(status.clockRttNs) / 1.0e3)
+            .keyValue("aligned", status.aligned)
+            .keyValue("errorUs", static_cast<double>(status.errorNs) / 1.0e3)
+            .keyValue("framesSkipped", status.framesSkipped)
+            .keyValue("framesInserted", status.framesInserted)
+            .keyValue("alignFramesSkipped", status.alignFramesSkipped)
+            .keyValue("alignFramesHeld", status.alignFramesHeld)
+            .keyValue("realigns", status.realigns);
+    }
+
+    // Every receiver's sync state, and how far apart the aligned ones play.
+    // What a receiver plays at a given moment, as media time minus our clock,
+    // stays constant while it is on schedule, so receivers sampled a few
+    // callbacks apart still compare exactly. Only receivers whose senders
+    // share a clock (one sender host) are comparable.
+    void appendSyncReport(JsonBuilder& json, const std::vector<std::shared_ptr<StreamManager::Stream>>& streams) {
+        size_t aligned = 0;
+        int64_t reference = 0;
+        int64_t earliest = 0;
+        int64_t latest = 0;
+
+        json.key("receivers").beginArray();
+        for (const auto& stream : streams) {
+            if (stream->config().mode != Mode::Receiver) {
+                continue;
+            }
+            auto status = stream->controller().getPlayoutStatus();
+            json.beginObject()
+                .keyValue("name", stream->name());
+            appendSync(json, status);
+            if (status.aligned) {
+                int64_t lead = status.mediaNs - status.outputNs;
+                if (aligned++ == 0) {
+                    reference = lead;
+                }
+                // Positive when this receiver plays later than the first aligned one
+                int64_t offset = reference - lead;
+                earliest = std::min(earliest, offset);
+                latest = std::max(latest, offset);
+                json.keyValue("offsetUs", static_cast<double>(offset) / 1.0e3);
+            }
+            json.endObject();
+        }
+        json.endArray();
+
+        json.keyValue("alignedReceivers", aligned)
+            .keyValue("maxOffsetUs", static_cast<double>(latest - earliest) / 1.0e3);
+    }
+
+    void appendStream(JsonBuilder& json, StreamManager::Stream& stream) {
+        const auto& config = stream.config();
+        auto& controller = stream.controller();
+        auto streamConfig = controller.getStreamConfig();
+        auto status = stream.transport().getStatus();
+
+        json.keyValue("name", stream.name())
+            .keyValue("mode", config.mode == Mode::Sender ? "sender" : "receiver")
+            .keyValue("state", stateToString(status.state))
+            .keyValue("source", controller.sourceToString())
+            .keyValue("device", stream.audioEngine().getCurrentDeviceName())
+            .keyValue("port", config.port);
+        if (config.mode == Mode::Sender) {
+            json.keyValue("target", config.target);
+        }
+        json.keyValue("sampleRate", streamConfig.sampleRate)
+            .keyValue("channels", streamConfig.channels)
+            .keyValue("bufferSize", streamConfig.bufferSize)
+            .keyValue("routes", stream.audioEngine().getRouting().toString())
+            .keyValue("peerAddress", status.peerAddress)
+            .keyValue("bytesSent", status.bytesSent)
+            .keyValue("bytesReceived", status.bytesReceived)
+            .keyValue("packetsLost", status.packetsLost);
+        if (config.mode == Mode::Receiver) {
+            json.key("sync").beginObject();
+            appendSync(json, controller.getPlayoutStatus());
+            json.endObject();
+        }
+    }
+
+    // The fields of a telemetry "status" event for one stream
+    void appendTelemetryStatus(JsonBuilder& json, StreamManager::Stream& stream) {
+        auto transportStatus = stream.transport().getStatus();
+        auto streamConfig = stream.controller().getStreamConfig();
+
+        json.keyValue("mode", stream.config().mode == Mode::Sender ? "sender" : "receiver")
+            .keyValue("state", stateToString(transportStatus.state))
+            .keyValue("device", stream.audioEngine().getCurrentDeviceName())
+            .key("stream").beginObject()
+                .keyValue("sampleRate", streamConfig.sampleRate)
+                .keyValue("channels", streamConfig.channels)
+                .keyValue("bufferSize", streamConfig.bufferSize)
+            .endObject()
+            .keyValue("peerAddress", transportStatus.peerAddress)
+            .keyValue("peerPort", transportStatus.peerPort);
+
+        if (!transportStatus.errorMessage.empty()) {
+            json.keyValue("error", transportStatus.errorMessage);
+        }
+    }
+
+    // The fields of a telemetry "stats" event for one stream. Runs every
+    // tick, subscribers or not, so never on ringMutex_.
+    void appendTelemetryStats(JsonBuilder& json, StreamManager::Stream& stream) {
+        auto stats = stream.transport().getStats();
+        const auto& audio = stream.audioEngine().getMetrics();
+        auto load = audio.dspLoad.snapshot();
+        double loadScale = static_cast<double>(AudioMetrics::FULL_LOAD) / 100.0;
+
+        json.key("transport").beginObject()
+                .keyValue("bytesSent", stats.bytesSent)
+                .keyValue("bytesReceived", stats.bytesReceived)
+                .keyValue("chunksSent", stats.chunksSent)
+                .keyValue("chunksDropped", stats.chunksDropped)
+                .keyValue("chunksReceived", stats.chunksReceived)
+                .keyValue("sequenceGaps", stats.sequenceGaps)
+                .keyValue("connections", stats.connections)
+                .keyValue("reconnects", stats.reconnects)
+                .keyValue("downtimeMs", stats.downtimeMs)
+            .endObject()
+            .key("audio").beginObject()
+                .keyValue("callbacks", audio.callbacks.load())
+                .keyValue("underruns", audio.underruns.load())
+                .keyValue("overruns", audio.overruns.load())
+                .keyValue("dspLoadP99", static_cast<double>(load.percentile(0.99)) / loadScale)
+                .keyValue("dspLoadMax", static_cast<double>(load.max) / loadScale)
+            .endObject();
+
+        json.key("meters").beginObject();
+        appendMeters(json, stream.audioEngine().getLevelMeter().snapshot());
+        json.endObject();
+
+        if (auto jitter = stream.controller().getJitterFill(); jitter.capacity > 0) {
+            json.key("jitterBuffer").beginObject()
+                .keyValue("samples", jitter.samples)
+                .keyValue("capacity", jitter.capacity)
+            .endObject();
+        }
+    }
+
+    void appendRecording(JsonBuilder& json, const Recorder::Status& status) {
+        double seconds = status.sampleRate > 0.0
+            ? static_cast<double>(status.framesWritten) / status.sampleRate : 0.0;
+        json.keyValue("path", status.path)
+            .keyValue("format", Recorder::formatToString(status.format))
+            .keyValue("direct", status.direct)
+            .keyValue("sampleRate", status.sampleRate)
+            .keyValue("channels", status.channels)
+            .keyValue("seconds", seconds)
+            .keyValue("bytesWritten", status.bytesWritten)
+            .keyValue("framesDropped", status.framesDropped);
+        if (!status.error.empty()) {
+            json.keyValue("error", status.error);
+        }
+    }
+}
+
+ApiServer::ApiServer(StreamManager& streams)
+    : streams_(streams)
+    , primary_(streams.primary())
+    , audioEngine_(primary_->audioEngine())
+    , transport_(primary_->transport())
+    , stream_(primary_->controller())
+    , config_(primary_->config())
+    , telemetry_([this]() { return buildTelemetryStatus(); },
+                 [this]() { return buildTelemetryStats(); })
     , server_(std::make_unique<httplib::Server>()) {
+    server_->new_task_queue = [] { return new httplib::ThreadPool(HTTP_THREADS); };
     setupRoutes();
 }
 
@@ -21,22 +436,27 @@ bool ApiServer::start(uint16_t port) {
         return false;
     }
 
+    // Bind here so failures are reported synchronously; once bound, the
+    // socket is listening and early requests queue until the thread accepts
+    if (!server_->bind_to_port("0.0.0.0", port)) {
+        std::cerr << "Failed to bind API server to port " << port << std::endl;
+        return false;
+    }
+
     running_ = true;
-    serverThread_ = std::thread([this, port]() {
-        if (!server_->listen("0.0.0.0", port)) {
-            std::cerr << "Failed to start API server on port " << port << std::endl;
-            running_ = false;
-        }
+    telemetry_.start();
+    serverThread_ = std::thread([this]() {
+        // The worker pool is created on this thread and inherits its policy
+        ThreadScheduler::shared().applyToCurrentThread(ThreadRole::Api, "api");
+        server_->listen_after_bind();
     });
-
-    // Give server time to start
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    return running_;
+    return true;
 }
 
 void ApiServer::stop() {
     if (running_) {
         running_ = false;
+        telemetry_.stop();  // Releases workers blocked in /events streams
         server_->stop();
         if (serverThread_.joinable()) {
             serverThread_.join();
@@ -59,6 +479,10 @@ void ApiServer::setupRoutes() {
         handleDevices(req, res);
     });
 
+    server_->Post("/devices/rescan", [this](const httplib::Request& req, httplib::Response& res) {
+        handleDevicesRescan(req, res);
+    });
+
     server_->Post("/stream/start", [this](const httplib::Request& req, httplib::Response& res) {
         handleStreamStart(req, res);
     });
@@ -67,6 +491,74 @@ void ApiServer::setupRoutes() {
         handleStreamStop(req, res);
     });
 
+    server_->Put("/stream/config", [this](const httplib::Request& req, httplib::Response& res) {
+        handleStreamConfig(req, res);
+    });
+
+    server_->Post("/record/start", [this](const httplib::Request& req, httplib::Response& res) {
+        handleRecordStart(req, res);
+    });
+
+    server_->Post("/record/stop", [this](const httplib::Request& req, httplib::Response& res) {
+        handleRecordStop(req, res);
+    });
+
+    server_->Get("/playback", [this](const httplib::Request& req, httplib::Response& res) {
+        handlePlayback(req, res);
+    });
+
+    server_->Put("/playback", [this](const httplib::Request& req, httplib::Response& res) {
+        handlePlaybackUpdate(req, res);
+    });
+
+    server_->Get("/timeshift", [this](const httplib::Request& req, httplib::Response& res) {
+        handleTimeShift(req, res);
+    });
+
+    server_->Get("/timeshift/audio", [this](const httplib::Request& req, httplib::Response& res) {
+        handleTimeShiftAudio(req, res);
+    });
+
+    server_->Get("/listen", [this](const httplib::Request& req, httplib::Response& res) {
+        handleListen(req, res);
+    });
+
+    server_->Get("/routing", [this](const httplib::Request& req, httplib::Response& res) {
+        handleRouting(req, res);
+    });
+
+    server_->Put("/routing", [this](const httplib::Request& req, httplib::Response& res) {
+        handleRoutingUpdate(req, res);
+    });
+
+    server_->Get("/streams", [this](const httplib::Request& req, httplib::Response& res) {
+        handleStreams(req, res);
+    });
+
+    server_->Post("/streams", [this](const httplib::Request& req, httplib::Response& res) {
+        handleStreamCreate(req, res);
+    });
+
+    server_->Get(R"(/streams/([A-Za-z0-9_-]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        handleStreamGet(req, res);
+    });
+
+    server_->Put(R"(/streams/([A-Za-z0-9_-]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        handleStreamUpdate(req, res);
+    });
+
+    server_->Delete(R"(/streams/([A-Za-z0-9_-]+))", [this](const httplib::Request& req, httplib::Response& res) {
+        handleStreamDelete(req, res);
+    });
+
+    server_->Get("/sync", [this](const httplib::Request& req, httplib::Response& res) {
+        handleSync(req, res);
+    });
+
+    server_->Put("/sync", [this](const httplib::Request& req, httplib::Response& res) {
+        handleSyncUpdate(req, res);
+    });
+
     server_->Get("/transports", [this](const httplib::Request& req, httplib::Response& res) {
         handleTransports(req, res);
     });
@@ -74,6 +566,26 @@ void ApiServer::setupRoutes() {
     server_->Put("/transport", [this](const httplib::Request& req, httplib::Response& res) {
         handleTransportSwitch(req, res);
     });
+
+    server_->Get("/metrics/audio", [this](const httplib::Request& req, httplib::Response& res) {
+        handleAudioMetrics(req, res);
+    });
+
+    server_->Get("/metrics", [this](const httplib::Request& req, httplib::Response& res) {
+        handleMetrics(req, res);
+    });
+
+    server_->Get("/events", [this](const httplib::Request& req, httplib::Response& res) {
+        handleEvents(req, res);
+    });
+
+    server_->Get("/meters", [this](const httplib::Request& req, httplib::Response& res) {
+        handleMeters(req, res);
+    });
+
+    server_->Get("/spectrum", [this](const httplib::Request& req, httplib::Response& res) {
+        handleSpectrum(req, res);
+    });
 }
 
 void ApiServer::addCorsHeaders(httplib::Response& res) {
@@ -82,40 +594,125 @@ void ApiServer::addCorsHeaders(httplib::Response& res) {
     res.set_header("Access-Control-Allow-Headers", "Content-Type");
 }
 
-void ApiServer::handleStatus(const httplib::Request&, httplib::Response& res) {
-    auto transportStatus = transport_.getStatus();
-    auto streamConfig = audioEngine_.getStreamConfig();
+std::shared_ptr<StreamManager::Stream> ApiServer::selectStream(const httplib::Request& req,
+                                                               httplib::Response& res) {
+    if (!req.has_param("stream")) {
+        return primary_;
+    }
+
+    std::string name = req.get_param_value("stream");
+    auto stream = streams_.find(name);
+    if (!stream) {
+        JsonBuilder json;
+        json.beginObject()
+            .keyValue("success", false)
+            .keyValue("error", "No stream named '" + name + "'")
+            .endObject();
+        addCorsHeaders(res);
+        res.status = 404;
+        res.set_content(json.build(), "application/json");
+    }
+    return stream;
+}
 
-    std::string stateStr;
-    switch (transportStatus.state) {
-        case TransportState::Disconnected: stateStr = "disconnected"; break;
-        case TransportState::Connecting: stateStr = "connecting"; break;
-        case TransportState::Connected: stateStr = "connected"; break;
-        case TransportState::Streaming: stateStr = "streaming"; break;
-        case TransportState::Error: stateStr = "error"; break;
+void ApiServer::handleStatus(const httplib::Request& req, httplib::Response& res) {
+    auto selected = selectStream(req, res);
+    if (!selected) {
+        return;
     }
+    auto& audioEngine = selected->audioEngine();
+    auto& transport = selected->transport();
+    auto& controller = selected->controller();
 
-    std::string modeStr = (config_.mode == Mode::Sender) ? "sender" : "receiver";
+    auto transportStatus = transport.getStatus();
+    auto streamConfig = controller.getStreamConfig();
+
+    std::string stateStr = stateToString(transportStatus.state);
+    std::string modeStr = (selected->config().mode == Mode::Sender) ? "sender" : "receiver";
 
     JsonBuilder json;
     json.beginObject()
+        .keyValue("name", selected->name())
         .keyValue("mode", modeStr)
         .keyValue("state", stateStr)
-        .keyValue("device", audioEngine_.getCurrentDeviceName())
+        .keyValue("device", audioEngine.getCurrentDeviceName())
+        .keyValue("source", controller.sourceToString())
         .key("stream").beginObject()
             .keyValue("sampleRate", streamConfig.sampleRate)
             .keyValue("channels", streamConfig.channels)
             .keyValue("bufferSize", streamConfig.bufferSize)
         .endObject()
         .key("transport").beginObject()
-            .keyValue("name", transport_.getName())
+            .keyValue("name", transport.getName())
             .keyValue("peerAddress", transportStatus.peerAddress)
             .keyValue("peerPort", transportStatus.peerPort)
-            .keyValue("bytesSent", static_cast<uint32_t>(transportStatus.bytesSent))
-            .keyValue("bytesReceived", static_cast<uint32_t>(transportStatus.bytesReceived))
+            .keyValue("bytesSent", transportStatus.bytesSent)
+            .keyValue("bytesReceived", transportStatus.bytesReceived)
             .keyValue("packetsLost", transportStatus.packetsLost)
         .endObject();
 
+    auto& scheduler = ThreadScheduler::shared();
+    auto memoryLock = scheduler.memoryLock();
+    json.key("scheduling").beginObject()
+        .keyValue("memoryLocked", memoryLock.locked);
+    if (!memoryLock.error.empty()) {
+        json.keyValue("memoryError", memoryLock.error);
+    }
+    json.key("threads").beginArray();
+    for (const auto& thread : scheduler.threads()) {
+        json.beginObject()
+            .keyValue("name", thread.name)
+            .keyValue("role", roleToString(thread.role))
+            .keyValue("policy", policyToString(thread.policy))
+            .keyValue("priority", thread.priority);
+        json.key("cpus").beginArray();
+        for (int cpu : thread.cpus) {
+            json.value(cpu);
+        }
+        json.endArray();
+        if (!thread.error.empty()) {
+            json.keyValue("error", thread.error);
+        }
+        json.endObject();
+    }
+    json.endArray().endObject();
+
+    auto recording = audioEngine.getRecorder().status();
+    json.key("recording").beginObject()
+        .keyValue("active", recording.active);
+    if (recording.active) {
+        appendRecording(json, recording);
+    }
+    json.endObject();
+
+    auto& listenTap = audioEngine.getListenTap();
+    json.key("listeners").beginObject()
+        .keyValue("active", listenTap.listenerCount())
+        .keyValue("dropped", listenTap.droppedCount())
+    .endObject();
+
+    json.key("timeShift").beginObject();
+    appendTimeShift(json, audioEngine.getTimeShift().status());
+    json.endObject();
+
+    auto resampler = controller.getResampler();
+    json.key("resampler").beginObject()
+        .keyValue("active", resampler != nullptr);
+    if (resampler) {
+        auto stats = resampler->stats();
+        json.keyValue("inputRate", stats.inputRate)
+            .keyValue("outputRate", stats.outputRate)
+            .keyValue("taps", stats.taps)
+            .keyValue("cpuPercent", stats.cpuPercent);
+    }
+    json.endObject();
+
+    if (selected->config().mode == Mode::Receiver) {
+        json.key("sync").beginObject();
+        appendSync(json, controller.getPlayoutStatus());
+        json.endObject();
+    }
+
     if (!transportStatus.errorMessage.empty()) {
         json.keyValue("error", transportStatus.errorMessage);
     }
@@ -127,33 +724,29 @@ void ApiServer::handleStatus(const httplib::Request&, httplib::Response& res) {
 }
 
 void ApiServer::handleDevices(const httplib::Request&, httplib::Response& res) {
-    auto inputs = audioEngine_.getInputDevices();
-    auto outputs = audioEngine_.getOutputDevices();
-
     JsonBuilder json;
-    json.beginObject()
-        .key("inputs").beginArray();
+    appendDevices(json, *audioEngine_.getDeviceRegistry().snapshot());
 
-    for (const auto& device : inputs) {
-        json.beginObject()
-            .keyValue("name", device.name)
-            .keyValue("type", device.type)
-            .keyValue("channels", device.numInputChannels)
-        .endObject();
-    }
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
 
-    json.endArray()
-        .key("outputs").beginArray();
+void ApiServer::handleDevicesRescan(const httplib::Request&, httplib::Response& res) {
+    auto& registry = audioEngine_.getDeviceRegistry();
+    uint64_t ticket = registry.requestRescan();
 
-    for (const auto& device : outputs) {
+    JsonBuilder json;
+    if (!registry.waitForRescan(ticket, DeviceRegistry::RESCAN_TIMEOUT_MS)) {
         json.beginObject()
-            .keyValue("name", device.name)
-            .keyValue("type", device.type)
-            .keyValue("channels", device.numOutputChannels)
-        .endObject();
+            .keyValue("error", "Device rescan timed out")
+            .endObject();
+        addCorsHeaders(res);
+        res.status = 504;
+        res.set_content(json.build(), "application/json");
+        return;
     }
 
-    json.endArray().endObject();
+    appendDevices(json, *registry.snapshot());
 
     addCorsHeaders(res);
     res.set_content(json.build(), "application/json");
@@ -189,10 +782,7 @@ void ApiServer::handleStreamStart(const httplib::Request&, httplib::Response& re
         return;
     }
 
-    StreamConfig streamConfig;
-    streamConfig.sampleRate = config_.sampleRate;
-    streamConfig.channels = config_.channels;
-    streamConfig.bufferSize = config_.bufferSize;
+    StreamConfig streamConfig = stream_.getStreamConfig();
 
     bool success = false;
     if (config_.mode == Mode::Sender) {
@@ -228,33 +818,1116 @@ void ApiServer::handleStreamStop(const httplib::Request&, httplib::Response& res
     res.set_content(json.build(), "application/json");
 }
 
-void ApiServer::handleTransports(const httplib::Request&, httplib::Response& res) {
+void ApiServer::handleStreamConfig(const httplib::Request& req, httplib::Response& res) {
+    StreamConfig requested = stream_.getStreamConfig();
+    uint32_t channels = requested.channels;
+
+    std::string error;
+    bool valid = readUnsigned(req, "sampleRate", requested.sampleRate, error)
+              && readUnsigned(req, "channels", channels, error)
+              && readUnsigned(req, "bufferSize", requested.bufferSize, error);
+    if (valid && channels > StreamController::MAX_CHANNELS) {
+        error = "channels must be between 1 and " + std::to_string(StreamController::MAX_CHANNELS);
+        valid = false;
+    }
+    requested.channels = static_cast<uint16_t>(channels);
+    if (valid) {
+        valid = StreamController::validate(requested, error);
+    }
+    int status = 400;
+    if (valid && !streams_.checkDeviceChannels(StreamManager::PRIMARY_NAME, requested.channels,
+                                               audioEngine_.getRouting(), error)) {
+        status = 409;
+        valid = false;
+    }
+
+    if (!valid) {
+        JsonBuilder json;
+        json.beginObject()
+            .keyValue("success", false)
+            .keyValue("error", error)
+        .endObject();
+
+        addCorsHeaders(res);
+        res.status = status;
+        res.set_content(json.build(), "application/json");
+        return;
+    }
+
+    auto result = stream_.reconfigure(requested);
+
     JsonBuilder json;
     json.beginObject()
-        .key("transports").beginArray()
-            .beginObject()
-                .keyValue("name", "tcp-pcm")
-                .keyValue("description", "TCP with raw PCM audio")
-                .keyValue("active", true)
-            .endObject()
-        .endArray()
+        .keyValue("success", result.success);
+
+    if (!result.success) {
+        json.keyValue("error", result.error);
+    }
+
+    json.keyValue("sampleRate", result.config.sampleRate)
+        .keyValue("channels", result.config.channels)
+        .keyValue("bufferSize", result.config.bufferSize)
+        .keyValue("gapMs", result.gapMs)
     .endObject();
 
     addCorsHeaders(res);
+    res.status = result.success ? 200 : 500;
     res.set_content(json.build(), "application/json");
 }
 
-void ApiServer::handleTransportSwitch(const httplib::Request&, httplib::Response& res) {
-    // Only tcp-pcm is currently supported
+void ApiServer::handleRecordStart(const httplib::Request& req, httplib::Response& res) {
+    auto& recorder = audioEngine_.getRecorder();
+
+    Recorder::Options options;
+    std::string file;
+    std::string formatName;
+    uint32_t direct = 0;
+    std::string error;
+    int status = 400;
+
+    readString(req, "file", file);
+    readString(req, "format", formatName);
+    bool valid = readUnsigned(req, "direct", direct, error);
+
+    if (valid && !formatName.empty() && !Recorder::parseFormat(formatName, options.format)) {
+        error = "format must be wav, rf64 or caf";
+        valid = false;
+    }
+    if (valid && file.empty()) {
+        char stamp[32];
+        std::time_t now = std::time(nullptr);
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+        file = std::string("recording-") + stamp + Recorder::extension(options.format);
+    }
+    // Plain file names only: recordings never leave --record-dir
+    if (valid && (file.find_first_of("/\\") != std::string::npos || file[0] == '.')) {
+        error = "file must be a plain file name";
+        valid = false;
+    }
+    if (valid && recorder.isRecording()) {
+        error = "Already recording";
+        status = 409;
+        valid = false;
+    }
+
+    if (valid) {
+        std::error_code ec;
+        std::filesystem::create_directories(config_.recordDir, ec);
+        options.path = (std::filesystem::path(config_.recordDir) / file).string();
+        options.direct = direct != 0;
+
+        auto streamConfig = stream_.getStreamConfig();
+        valid = recorder.start(options, streamConfig.sampleRate, streamConfig.channels, error);
+        status = 500;
+    }
+
     JsonBuilder json;
     json.beginObject()
-        .keyValue("success", false)
-        .keyValue("error", "Only tcp-pcm transport is currently supported")
-    .endObject();
+        .keyValue("success", valid);
+    if (valid) {
+        appendRecording(json, recorder.status());
+    } else {
+        json.keyValue("error", error);
+    }
+    json.endObject();
 
     addCorsHeaders(res);
-    res.status = 400;
+    res.status = valid ? 200 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleRecordStop(const httplib::Request&, httplib::Response& res) {
+    auto& recorder = audioEngine_.getRecorder();
+
+    JsonBuilder json;
+    if (!recorder.isRecording()) {
+        json.beginObject()
+            .keyValue("success", false)
+            .keyValue("error", "Not recording")
+        .endObject();
+
+        addCorsHeaders(res);
+        res.status = 409;
+        res.set_content(json.build(), "application/json");
+        return;
+    }
+
+    auto finished = recorder.stop();
+
+    json.beginObject()
+        .keyValue("success", finished.error.empty());
+    appendRecording(json, finished);
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = finished.error.empty() ? 200 : 500;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handlePlayback(const httplib::Request&, httplib::Response& res) {
+    auto* player = stream_.getFilePlayer();
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", player != nullptr);
+    if (player) {
+        appendPlayback(json, player->status());
+    } else {
+        json.keyValue("error", "No file is being played");
+    }
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = player ? 200 : 404;
     res.set_content(json.build(), "application/json");
 }
 
+void ApiServer::handlePlaybackUpdate(const httplib::Request& req, httplib::Response& res) {
+    auto* player = stream_.getFilePlayer();
+
+    // Absent fields are left alone; UINT32_MAX marks "not given"
+    uint32_t positionMs = UINT32_MAX;
+    uint32_t loop = UINT32_MAX;
+    std::string error;
+    int status = 400;
+
+    bool valid = readUnsigned(req, "positionMs", positionMs, error)
+              && readUnsigned(req, "loop", loop, error);
+    if (valid && !player) {
+        error = "No file is being played";
+        status = 404;
+        valid = false;
+    }
+
+    if (valid) {
+        if (loop != UINT32_MAX) {
+            player->setLooping(loop != 0);
+        }
+        if (positionMs != UINT32_MAX) {
+            player->seek(static_cast<uint64_t>(positionMs * player->getSampleRate() / 1000.0));
+        }
+    }
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", valid);
+    if (valid) {
+        appendPlayback(json, player->status());
+    } else {
+        json.keyValue("error", error);
+    }
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = valid ? 200 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleTimeShift(const httplib::Request&, httplib::Response& res) {
+    JsonBuilder json;
+    json.beginObject();
+    appendTimeShift(json, audioEngine_.getTimeShift().status());
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleTimeShiftAudio(const httplib::Request& req, httplib::Response& res) {
+    const auto& timeShift = audioEngine_.getTimeShift();
+
+    uint32_t fromMs = 0;
+    uint32_t durationMs = 0;
+    std::string formatName;
+    Recorder::Format format = Recorder::Format::Wav;
+    std::string error;
+    int status = 400;
+
+    readString(req, "format", formatName);
+    bool valid = readUnsigned(req, "fromMs", fromMs, error)
+              && readUnsigned(req, "durationMs", durationMs, error);
+    if (valid && !formatName.empty() && !Recorder::parseFormat(formatName, format)) {
+        error = "format must be wav, rf64 or caf";
+        valid = false;
+    }
+    if (valid && !timeShift.isEnabled()) {
+        error = config_.mode == Mode::Receiver
+            ? "Time-shift buffer is disabled (--timeshift-mb 0)"
+            : "Time-shift buffer is only kept in receiver mode";
+        status = 503;
+        valid = false;
+    }
+
+    // The window is fixed now; the transfer then streams it straight out of
+    // the buffer, so it must be read faster than real time if it reaches
+    // back to the oldest audio held
+    struct Transfer {
+        TimeShiftBuffer::Window window;
+        std::vector<uint8_t> header;
+        std::vector<float> block;
+    };
+    auto transfer = std::make_shared<Transfer>();
+    if (valid && !timeShift.window(fromMs, durationMs, transfer->window)) {
+        error = "No audio captured yet";
+        status = 404;
+        valid = false;
+    }
+
+    addCorsHeaders(res);
+    if (!valid) {
+        JsonBuilder json;
+        json.beginObject()
+            .keyValue("success", false)
+            .keyValue("error", error)
+        .endObject();
+
+        res.status = status;
+        res.set_content(json.build(), "application/json");
+        return;
+    }
+
+    const auto& layout = transfer->window.layout;
+    const size_t bytesPerFrame = sizeof(float) * static_cast<size_t>(layout.channels);
+    const uint64_t dataBytes = transfer->window.frames * bytesPerFrame;
+    transfer->header = Recorder::header(format, layout.sampleRate, layout.channels, dataBytes);
+    transfer->block.resize(static_cast<size_t>(TIMESHIFT_BLOCK_FRAMES) * static_cast<size_t>(layout.channels));
+
+    res.set_header("Content-Disposition", std::string("attachment; filename=\"timeshift")
+                                          + Recorder::extension(format) + "\"");
+    res.set_content_provider(
+        static_cast<size_t>(transfer->header.size() + dataBytes),
+        format == Recorder::Format::Caf ? "audio/x-caf" : "audio/wav",
+        [&timeShift, transfer, bytesPerFrame](size_t offset, size_t, httplib::DataSink& sink) {
+            const size_t headerSize = transfer->header.size();
+            if (offset < headerSize) {
+                return sink.write(reinterpret_cast<const char*>(transfer->header.data()) + offset,
+                                  headerSize - offset);
+            }
+
+            // Offsets advance by whole blocks, so they stay frame aligned
+            uint64_t frame = (offset - headerSize) / bytesPerFrame;
+            uint64_t frames = std::min<uint64_t>(TIMESHIFT_BLOCK_FRAMES, transfer->window.frames - frame);
+            if (!timeShift.read(transfer->window, frame, frames, transfer->block.data())) {
+                std::cerr << "Time-shift transfer aborted: audio was overwritten before it was sent" << std::endl;
+                return false;
+            }
+            return sink.write(reinterpret_cast<const char*>(transfer->block.data()),
+                              static_cast<size_t>(frames) * bytesPerFrame);
+        });
+}
+
+void ApiServer::handleListen(const httplib::Request& req, httplib::Response& res) {
+    auto& tap = audioEngine_.getListenTap();
+
+    std::string formatName;
+    uint32_t channels = 0;
+    ListenFormat format = ListenFormat::Wav16;
+    std::string error;
+    int status = 400;
+
+    readString(req, "format", formatName);
+    bool valid = readUnsigned(req, "channels", channels, error);
+    if (valid && !formatName.empty()) {
+        if (formatName == "wav") {
+            format = ListenFormat::Wav16;
+        } else if (formatName == "float") {
+            format = ListenFormat::WavFloat;
+        } else if (formatName == "pcm") {
+            format = ListenFormat::Pcm16;
+        } else {
+            error = "format must be wav, float or pcm";
+            valid = false;
+        }
+    }
+
+    std::shared_ptr<ListenTap::Listener> listener;
+    if (valid) {
+        listener = tap.subscribe();
+        if (!listener) {
+            error = tap.listenerCount() >= ListenTap::MAX_LISTENERS
+                ? "Too many listeners" : "No audio is flowing yet";
+            status = 503;
+            valid = false;
+        }
+    }
+
+    addCorsHeaders(res);
+    if (!valid) {
+        JsonBuilder json;
+        json.beginObject()
+            .keyValue("success", false)
+            .keyValue("error", error)
+        .endObject();
+
+        res.status = status;
+        res.set_content(json.build(), "application/json");
+        return;
+    }
+
+    // Keep the first `channels` of each frame (all by default)
+    struct Stream {
+        std::shared_ptr<ListenTap::Listener> listener;
+        int channels = 0;
+        ListenFormat format = ListenFormat::Wav16;
+        std::string pending;  // Header, then each converted block
+        std::vector<float> block;
+    };
+    auto stream = std::make_shared<Stream>();
+    stream->listener = listener;
+    stream->channels = channels == 0 ? listener->channels()
+                                     : std::min(static_cast<int>(channels), listener->channels());
+    stream->format = format;
+    stream->block.resize(LISTEN_BLOCK_FRAMES * static_cast<size_t>(listener->channels()));
+
+    const auto sampleRate = static_cast<uint32_t>(listener->sampleRate());
+    const char* contentType = "audio/wav";
+    if (format == ListenFormat::Pcm16) {
+        contentType = "application/octet-stream";
+        res.set_header("X-Sample-Rate", std::to_string(sampleRate));
+        res.set_header("X-Channels", std::to_string(stream->channels));
+    } else {
+        stream->pending = streamingWavHeader(sampleRate, stream->channels, format == ListenFormat::WavFloat);
+    }
+
+    res.set_header("Cache-Control", "no-cache");
+    res.set_chunked_content_provider(contentType,
+        [this, &tap, stream](size_t, httplib::DataSink& sink) {
+            if (!stream->pending.empty()) {
+                bool ok = sink.write(stream->pending.data(), stream->pending.size());
+                stream->pending.clear();
+                return ok;
+            }
+
+            auto& listener = *stream->listener;
+            size_t frames = tap.read(listener, stream->block.data(), LISTEN_BLOCK_FRAMES);
+            if (frames == 0) {
+                // Dropped for falling behind, the format changed, or shutting down
+                if (listener.dropped() || !running_) {
+                    sink.done();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(LISTEN_POLL_MS));
+                }
+                return true;
+            }
+
+            const auto stride = static_cast<size_t>(listener.channels());
+            const auto channels = static_cast<size_t>(stream->channels);
+            const bool isFloat = stream->format == ListenFormat::WavFloat;
+            stream->pending.resize(frames * channels * (isFloat ? sizeof(float) : sizeof(int16_t)));
+            char* out = stream->pending.data();
+            for (size_t i = 0; i < frames; ++i) {
+                const float* frame = stream->block.data() + i * stride;
+                if (isFloat) {
+                    std::memcpy(out, frame, channels * sizeof(float));
+                    out += channels * sizeof(float);
+                    continue;
+                }
+                for (size_t ch = 0; ch < channels; ++ch) {
+                    auto sample = static_cast<int16_t>(std::lround(std::clamp(frame[ch], -1.0f, 1.0f) * 32767.0f));
+                    std::memcpy(out, &sample, sizeof(sample));
+                    out += sizeof(sample);
+                }
+            }
+
+            bool ok = sink.write(stream->pending.data(), stream->pending.size());
+            stream->pending.clear();
+            return ok;
+        },
+        [&tap, stream](bool) {
+            tap.unsubscribe(stream->listener);
+        });
+}
+
+void ApiServer::handleRouting(const httplib::Request&, httplib::Response& res) {
+    JsonBuilder json;
+    json.beginObject();
+    appendRouting(json, audioEngine_.getRouting(), audioEngine_.getRoutingSummary());
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleRoutingUpdate(const httplib::Request& req, httplib::Response& res) {
+    std::string spec;
+    std::string error;
+    int status = 400;
+
+    // An empty spec is valid (straight through), so presence is checked apart
+    JsonReader body;
+    bool valid = readBody(req, body, error);
+    if (valid && !hasField(req, "routes")) {
+        error = "routes is required";
+        valid = false;
+    }
+    ChannelRouting routing;
+    if (valid) {
+        readString(req, "routes", spec);
+        valid = ChannelRouting::parse(spec, routing, error);
+    }
+    if (valid && !streams_.checkDeviceChannels(StreamManager::PRIMARY_NAME, stream_.getStreamConfig().channels,
+                                               routing, error)) {
+        status = 409;
+        valid = false;
+    }
+    if (valid && !stream_.setRouting(routing, error)) {
+        status = stream_.getSource() == StreamController::Source::Device ? 500 : 409;
+        valid = false;
+    }
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", valid);
+    if (!valid) {
+        json.keyValue("error", error);
+    }
+    appendRouting(json, audioEngine_.getRouting(), audioEngine_.getRoutingSummary());
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = valid ? 200 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleStreams(const httplib::Request&, httplib::Response& res) {
+    JsonBuilder json;
+    json.beginObject();
+    json.key("streams").beginArray();
+    for (const auto& stream : streams_.list()) {
+        json.beginObject();
+        appendStream(json, *stream);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleStreamCreate(const httplib::Request& req, httplib::Response& res) {
+    std::string name;
+    readString(req, "name", name);
+
+    // Anything not given comes from this process's own settings, minus the
+    // ones that must not be shared (see StreamManager::streamDefaults)
+    Config config = StreamManager::streamDefaults(config_);
+    std::string error;
+    int status = 400;
+    JsonReader body;
+    bool valid = readBody(req, body, error);
+
+    for (const char* key : {"mode", "device", "target", "routes", "playFile"}) {
+        if (valid && hasField(req, key)) {
+            std::string value;
+            readString(req, key, value);
+            valid = StreamManager::setField(config, key, value, error);
+        }
+    }
+    for (const char* key : {"port", "sampleRate", "channels", "bufferSize", "testTone", "testToneFreq", "loop",
+                            "syncDelayMs"}) {
+        uint32_t value = UINT32_MAX;
+        if (valid && !readUnsigned(req, key, value, error)) {
+            valid = false;
+        }
+        if (valid && value != UINT32_MAX) {
+            valid = StreamManager::setField(config, key, std::to_string(value), error);
+        }
+    }
+
+    if (valid && streams_.find(name)) {
+        error = "A stream named '" + name + "' already exists";
+        status = 409;
+        valid = false;
+    }
+
+    if (valid) {
+        valid = streams_.validate(name, config, error);
+    }
+
+    std::shared_ptr<StreamManager::Stream> stream;
+    if (valid) {
+        stream = streams_.add(name, config, error);
+        if (!stream) {
+            status = 500;
+            valid = false;
+        }
+    }
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", valid);
+    if (valid) {
+        appendStream(json, *stream);
+    } else {
+        json.keyValue("error", error);
+    }
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = valid ? 201 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleStreamGet(const httplib::Request& req, httplib::Response& res) {
+    auto stream = streams_.find(req.matches[1]);
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", stream != nullptr);
+    if (stream) {
+        appendStream(json, *stream);
+    } else {
+        json.keyValue("error", "No stream named '" + std::string(req.matches[1]) + "'");
+    }
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = stream ? 200 : 404;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleStreamUpdate(const httplib::Request& req, httplib::Response& res) {
+    auto stream = streams_.find(req.matches[1]);
+    std::string error;
+    int status = 400;
+    bool valid = stream != nullptr;
+    if (!valid) {
+        error = "No stream named '" + std::string(req.matches[1]) + "'";
+        status = 404;
+    }
+
+    // Same fields as PUT /stream/config, PUT /routing and PUT /sync, for any stream
+    StreamConfig requested;
+    uint32_t channels = 0;
+    uint32_t syncDelayMs = UINT32_MAX;
+    ChannelRouting routing;
+    bool routesGiven = false;
+    if (valid) {
+        requested = stream->controller().getStreamConfig();
+        channels = requested.channels;
+        valid = readUnsigned(req, "sampleRate", requested.sampleRate, error)
+             && readUnsigned(req, "channels", channels, error)
+             && readUnsigned(req, "bufferSize", requested.bufferSize, error)
+             && readUnsigned(req, "syncDelayMs", syncDelayMs, error);
+    }
+    if (valid && channels > StreamController::MAX_CHANNELS) {
+        error = "channels must be between 1 and " + std::to_string(StreamController::MAX_CHANNELS);
+        valid = false;
+    }
+    requested.channels = static_cast<uint16_t>(channels);
+    if (valid) {
+        valid = StreamController::validate(requested, error);
+    }
+    if (valid && hasField(req, "routes")) {
+        std::string spec;
+        readString(req, "routes", spec);
+        routesGiven = true;
+        valid = ChannelRouting::parse(spec, routing, error);
+    }
+    if (valid && !streams_.checkDeviceChannels(stream->name(), requested.channels,
+                                               routesGiven ? routing : stream->audioEngine().getRouting(), error)) {
+        status = 409;
+        valid = false;
+    }
+
+    StreamController::ReconfigureResult result;
+    if (valid) {
+        auto& controller = stream->controller();
+        auto current = controller.getStreamConfig();
+        result.success = true;
+        status = 500;
+        if (requested.sampleRate != current.sampleRate || requested.channels != current.channels
+            || requested.bufferSize != current.bufferSize) {
+            result = controller.reconfigure(requested);
+            error = result.error;
+        }
+        if (result.success && routesGiven && !controller.setRouting(routing, error)) {
+            result.success = false;
+            status = controller.getSource() == StreamController::Source::Device ? 500 : 409;
+        }
+        if (result.success && syncDelayMs != UINT32_MAX && !controller.setSyncDelay(syncDelayMs, error)) {
+            result.success = false;
+            status = 400;
+        }
+        valid = result.success;
+    }
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", valid);
+    if (!valid) {
+        json.keyValue("error", error);
+    }
+    if (stream) {
+        appendStream(json, *stream);
+        json.keyValue("gapMs", result.gapMs);
+    }
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = valid ? 200 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleStreamDelete(const httplib::Request& req, httplib::Response& res) {
+    std::string name = req.matches[1];
+    std::string error;
+    int status = 404;
+
+    bool valid = streams_.find(name) != nullptr;
+    if (!valid) {
+        error = "No stream named '" + name + "'";
+    } else if (streams_.primary() && streams_.primary()->name() == name) {
+        error = "The primary stream cannot be removed";
+        status = 409;
+        valid = false;
+    } else {
+        valid = streams_.remove(name, error);
+    }
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", valid);
+    if (!valid) {
+        json.keyValue("error", error);
+    }
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = valid ? 200 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleSync(const httplib::Request&, httplib::Response& res) {
+    JsonBuilder json;
+    json.beginObject();
+    appendSyncReport(json, streams_.list());
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleSyncUpdate(const httplib::Request& req, httplib::Response& res) {
+    uint32_t delayMs = UINT32_MAX;
+    std::string error;
+    int status = 400;
+
+    bool valid = readUnsigned(req, "delayMs", delayMs, error);
+    if (valid && delayMs == UINT32_MAX) {
+        error = "delayMs is required";
+        valid = false;
+    }
+    if (valid && delayMs > static_cast<uint32_t>(PlayoutScheduler::MAX_DELAY_MS)) {
+        error = "delayMs must be at most " + std::to_string(PlayoutScheduler::MAX_DELAY_MS);
+        valid = false;
+    }
+
+    // One delay for every receiver: rooms only line up when they all wait
+    // equally long
+    auto streams = streams_.list();
+    size_t receivers = 0;
+    for (const auto& stream : streams) {
+        if (valid && stream->config().mode == Mode::Receiver) {
+            valid = stream->controller().setSyncDelay(delayMs, error);
+            receivers++;
+        }
+    }
+    if (valid && receivers == 0) {
+        error = "No receiver streams";
+        status = 409;
+        valid = false;
+    }
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", valid);
+    if (!valid) {
+        json.keyValue("error", error);
+    }
+    appendSyncReport(json, streams);
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.status = valid ? 200 : status;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleTransports(const httplib::Request&, httplib::Response& res) {
+    JsonBuilder json;
+    json.beginObject()
+        .key("transports").beginArray()
+            .beginObject()
+                .keyValue("name", "tcp-pcm")
+                .keyValue("description", "TCP with raw PCM audio")
+                .keyValue("active", true)
+            .endObject()
+        .endArray()
+    .endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleTransportSwitch(const httplib::Request&, httplib::Response& res) {
+    // Only tcp-pcm is currently supported
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("success", false)
+        .keyValue("error", "Only tcp-pcm transport is currently supported")
+    .endObject();
+
+    addCorsHeaders(res);
+    res.status = 400;
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleAudioMetrics(const httplib::Request&, httplib::Response& res) {
+    const auto& metrics = audioEngine_.getMetrics();
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("callbacks", metrics.callbacks.load())
+        .keyValue("overloads", metrics.overloads.load())
+        .keyValue("underruns", metrics.underruns.load())
+        .keyValue("overruns", metrics.overruns.load())
+        .keyValue("deviceXruns", audioEngine_.getDeviceXRunCount());
+
+    appendHistogram(json, "callbackDurationUs", metrics.callbackDurationNs.snapshot(), 1000.0);
+    appendHistogram(json, "callbackIntervalUs", metrics.callbackIntervalNs.snapshot(), 1000.0);
+    appendHistogram(json, "dspLoadPercent", metrics.dspLoad.snapshot(),
+                    static_cast<double>(AudioMetrics::FULL_LOAD) / 100.0);
+
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleMetrics(const httplib::Request&, httplib::Response& res) {
+    // Every stream's series carry a stream="<name>" label. Nothing below
+    // takes a lock the audio callback or the receive path holds: counters
+    // are atomics, status comes through SeqLocks and the jitter buffer level
+    // from getJitterFill()
+    struct Sampled {
+        std::shared_ptr<StreamManager::Stream> stream;
+        MetricsBuilder::Labels labels;
+        TransportStats stats;
+        TransportStatus status;
+        StreamConfig format;
+        StreamController::JitterFill jitter;
+        PlayoutScheduler::Status sync;
+    };
+    using Rows = std::vector<const Sampled*>;
+
+    std::vector<Sampled> sampled;
+    for (auto& stream : streams_.list()) {
+        auto& controller = stream->controller();
+        sampled.push_back({stream, {{"stream", stream->name()}}, stream->transport().getStats(),
+                           stream->transport().getStatus(), controller.getStreamConfig(),
+                           controller.getJitterFill(), controller.getPlayoutStatus()});
+    }
+    Rows all;
+    Rows receivers;
+    Rows buffered;
+    for (const auto& s : sampled) {
+        all.push_back(&s);
+        if (s.stream->config().mode == Mode::Receiver) {
+            receivers.push_back(&s);
+        }
+        if (s.jitter.capacity > 0) {
+            buffered.push_back(&s);
+        }
+    }
+
+    MetricsBuilder metrics;
+
+    // One family at a time, one sample per stream in rows
+    auto gauge = [&](const char* name, const char* help, const Rows& rows, auto value) {
+        if (rows.empty()) {
+            return;
+        }
+        metrics.family(name, "gauge", help);
+        for (const auto* s : rows) {
+            metrics.sample(name, s->labels, static_cast<double>(value(*s)));
+        }
+    };
+    auto counter = [&](const char* name, const char* help, const Rows& rows, auto value) {
+        if (rows.empty()) {
+            return;
+        }
+        metrics.family(name, "counter", help);
+        for (const auto* s : rows) {
+            metrics.counterSample(name, s->labels, value(*s));
+        }
+    };
+    auto summary = [&](const char* name, const char* help, double scale, auto histogram) {
+        metrics.family(name, "summary", help);
+        for (const auto* s : all) {
+            metrics.summarySample(name, s->labels, histogram(s->stream->audioEngine().getMetrics()).snapshot(),
+                                  scale);
+        }
+    };
+
+    metrics.family("audioserver_info", "gauge", "Server build")
+        .sample("audioserver_info", {{"version", AUDIO_SERVER_VERSION}}, uint64_t{1});
+
+    metrics.family("audioserver_stream_info", "gauge", "Stream mode and transport");
+    for (const auto* s : all) {
+        auto labels = s->labels;
+        labels.emplace_back("mode", s->stream->config().mode == Mode::Sender ? "sender" : "receiver");
+        labels.emplace_back("transport", s->stream->transport().getName());
+        metrics.sample("audioserver_stream_info", labels, uint64_t{1});
+    }
+
+    metrics.family("audioserver_transport_state", "gauge", "1 for the current transport state");
+    for (const auto* s : all) {
+        for (auto state : {TransportState::Disconnected, TransportState::Connecting, TransportState::Connected,
+                           TransportState::Streaming, TransportState::Error}) {
+            auto labels = s->labels;
+            labels.emplace_back("state", stateToString(state));
+            metrics.sample("audioserver_transport_state", labels, uint64_t{s->status.state == state});
+        }
+    }
+
+    using S = const Sampled&;
+    counter("audioserver_transport_sent_bytes", "Audio bytes sent including chunk headers", all,
+            [](S s) { return s.stats.bytesSent; });
+    counter("audioserver_transport_received_bytes", "Audio bytes received including chunk headers", all,
+            [](S s) { return s.stats.bytesReceived; });
+    counter("audioserver_transport_sent_chunks", "Audio chunks sent", all,
+            [](S s) { return s.stats.chunksSent; });
+    counter("audioserver_transport_dropped_chunks", "Audio chunks dropped by a full send buffer", all,
+            [](S s) { return s.stats.chunksDropped; });
+    counter("audioserver_transport_received_chunks", "Audio chunks received", all,
+            [](S s) { return s.stats.chunksReceived; });
+    counter("audioserver_transport_sequence_gaps", "Chunks missing from the received sequence", all,
+            [](S s) { return s.stats.sequenceGaps; });
+    counter("audioserver_transport_keepalives_sent", "Keepalive chunks sent", all,
+            [](S s) { return s.stats.keepalivesSent; });
+    counter("audioserver_transport_keepalives_received", "Keepalive chunks received", all,
+            [](S s) { return s.stats.keepalivesReceived; });
+    counter("audioserver_transport_connections", "Peer connections established", all,
+            [](S s) { return s.stats.connections; });
+    counter("audioserver_transport_reconnects", "Connections re-established after a drop", all,
+            [](S s) { return s.stats.reconnects; });
+    counter("audioserver_transport_connect_failures", "Failed connection attempts", all,
+            [](S s) { return s.stats.connectFailures; });
+    counter("audioserver_transport_downtime_seconds", "Time spent reconnecting", all,
+            [](S s) { return static_cast<double>(s.stats.downtimeMs) / 1.0e3; });
+    counter("audioserver_transport_peer_timeouts", "Silent peers dropped by the receiver", all,
+            [](S s) { return s.stats.peerTimeouts; });
+    counter("audioserver_transport_clock_exchanges", "Clock sync exchanges completed", all,
+            [](S s) { return s.stats.clockExchanges; });
+
+    metrics.family("audioserver_peer_connected", "gauge", "1 while a peer is connected");
+    for (const auto* s : all) {
+        auto labels = s->labels;
+        labels.emplace_back("peer", s->status.peerAddress.str());
+        labels.emplace_back("port", std::to_string(s->status.peerPort));
+        metrics.sample("audioserver_peer_connected", labels,
+                       uint64_t{!s->status.peerAddress.empty() && (s->status.state == TransportState::Connected
+                                                                 || s->status.state == TransportState::Streaming)});
+    }
+
+    gauge("audioserver_stream_sample_rate_hertz", "Stream sample rate", all,
+          [](S s) { return s.format.sampleRate; });
+    gauge("audioserver_stream_channels", "Stream channel count", all,
+          [](S s) { return s.format.channels; });
+    gauge("audioserver_stream_buffer_frames", "Audio device buffer size", all,
+          [](S s) { return s.format.bufferSize; });
+
+    gauge("audioserver_jitter_buffer_samples", "Samples queued in the jitter buffer", buffered,
+          [](S s) { return s.jitter.samples; });
+    gauge("audioserver_jitter_buffer_capacity_samples", "Jitter buffer capacity", buffered,
+          [](S s) { return s.jitter.capacity; });
+    gauge("audioserver_jitter_buffer_fill_ratio", "Jitter buffer fill level (0-1)", buffered,
+          [](S s) { return static_cast<double>(s.jitter.samples) / static_cast<double>(s.jitter.capacity); });
+
+    gauge("audioserver_sync_aligned", "1 while playout follows the sender's clock", receivers,
+          [](S s) { return s.sync.aligned ? 1.0 : 0.0; });
+    gauge("audioserver_sync_delay_seconds", "Presentation delay after capture", receivers,
+          [](S s) { return static_cast<double>(s.sync.delayNs) / 1.0e9; });
+    gauge("audioserver_sync_clock_offset_seconds", "Sender's clock minus ours", receivers,
+          [](S s) { return static_cast<double>(s.sync.clockOffsetNs) / 1.0e9; });
+    gauge("audioserver_sync_clock_rtt_seconds", "Round trip of the clock exchange in use", receivers,
+          [](S s) { return static_cast<double>(s.sync.clockRttNs) / 1.0e9; });
+    gauge("audioserver_sync_error_seconds", "Smoothed playout error, positive when early", receivers,
+          [](S s) { return static_cast<double>(s.sync.errorNs) / 1.0e9; });
+    counter("audioserver_sync_skipped_frames", "Frames dropped to slew towards the schedule", receivers,
+            [](S s) { return s.sync.framesSkipped; });
+    counter("audioserver_sync_inserted_frames", "Frames repeated to slew towards the schedule", receivers,
+            [](S s) { return s.sync.framesInserted; });
+    counter("audioserver_sync_align_skipped_frames", "Late frames dropped while aligning", receivers,
+            [](S s) { return s.sync.alignFramesSkipped; });
+    counter("audioserver_sync_align_held_frames", "Frames of silence held back while aligning", receivers,
+            [](S s) { return s.sync.alignFramesHeld; });
+    counter("audioserver_sync_realigns", "Times playout lost the schedule and jumped back", receivers,
+            [](S s) { return s.sync.realigns; });
+
+    auto audio = [](S s) -> const AudioMetrics& { return s.stream->audioEngine().getMetrics(); };
+    counter("audioserver_audio_callbacks", "Audio device callbacks", all,
+            [&](S s) { return audio(s).callbacks.load(); });
+    counter("audioserver_audio_overloads", "Callbacks that exceeded their buffer period", all,
+            [&](S s) { return audio(s).overloads.load(); });
+    counter("audioserver_audio_underruns", "Playback dropouts from an empty jitter buffer", all,
+            [&](S s) { return audio(s).underruns.load(); });
+    counter("audioserver_audio_overruns", "Received audio dropped by a full jitter buffer", all,
+            [&](S s) { return audio(s).overruns.load(); });
+    counter("audioserver_audio_device_xruns", "Xruns reported by the audio driver", all,
+            [](S s) { return static_cast<uint64_t>(std::max(s.stream->audioEngine().getDeviceXRunCount(), 0)); });
+
+    summary("audioserver_audio_callback_duration_seconds", "Time spent in the audio callback", 1.0e9,
+            [](const AudioMetrics& m) -> const Histogram& { return m.callbackDurationNs; });
+    summary("audioserver_audio_callback_interval_seconds", "Time between audio callbacks", 1.0e9,
+            [](const AudioMetrics& m) -> const Histogram& { return m.callbackIntervalNs; });
+    summary("audioserver_audio_dsp_load_ratio", "Callback duration relative to the buffer period",
+            static_cast<double>(AudioMetrics::FULL_LOAD),
+            [](const AudioMetrics& m) -> const Histogram& { return m.dspLoad; });
+
+    res.set_content(metrics.build(), MetricsBuilder::CONTENT_TYPE);
+}
+
+void ApiServer::handleEvents(const httplib::Request& req, httplib::Response& res) {
+    int intervalMs = 1000;
+    if (req.has_param("interval")) {
+        intervalMs = std::atoi(req.get_param_value("interval").c_str());
+    }
+
+    addCorsHeaders(res);
+
+    auto subscriber = telemetry_.subscribe(intervalMs);
+    if (!subscriber) {
+        JsonBuilder json;
+        json.beginObject()
+            .keyValue("success", false)
+            .keyValue("error", "Too many telemetry streams")
+        .endObject();
+
+        res.status = 503;
+        res.set_content(json.build(), "application/json");
+        return;
+    }
+
+    res.set_header("Cache-Control", "no-cache");
+    res.set_chunked_content_provider("text/event-stream",
+        [this, subscriber](size_t, httplib::DataSink& sink) {
+            std::string events;
+            if (!telemetry_.waitForEvents(*subscriber, events)) {
+                sink.done();
+                return true;
+            }
+            return sink.write(events.data(), events.size());
+        },
+        [this, subscriber](bool) {
+            telemetry_.unsubscribe(subscriber);
+        });
+}
+
+void ApiServer::handleMeters(const httplib::Request& req, httplib::Response& res) {
+    auto selected = selectStream(req, res);
+    if (!selected) {
+        return;
+    }
+    auto snap = selected->audioEngine().getLevelMeter().snapshot();
+
+    JsonBuilder json;
+    json.beginObject()
+        .keyValue("source", selected->config().mode == Mode::Sender ? "capture" : "playback")
+        .keyValue("channels", snap.numChannels)
+        .keyValue("version", snap.version);
+    appendMeters(json, snap);
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+void ApiServer::handleSpectrum(const httplib::Request& req, httplib::Response& res) {
+    auto selected = selectStream(req, res);
+    if (!selected) {
+        return;
+    }
+    const auto& analyzer = selected->audioEngine().getSpectrumAnalyzer();
+
+    JsonBuilder json;
+    if (!analyzer.isRunning()) {
+        json.beginObject()
+            .keyValue("error", "Spectrum analysis is disabled (--spectrum-rate 0)")
+            .endObject();
+        addCorsHeaders(res);
+        res.status = 503;
+        res.set_content(json.build(), "application/json");
+        return;
+    }
+
+    auto snap = analyzer.snapshot();
+
+    json.beginObject()
+        .keyValue("source", selected->config().mode == Mode::Sender ? "capture" : "playback")
+        .keyValue("version", snap.version)
+        .keyValue("sampleRate", snap.sampleRate)
+        .keyValue("fftSize", SpectrumAnalyzer::FFT_SIZE)
+        .keyValue("rate", analyzer.getRate())
+        .keyValue("channels", snap.numChannels);
+
+    json.key("frequencies").beginArray();
+    for (float frequency : snap.frequencies) {
+        json.value(frequency);
+    }
+    json.endArray();
+
+    json.key("magnitudes").beginArray();
+    for (const auto& bands : snap.magnitudes) {
+        json.beginArray();
+        for (float db : bands) {
+            json.value(db);
+        }
+        json.endArray();
+    }
+    json.endArray();
+
+    json.endObject();
+
+    addCorsHeaders(res);
+    res.set_content(json.build(), "application/json");
+}
+
+std::string ApiServer::buildTelemetryStatus() {
+    // The primary's fields at the top level, every stream's under "streams"
+    JsonBuilder json;
+    json.beginObject();
+    appendTelemetryStatus(json, *primary_);
+    json.key("streams").beginArray();
+    for (auto& stream : streams_.list()) {
+        json.beginObject().keyValue("name", stream->name());
+        appendTelemetryStatus(json, *stream);
+        json.endObject();
+    }
+    json.endArray().endObject();
+    return json.build();
+}
+
+std::string ApiServer::buildTelemetryStats() {
+    // Laid out as in buildTelemetryStatus()
+    JsonBuilder json;
+    json.beginObject();
+    appendTelemetryStats(json, *primary_);
+    json.key("streams").beginArray();
+    for (auto& stream : streams_.list()) {
+        json.beginObject().keyValue("name", stream->name());
+        appendTelemetryStats(json, *stream);
+        json.endObject();
+    }
+    json.endArray().endObject();
+    return json.build();
+}
+
 } // namespace audioserver
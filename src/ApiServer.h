@@ -2,6 +2,9 @@
 
 #include "Config.h"
 #include "AudioEngine.h"
+#include "StreamController.h"
+#include "StreamManager.h"
+#include "TelemetryHub.h"
 #include "transport/TransportBackend.h"
 #include <httplib.h>
 #include <memory>
@@ -12,7 +15,8 @@ namespace audioserver {
 
 class ApiServer {
 public:
-    ApiServer(AudioEngine& audioEngine, TransportBackend& transport, Config& config);
+    // The single-stream endpoints serve the manager's primary stream
+    explicit ApiServer(StreamManager& streams);
     ~ApiServer();
 
     bool start(uint16_t port);
@@ -24,18 +28,53 @@ private:
     void setupRoutes();
     void addCorsHeaders(httplib::Response& res);
 
+    // The stream named by ?stream=, or the primary without one. Answers 404
+    // and returns null for an unknown name.
+    std::shared_ptr<StreamManager::Stream> selectStream(const httplib::Request& req, httplib::Response& res);
+
     // Handlers
     void handleStatus(const httplib::Request& req, httplib::Response& res);
     void handleDevices(const httplib::Request& req, httplib::Response& res);
+    void handleDevicesRescan(const httplib::Request& req, httplib::Response& res);
     void handleStreamStart(const httplib::Request& req, httplib::Response& res);
     void handleStreamStop(const httplib::Request& req, httplib::Response& res);
+    void handleStreamConfig(const httplib::Request& req, httplib::Response& res);
+    void handleRecordStart(const httplib::Request& req, httplib::Response& res);
+    void handleRecordStop(const httplib::Request& req, httplib::Response& res);
+    void handlePlayback(const httplib::Request& req, httplib::Response& res);
+    void handlePlaybackUpdate(const httplib::Request& req, httplib::Response& res);
+    void handleTimeShift(const httplib::Request& req, httplib::Response& res);
+    void handleTimeShiftAudio(const httplib::Request& req, httplib::Response& res);
+    void handleListen(const httplib::Request& req, httplib::Response& res);
+    void handleRouting(const httplib::Request& req, httplib::Response& res);
+    void handleRoutingUpdate(const httplib::Request& req, httplib::Response& res);
+    void handleStreams(const httplib::Request& req, httplib::Response& res);
+    void handleStreamCreate(const httplib::Request& req, httplib::Response& res);
+    void handleStreamGet(const httplib::Request& req, httplib::Response& res);
+    void handleStreamUpdate(const httplib::Request& req, httplib::Response& res);
+    void handleStreamDelete(const httplib::Request& req, httplib::Response& res);
+    void handleSync(const httplib::Request& req, httplib::Response& res);
+    void handleSyncUpdate(const httplib::Request& req, httplib::Response& res);
     void handleTransports(const httplib::Request& req, httplib::Response& res);
     void handleTransportSwitch(const httplib::Request& req, httplib::Response& res);
+    void handleAudioMetrics(const httplib::Request& req, httplib::Response& res);
+    void handleMetrics(const httplib::Request& req, httplib::Response& res);
+    void handleEvents(const httplib::Request& req, httplib::Response& res);
+    void handleMeters(const httplib::Request& req, httplib::Response& res);
+    void handleSpectrum(const httplib::Request& req, httplib::Response& res);
+
+    // Telemetry payloads, rendered once per tick by the TelemetryHub producer
+    std::string buildTelemetryStatus();
+    std::string buildTelemetryStats();
 
+    StreamManager& streams_;
+    std::shared_ptr<StreamManager::Stream> primary_;
     AudioEngine& audioEngine_;
     TransportBackend& transport_;
-    Config& config_;
+    StreamController& stream_;
+    const Config& config_;
 
+    TelemetryHub telemetry_;
     std::unique_ptr<httplib::Server> server_;
     std::thread serverThread_;
     std::atomic<bool> running_{false};
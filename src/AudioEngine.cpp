@@ -1,10 +1,22 @@
 #include "AudioEngine.h"
+#include "HeadlessAudioDevice.h"
+#include "ThreadPolicy.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 namespace audioserver {
 
+namespace {
+    int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
 AudioEngine::AudioEngine()
-    : deviceManager_(std::make_unique<juce::AudioDeviceManager>()) {
+    : deviceManager_(std::make_unique<juce::AudioDeviceManager>())
+    , deviceRegistry_(*deviceManager_) {
 }
 
 AudioEngine::~AudioEngine() {
@@ -16,58 +28,63 @@ bool AudioEngine::initialize(const Config& config) {
     streamConfig_.sampleRate = config.sampleRate;
     streamConfig_.channels = config.channels;
     streamConfig_.bufferSize = config.bufferSize;
+    callbackSampleRate_ = config.sampleRate;
+    levelMeter_.prepare(config.sampleRate);
+    spectrum_.prepare(config.sampleRate);
+    spectrum_.start(config.spectrumRate);
+    listenTap_.prepare(config.sampleRate);
+    {
+        std::lock_guard<std::mutex> lock(routingMutex_);
+        routing_ = config.routing;
+    }
+
+    if (config.mode == Mode::Receiver && !timeShift_.isEnabled()) {
+        timeShift_.allocate(static_cast<uint64_t>(config.timeShiftMb) << 20);
+        timeShift_.prepare(config.sampleRate);
+    }
+
+    if (config.headless && !headless_) {
+        HeadlessOptions options;
+        options.inputFile = config.inputFile;
+        options.outputFile = config.outputFile;
+
+        // Registered before the first scan, so platform device types are never
+        // created and no real hardware is touched
+        deviceManager_->addAudioDeviceType(std::make_unique<HeadlessAudioDeviceType>(options));
+        deviceManager_->setCurrentAudioDeviceType(HeadlessAudioDeviceType::TYPE_NAME, false);
+        headless_ = true;
+    }
+
+    // The device list is scanned by the caller: synchronously for
+    // --list-devices, otherwise queued so probing hardware does not delay
+    // startup
     return true;
 }
 
 void AudioEngine::shutdown() {
     closeDevice();
+    recorder_.stop();
+    spectrum_.stop();
 }
 
 std::vector<AudioDeviceInfo> AudioEngine::getInputDevices() const {
-    std::vector<AudioDeviceInfo> devices;
-    auto& types = deviceManager_->getAvailableDeviceTypes();
-
-    for (auto* type : types) {
-        type->scanForDevices();
-        auto deviceNames = type->getDeviceNames(true);  // true = input devices
-
-        for (const auto& name : deviceNames) {
-            AudioDeviceInfo info;
-            info.name = name.toStdString();
-            info.type = type->getTypeName().toStdString();
-            info.numInputChannels = 2;  // Default assumption
-            info.numOutputChannels = 0;
-            devices.push_back(info);
-        }
-    }
-
-    return devices;
+    return deviceRegistry_.snapshot()->inputs;
 }
 
 std::vector<AudioDeviceInfo> AudioEngine::getOutputDevices() const {
-    std::vector<AudioDeviceInfo> devices;
-    auto& types = deviceManager_->getAvailableDeviceTypes();
-
-    for (auto* type : types) {
-        type->scanForDevices();
-        auto deviceNames = type->getDeviceNames(false);  // false = output devices
-
-        for (const auto& name : deviceNames) {
-            AudioDeviceInfo info;
-            info.name = name.toStdString();
-            info.type = type->getTypeName().toStdString();
-            info.numInputChannels = 0;
-            info.numOutputChannels = 2;  // Default assumption
-            devices.push_back(info);
-        }
-    }
-
-    return devices;
+    return deviceRegistry_.snapshot()->outputs;
 }
 
-bool AudioEngine::openDevice(const std::string& deviceName, Mode mode) {
+bool AudioEngine::openDevice(const std::string& requestedDeviceName, Mode mode) {
     mode_ = mode;
 
+    // The headless device is always selected by name so the configured
+    // sample rate and buffer size are applied below
+    std::string deviceName = requestedDeviceName;
+    if (headless_ && deviceName.empty()) {
+        deviceName = HeadlessAudioDeviceType::DEVICE_NAME;
+    }
+
     int numInputChannels = (mode == Mode::Sender) ? static_cast<int>(streamConfig_.channels) : 0;
     int numOutputChannels = (mode == Mode::Receiver) ? static_cast<int>(streamConfig_.channels) : 0;
 
@@ -78,8 +95,10 @@ bool AudioEngine::openDevice(const std::string& deviceName, Mode mode) {
         return false;
     }
 
-    // If a specific device is requested, configure it
-    if (!deviceName.empty()) {
+    // If a specific device (or specific channels of the default one) is
+    // requested, configure it
+    bool routed = !getRouting().straightThrough();
+    if (!deviceName.empty() || routed) {
         juce::AudioDeviceManager::AudioDeviceSetup setup;
         deviceManager_->getAudioDeviceSetup(setup);
 
@@ -87,14 +106,21 @@ bool AudioEngine::openDevice(const std::string& deviceName, Mode mode) {
         setup.bufferSize = static_cast<int>(streamConfig_.bufferSize);
 
         if (mode == Mode::Sender) {
-            setup.inputDeviceName = juce::String(deviceName);
+            if (!deviceName.empty()) {
+                setup.inputDeviceName = juce::String(deviceName);
+            }
             setup.useDefaultInputChannels = true;
             setup.inputChannels.setRange(0, streamConfig_.channels, true);
         } else {
-            setup.outputDeviceName = juce::String(deviceName);
+            if (!deviceName.empty()) {
+                setup.outputDeviceName = juce::String(deviceName);
+            }
             setup.useDefaultOutputChannels = true;
             setup.outputChannels.setRange(0, streamConfig_.channels, true);
         }
+        if (routed) {
+            selectChannels(setup);
+        }
 
         error = deviceManager_->setAudioDeviceSetup(setup, true);
         if (error.isNotEmpty()) {
@@ -105,21 +131,137 @@ bool AudioEngine::openDevice(const std::string& deviceName, Mode mode) {
 
     deviceManager_->addAudioCallback(this);
     deviceOpen_ = true;
+    deviceRegistry_.setActiveDevice(getCurrentDeviceName());
 
     auto* device = deviceManager_->getCurrentAudioDevice();
     if (device) {
         streamConfig_.sampleRate = static_cast<uint32_t>(device->getCurrentSampleRate());
         streamConfig_.bufferSize = static_cast<uint32_t>(device->getCurrentBufferSizeSamples());
     }
+    compileRouting();
+
+    return true;
+}
+
+bool AudioEngine::applyStreamConfig(const StreamConfig& config) {
+    streamConfig_.sampleRate = config.sampleRate;
+    streamConfig_.channels = config.channels;
+    streamConfig_.bufferSize = config.bufferSize;
+
+    if (!deviceOpen_) {
+        return true;
+    }
+
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager_->getAudioDeviceSetup(setup);
+
+    setup.sampleRate = config.sampleRate;
+    setup.bufferSize = static_cast<int>(config.bufferSize);
+    selectChannels(setup);
+
+    juce::String error = deviceManager_->setAudioDeviceSetup(setup, true);
+    if (error.isNotEmpty()) {
+        std::cerr << "Failed to reconfigure device: " << error.toStdString() << std::endl;
+        return false;
+    }
+
+    auto* device = deviceManager_->getCurrentAudioDevice();
+    if (device) {
+        streamConfig_.sampleRate = static_cast<uint32_t>(device->getCurrentSampleRate());
+        streamConfig_.bufferSize = static_cast<uint32_t>(device->getCurrentBufferSizeSamples());
+    }
+    compileRouting();  // The stream's channel count may have changed without a device restart
+
+    return true;
+}
+
+bool AudioEngine::setRouting(const ChannelRouting& routing, std::string& error) {
+    ChannelRouting previous;
+    {
+        std::lock_guard<std::mutex> lock(routingMutex_);
+        previous = routing_;
+        routing_ = routing;
+    }
+    if (!deviceOpen_) {
+        return true;
+    }
+
+    // Unchanged channels leave the device running; only the plan is swapped
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager_->getAudioDeviceSetup(setup);
+    selectChannels(setup);
+
+    juce::String result = deviceManager_->setAudioDeviceSetup(setup, true);
+    if (result.isNotEmpty()) {
+        error = "Device rejected the channels: " + result.toStdString();
+        std::lock_guard<std::mutex> lock(routingMutex_);
+        routing_ = previous;
+        return false;
+    }
 
+    compileRouting();
     return true;
 }
 
+ChannelRouting AudioEngine::getRouting() const {
+    std::lock_guard<std::mutex> lock(routingMutex_);
+    return routing_;
+}
+
+ChannelRouter::Summary AudioEngine::getRoutingSummary() const {
+    std::lock_guard<std::mutex> lock(routingMutex_);
+    return routingSummary_;
+}
+
+void AudioEngine::selectChannels(juce::AudioDeviceManager::AudioDeviceSetup& setup) const {
+    auto routing = getRouting();
+    juce::BigInteger channels;
+    if (routing.straightThrough()) {
+        channels.setRange(0, streamConfig_.channels, true);
+    } else {
+        for (int channel : routing.deviceChannels(mode_ == Mode::Sender)) {
+            channels.setBit(channel);
+        }
+    }
+
+    if (mode_ == Mode::Sender) {
+        setup.useDefaultInputChannels = false;
+        setup.inputChannels = channels;
+    } else {
+        setup.useDefaultOutputChannels = false;
+        setup.outputChannels = channels;
+    }
+}
+
+void AudioEngine::compileRouting() {
+    // The callback's channel arrays hold only the active channels, in order
+    std::vector<int> active;
+    if (auto* device = deviceManager_->getCurrentAudioDevice()) {
+        auto channels = mode_ == Mode::Sender ? device->getActiveInputChannels()
+                                              : device->getActiveOutputChannels();
+        for (int ch = 0; ch <= channels.getHighestBit(); ++ch) {
+            if (channels[ch]) {
+                active.push_back(ch);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(routingMutex_);
+    auto plan = ChannelRouter::compile(routing_, mode_ == Mode::Sender, streamConfig_.channels,
+                                       active, routingSummary_);
+    if (routingSummary_.ignoredRoutes > 0) {
+        std::cerr << "Ignoring " << routingSummary_.ignoredRoutes
+                  << " route(s) outside the stream's or the device's channels" << std::endl;
+    }
+    router_.setPlan(std::move(plan));
+}
+
 void AudioEngine::closeDevice() {
     if (deviceOpen_) {
         deviceManager_->removeAudioCallback(this);
         deviceManager_->closeAudioDevice();
         deviceOpen_ = false;
+        deviceRegistry_.setActiveDevice({});
     }
 }
 
@@ -147,33 +289,130 @@ void AudioEngine::setPlaybackCallback(PlaybackCallback callback) {
     playbackCallback_ = std::move(callback);
 }
 
+int AudioEngine::getDeviceXRunCount() const {
+    return deviceManager_->getXRunCount();
+}
+
 void AudioEngine::audioDeviceIOCallbackWithContext(
     const float* const* inputChannelData,
     int numInputChannels,
     float* const* outputChannelData,
     int numOutputChannels,
     int numSamples,
-    const juce::AudioIODeviceCallbackContext& /*context*/) {
+    const juce::AudioIODeviceCallbackContext& context) {
 
-    if (mode_ == Mode::Sender && audioCallback_ && numInputChannels > 0) {
-        audioCallback_(inputChannelData, numInputChannels, numSamples);
+    int64_t startNs = steadyNowNs();
+
+    // Devices may call back on a new thread after every restart
+    auto threadId = std::this_thread::get_id();
+    if (threadId != callbackThread_) {
+        callbackThread_ = threadId;
+        ThreadScheduler::shared().applyToCurrentThread(ThreadRole::Audio, "audio");
+    }
+
+    if (mode_ == Mode::Sender && numInputChannels > 0) {
+        if (auto* plan = router_.begin()) {
+            // Device inputs to the stream's channels, then on as if captured
+            float* const* network = plan->networkBuffers();
+            for (int offset = 0; offset < numSamples; offset += ChannelRouter::MAX_BLOCK_FRAMES) {
+                int frames = std::min(numSamples - offset, ChannelRouter::MAX_BLOCK_FRAMES);
+                plan->route(inputChannelData, numInputChannels, offset,
+                            network, plan->networkChannels(), 0, frames);
+                capture(network, plan->networkChannels(), frames);
+            }
+        } else {
+            capture(inputChannelData, numInputChannels, numSamples);
+        }
+        router_.end();
     }
 
     if (mode_ == Mode::Receiver && playbackCallback_ && numOutputChannels > 0) {
-        if (!playbackCallback_(outputChannelData, numOutputChannels, numSamples)) {
-            // No audio available, output silence
-            for (int ch = 0; ch < numOutputChannels; ++ch) {
-                std::fill(outputChannelData[ch], outputChannelData[ch] + numSamples, 0.0f);
+        // The headless device stamps callbacks with their steady clock
+        // deadline, free of wakeup jitter. Other hosts' timestamps are not
+        // known to be on the steady clock, so they get the callback's start.
+        int64_t blockNs = headless_ && context.hostTimeNs != nullptr
+            ? static_cast<int64_t>(*context.hostTimeNs) : startNs;
+        int64_t outputNs = blockNs + outputLatencyNs_;
+        const double nsPerFrame = 1.0e9 / callbackSampleRate_;
+
+        if (auto* plan = router_.begin()) {
+            float* const* network = plan->networkBuffers();
+            for (int offset = 0; offset < numSamples; offset += ChannelRouter::MAX_BLOCK_FRAMES) {
+                int frames = std::min(numSamples - offset, ChannelRouter::MAX_BLOCK_FRAMES);
+                play(network, plan->networkChannels(), frames,
+                     outputNs + static_cast<int64_t>(offset * nsPerFrame));
+                plan->route(network, plan->networkChannels(), 0,
+                            outputChannelData, numOutputChannels, offset, frames);
             }
+        } else {
+            play(outputChannelData, numOutputChannels, numSamples, outputNs);
         }
+        router_.end();
+    }
+
+    recordCallbackTiming(startNs, numSamples);
+}
+
+void AudioEngine::capture(const float* const* channelData, int numChannels, int numSamples) {
+    levelMeter_.process(channelData, numChannels, numSamples);
+    spectrum_.push(channelData, numChannels, numSamples);
+    recorder_.push(channelData, numChannels, numSamples);
+    listenTap_.push(channelData, numChannels, numSamples);
+    if (audioCallback_) {
+        audioCallback_(channelData, numChannels, numSamples);
     }
 }
 
+void AudioEngine::play(float* const* channelData, int numChannels, int numSamples, int64_t outputNs) {
+    if (!playbackCallback_(channelData, numChannels, numSamples, outputNs)) {
+        // No audio available, output silence
+        for (int ch = 0; ch < numChannels; ++ch) {
+            std::fill(channelData[ch], channelData[ch] + numSamples, 0.0f);
+        }
+    }
+    levelMeter_.process(channelData, numChannels, numSamples);
+    spectrum_.push(channelData, numChannels, numSamples);
+    recorder_.push(channelData, numChannels, numSamples);
+    listenTap_.push(channelData, numChannels, numSamples);
+    timeShift_.push(channelData, numChannels, numSamples);
+}
+
+void AudioEngine::recordCallbackTiming(int64_t startNs, int numSamples) {
+    int64_t durationNs = steadyNowNs() - startNs;
+    metrics_.callbackDurationNs.record(static_cast<uint64_t>(durationNs));
+
+    if (lastCallbackStartNs_ != 0) {
+        metrics_.callbackIntervalNs.record(static_cast<uint64_t>(startNs - lastCallbackStartNs_));
+    }
+    lastCallbackStartNs_ = startNs;
+
+    double periodNs = 1.0e9 * numSamples / callbackSampleRate_;
+    if (periodNs > 0.0) {
+        auto load = static_cast<uint64_t>(static_cast<double>(durationNs) * AudioMetrics::FULL_LOAD / periodNs);
+        metrics_.dspLoad.record(load);
+        if (load > AudioMetrics::FULL_LOAD) {
+            AudioMetrics::bump(metrics_.overloads);
+        }
+    }
+
+    AudioMetrics::bump(metrics_.callbacks);
+}
+
 void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device) {
     if (device) {
         streamConfig_.sampleRate = static_cast<uint32_t>(device->getCurrentSampleRate());
         streamConfig_.bufferSize = static_cast<uint32_t>(device->getCurrentBufferSizeSamples());
+        if (device->getCurrentSampleRate() > 0) {
+            callbackSampleRate_ = device->getCurrentSampleRate();
+            levelMeter_.prepare(callbackSampleRate_);
+            spectrum_.prepare(callbackSampleRate_);
+            listenTap_.prepare(callbackSampleRate_);
+            timeShift_.prepare(callbackSampleRate_);
+            outputLatencyNs_ = static_cast<int64_t>(1.0e9 * device->getOutputLatencyInSamples() / callbackSampleRate_);
+        }
     }
+    // A restarted device should not report the gap as one long interval
+    lastCallbackStartNs_ = 0;
 }
 
 void AudioEngine::audioDeviceStopped() {
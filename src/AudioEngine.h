@@ -1,27 +1,30 @@
 #pragma once
 
+#include "AudioMetrics.h"
+#include "ChannelRouter.h"
 #include "Config.h"
+#include "DeviceRegistry.h"
+#include "LevelMeter.h"
+#include "ListenTap.h"
+#include "Recorder.h"
+#include "SpectrumAnalyzer.h"
+#include "TimeShiftBuffer.h"
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace audioserver {
 
-struct AudioDeviceInfo {
-    std::string name;
-    std::string type;
-    int numInputChannels;
-    int numOutputChannels;
-    std::vector<double> sampleRates;
-    std::vector<int> bufferSizes;
-};
-
 class AudioEngine : public juce::AudioIODeviceCallback {
 public:
     using AudioCallback = std::function<void(const float* const*, int, int)>;
-    using PlaybackCallback = std::function<bool(float* const*, int, int)>;
+    // The last argument is the steady clock time the block's first frame
+    // reaches the output, output latency included
+    using PlaybackCallback = std::function<bool(float* const*, int, int, int64_t)>;
 
     AudioEngine();
     ~AudioEngine() override;
@@ -29,19 +32,56 @@ public:
     bool initialize(const Config& config);
     void shutdown();
 
+    // Served from the registry's cached scan, never touching hardware
     std::vector<AudioDeviceInfo> getInputDevices() const;
     std::vector<AudioDeviceInfo> getOutputDevices() const;
+    DeviceRegistry& getDeviceRegistry() { return deviceRegistry_; }
 
     bool openDevice(const std::string& deviceName, Mode mode);
+
+    // Applies a new rate, channel count and buffer size. An open device is
+    // reopened in place with the audio callback still registered.
+    bool applyStreamConfig(const StreamConfig& config);
     void closeDevice();
     bool isDeviceOpen() const;
 
     std::string getCurrentDeviceName() const;
     StreamConfig getStreamConfig() const;
 
+    // Which device channels are opened and how they map to the stream's.
+    // With routes in place the audio callback and playback callback see the
+    // stream's channels, and so do the meters, recorder and taps below; the
+    // device is reopened only when the set of device channels changes.
+    bool setRouting(const ChannelRouting& routing, std::string& error);
+    ChannelRouting getRouting() const;
+    ChannelRouter::Summary getRoutingSummary() const;
+
     void setAudioCallback(AudioCallback callback);
     void setPlaybackCallback(PlaybackCallback callback);
 
+    AudioMetrics& getMetrics() { return metrics_; }
+    const AudioMetrics& getMetrics() const { return metrics_; }
+    int getDeviceXRunCount() const;
+
+    // Capture levels in sender mode, playback levels in receiver mode
+    LevelMeter& getLevelMeter() { return levelMeter_; }
+    const LevelMeter& getLevelMeter() const { return levelMeter_; }
+
+    // Fed from the same signal as the level meter, analyzed on a worker thread
+    SpectrumAnalyzer& getSpectrumAnalyzer() { return spectrum_; }
+    const SpectrumAnalyzer& getSpectrumAnalyzer() const { return spectrum_; }
+
+    // Records the same signal the level meter sees while started
+    Recorder& getRecorder() { return recorder_; }
+    const Recorder& getRecorder() const { return recorder_; }
+
+    // Live copy of the same signal for GET /listen clients
+    ListenTap& getListenTap() { return listenTap_; }
+
+    // Rolling history of the playback signal (receiver only, --timeshift-mb)
+    TimeShiftBuffer& getTimeShift() { return timeShift_; }
+    const TimeShiftBuffer& getTimeShift() const { return timeShift_; }
+
     // juce::AudioIODeviceCallback
     void audioDeviceIOCallbackWithContext(
         const float* const* inputChannelData,
@@ -55,12 +95,39 @@ public:
     void audioDeviceStopped() override;
 
 private:
+    void recordCallbackTiming(int64_t startNs, int numSamples);
+    void capture(const float* const* channelData, int numChannels, int numSamples);
+    void play(float* const* channelData, int numChannels, int numSamples, int64_t outputNs);
+    void selectChannels(juce::AudioDeviceManager::AudioDeviceSetup& setup) const;
+    void compileRouting();
+
     std::unique_ptr<juce::AudioDeviceManager> deviceManager_;
+    DeviceRegistry deviceRegistry_;
     AudioCallback audioCallback_;
     PlaybackCallback playbackCallback_;
     Mode mode_ = Mode::Receiver;
     StreamConfig streamConfig_;
     bool deviceOpen_ = false;
+    bool headless_ = false;
+
+    AudioMetrics metrics_;
+    LevelMeter levelMeter_;
+    SpectrumAnalyzer spectrum_;
+    Recorder recorder_;
+    ListenTap listenTap_;
+    TimeShiftBuffer timeShift_;
+
+    // Guards routing_ and routingSummary_; plans reach the audio thread
+    // through router_
+    mutable std::mutex routingMutex_;
+    ChannelRouting routing_;
+    ChannelRouter::Summary routingSummary_;
+    ChannelRouter router_;
+
+    double callbackSampleRate_ = 48000.0;  // Written before the device starts calling back
+    int64_t outputLatencyNs_ = 0;          // Likewise
+    int64_t lastCallbackStartNs_ = 0;      // Audio thread only
+    std::thread::id callbackThread_;       // Audio thread only; policy applied to it
 };
 
 } // namespace audioserver
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Histogram.h"
+#include <atomic>
+#include <cstdint>
+
+namespace audioserver {
+
+// Realtime statistics for the audio device callback. Histograms are written
+// only from the audio thread. Each counter has a single writer (underruns
+// the audio thread, overruns the transport's receive thread), so it is
+// bumped with a relaxed load and store instead of a locked read-modify-write.
+// Nothing here allocates or locks.
+struct AudioMetrics {
+    static constexpr uint64_t FULL_LOAD = 10000;  // dspLoad value for a callback using its whole period
+
+    Histogram callbackDurationNs;
+    Histogram callbackIntervalNs;
+    Histogram dspLoad;  // Basis points of the buffer period spent inside the callback
+
+    std::atomic<uint64_t> callbacks{0};
+    std::atomic<uint64_t> overloads{0};  // Callbacks that took longer than their buffer period
+    std::atomic<uint64_t> underruns{0};  // Playback wanted more audio than the jitter buffer held
+    std::atomic<uint64_t> overruns{0};   // Received audio dropped because the jitter buffer was full
+
+    void recordUnderrun() { bump(underruns); }
+    void recordOverrun() { bump(overruns); }
+
+    // Only for a counter's one writer thread
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+} // namespace audioserver
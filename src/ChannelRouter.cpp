@@ -0,0 +1,273 @@
+#include "ChannelRouter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+namespace audioserver {
+
+namespace {
+    std::string trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t");
+        size_t last = text.find_last_not_of(" \t");
+        return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+    }
+
+    bool parseIndex(const std::string& text, int& value) {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos || text.size() > 4) {
+            return false;
+        }
+        value = std::atoi(text.c_str());
+        return true;
+    }
+
+    // "3" or "0-7"
+    bool parseRange(const std::string& text, int& first, int& last) {
+        size_t dash = text.find('-');
+        if (dash == std::string::npos) {
+            if (!parseIndex(text, first)) {
+                return false;
+            }
+            last = first;
+            return true;
+        }
+        return parseIndex(text.substr(0, dash), first)
+            && parseIndex(text.substr(dash + 1), last)
+            && first <= last;
+    }
+
+    bool parseGain(const std::string& text, float& gainDb) {
+        const char* start = text.c_str();
+        char* end = nullptr;
+        gainDb = std::strtof(start, &end);
+        return end != start && *end == '\0' && std::isfinite(gainDb);
+    }
+}
+
+std::vector<int> ChannelRouting::deviceChannels(bool sender) const {
+    std::vector<int> channels;
+    channels.reserve(routes.size());
+    for (const auto& route : routes) {
+        channels.push_back(sender ? route.source : route.destination);
+    }
+    std::sort(channels.begin(), channels.end());
+    channels.erase(std::unique(channels.begin(), channels.end()), channels.end());
+    return channels;
+}
+
+std::vector<int> ChannelRouting::claimedChannels(bool sender, int streamChannels) const {
+    if (!straightThrough()) {
+        return deviceChannels(sender);
+    }
+    std::vector<int> channels;
+    for (int ch = 0; ch < streamChannels; ++ch) {
+        channels.push_back(ch);
+    }
+    return channels;
+}
+
+std::vector<int> ChannelRouting::overlap(const std::vector<int>& a, const std::vector<int>& b) {
+    std::vector<int> shared;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(shared));
+    return shared;
+}
+
+bool ChannelRouting::parse(const std::string& spec, ChannelRouting& routing, std::string& error) {
+    routing = ChannelRouting{};
+
+    std::stringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        item = trim(item);
+        if (item.empty()) {
+            continue;
+        }
+
+        std::string patch = item;
+        float gainDb = 0.0f;
+        size_t at = item.find('@');
+        if (at != std::string::npos) {
+            patch = item.substr(0, at);
+            if (!parseGain(trim(item.substr(at + 1)), gainDb) || gainDb > MAX_GAIN_DB) {
+                error = "Invalid gain in '" + item + "' (dB, at most " + std::to_string(static_cast<int>(MAX_GAIN_DB)) + ")";
+                return false;
+            }
+        }
+
+        size_t colon = patch.find(':');
+        int sourceFirst = 0;
+        int sourceLast = 0;
+        int destinationFirst = 0;
+        int destinationLast = 0;
+        if (colon == std::string::npos
+            || !parseRange(trim(patch.substr(0, colon)), sourceFirst, sourceLast)
+            || !parseRange(trim(patch.substr(colon + 1)), destinationFirst, destinationLast)) {
+            error = "Invalid route '" + item + "' (expected <src>:<dst>[@<gainDb>])";
+            return false;
+        }
+        if (sourceLast - sourceFirst != destinationLast - destinationFirst) {
+            error = "Ranges in '" + item + "' differ in length";
+            return false;
+        }
+
+        for (int offset = 0; offset <= sourceLast - sourceFirst; ++offset) {
+            if (routing.routes.size() == MAX_ROUTES) {
+                error = "At most " + std::to_string(MAX_ROUTES) + " routes";
+                return false;
+            }
+            routing.routes.push_back({sourceFirst + offset, destinationFirst + offset, gainDb});
+        }
+    }
+
+    // The network side is limited by the stream, the device side by what
+    // interfaces offer; which is which depends on the mode, so both ends
+    // are held to the larger limit here and compile() drops what the stream
+    // and device at hand cannot carry
+    for (const auto& route : routing.routes) {
+        if (route.source >= MAX_DEVICE_CHANNELS || route.destination >= MAX_DEVICE_CHANNELS) {
+            error = "Channels must be below " + std::to_string(MAX_DEVICE_CHANNELS);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string ChannelRouting::toString() const {
+    std::ostringstream spec;
+    for (size_t i = 0; i < routes.size(); ++i) {
+        if (i > 0) {
+            spec << ',';
+        }
+        spec << routes[i].source << ':' << routes[i].destination;
+        if (routes[i].gainDb != 0.0f) {
+            spec << '@' << routes[i].gainDb;
+        }
+    }
+    return spec.str();
+}
+
+void ChannelRouter::Plan::route(const float* const* input, int numInputs, int inputOffset,
+                                float* const* output, int numOutputs, int outputOffset, int frames) const {
+    const auto count = static_cast<size_t>(frames);
+    const bool compiledFor = numInputs == numInputs_ && numOutputs == numOutputs_;
+    if (compiledFor) {
+        for (int destination : silent_) {
+            std::fill(output[destination] + outputOffset, output[destination] + outputOffset + frames, 0.0f);
+        }
+    } else {
+        for (int ch = 0; ch < numOutputs; ++ch) {
+            std::fill(output[ch] + outputOffset, output[ch] + outputOffset + frames, 0.0f);
+        }
+    }
+
+    for (const auto& step : steps_) {
+        if (step.source >= numInputs || step.destination >= numOutputs) {
+            continue;
+        }
+        const float* in = input[step.source] + inputOffset;
+        float* out = output[step.destination] + outputOffset;
+        const float gain = step.gain;
+
+        if (step.add || !compiledFor) {
+            if (gain == 1.0f) {
+                for (size_t i = 0; i < count; ++i) {
+                    out[i] += in[i];
+                }
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    out[i] += in[i] * gain;
+                }
+            }
+        } else if (gain == 1.0f) {
+            std::copy(in, in + frames, out);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = in[i] * gain;
+            }
+        }
+    }
+}
+
+ChannelRouter::~ChannelRouter() = default;
+
+std::unique_ptr<ChannelRouter::Plan> ChannelRouter::compile(const ChannelRouting& routing, bool sender,
+                                                            int networkChannels,
+                                                            const std::vector<int>& deviceChannels,
+                                                            Summary& summary) {
+    summary = Summary{};
+    summary.deviceChannels = deviceChannels;
+    if (routing.straightThrough() || networkChannels <= 0) {
+        return nullptr;
+    }
+
+    // Physical device channel -> its position in the callback's arrays
+    std::vector<int> slot(ChannelRouting::MAX_DEVICE_CHANNELS, -1);
+    for (size_t i = 0; i < deviceChannels.size(); ++i) {
+        if (deviceChannels[i] >= 0 && deviceChannels[i] < ChannelRouting::MAX_DEVICE_CHANNELS) {
+            slot[static_cast<size_t>(deviceChannels[i])] = static_cast<int>(i);
+        }
+    }
+
+    auto plan = std::make_unique<Plan>();
+    for (const auto& route : routing.routes) {
+        int network = sender ? route.destination : route.source;
+        int device = slot[static_cast<size_t>(sender ? route.source : route.destination)];
+        if (network >= networkChannels || device < 0) {
+            ++summary.ignoredRoutes;
+            continue;
+        }
+        float gain = std::pow(10.0f, route.gainDb / 20.0f);
+        plan->steps_.push_back({sender ? device : network, sender ? network : device, gain, false});
+    }
+
+    // Grouped by destination, in the order given, so each destination is
+    // written once and then accumulated into while it is still in cache
+    std::stable_sort(plan->steps_.begin(), plan->steps_.end(), [](const Plan::Step& a, const Plan::Step& b) {
+        return a.destination < b.destination;
+    });
+    for (size_t i = 1; i < plan->steps_.size(); ++i) {
+        plan->steps_[i].add = plan->steps_[i].destination == plan->steps_[i - 1].destination;
+    }
+
+    plan->numInputs_ = sender ? static_cast<int>(deviceChannels.size()) : networkChannels;
+    plan->numOutputs_ = sender ? networkChannels : static_cast<int>(deviceChannels.size());
+    for (int destination = 0, next = 0; destination < plan->numOutputs_; ++destination) {
+        bool routed = false;
+        while (next < static_cast<int>(plan->steps_.size()) && plan->steps_[static_cast<size_t>(next)].destination == destination) {
+            routed = true;
+            ++next;
+        }
+        if (!routed) {
+            plan->silent_.push_back(destination);
+        }
+    }
+
+    plan->networkChannels_ = networkChannels;
+    plan->network_.assign(static_cast<size_t>(networkChannels) * MAX_BLOCK_FRAMES, 0.0f);
+    for (int ch = 0; ch < networkChannels; ++ch) {
+        plan->networkPtrs_.push_back(plan->network_.data() + static_cast<size_t>(ch) * MAX_BLOCK_FRAMES);
+    }
+    return plan;
+}
+
+void ChannelRouter::setPlan(std::unique_ptr<Plan> plan) {
+    plan_.store(plan.get());  // seq_cst, paired with begin()
+
+    // A block that loaded the old plan before the swap may still be routing
+    while (applying_.load()) {
+        std::this_thread::yield();
+    }
+    owned_ = std::move(plan);
+}
+
+ChannelRouter::Plan* ChannelRouter::begin() {
+    if (!plan_.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    applying_.store(true);  // seq_cst, paired with setPlan()
+    return plan_.load();
+}
+
+} // namespace audioserver
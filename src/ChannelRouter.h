@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+
+// One connection of the routing matrix. Channels are numbered from 0 and the
+// direction is always that of the signal: a receiver routes network channels
+// to device outputs, a sender routes device inputs to network channels.
+struct ChannelRoute {
+    int source = 0;
+    int destination = 0;
+    float gainDb = 0.0f;
+};
+
+// A sparse routing matrix. Several routes from one source split it, several
+// routes to one destination are summed (merge, downmix). Without any routes
+// audio passes straight through: network channel N to device channel N.
+struct ChannelRouting {
+    static constexpr int MAX_NETWORK_CHANNELS = 64;
+    static constexpr int MAX_DEVICE_CHANNELS = 256;
+    static constexpr size_t MAX_ROUTES = 1024;
+    static constexpr float MAX_GAIN_DB = 24.0f;
+
+    std::vector<ChannelRoute> routes;
+
+    bool straightThrough() const { return routes.empty(); }
+
+    // Device channels the routes use, ascending (inputs for a sender,
+    // outputs for a receiver)
+    std::vector<int> deviceChannels(bool sender) const;
+
+    // Device channels a stream of streamChannels holds open: the routed ones,
+    // or the first streamChannels when straight through
+    std::vector<int> claimedChannels(bool sender, int streamChannels) const;
+
+    // Channels in both ascending lists
+    static std::vector<int> overlap(const std::vector<int>& a, const std::vector<int>& b);
+
+    // Comma separated "<src>:<dst>[@<gainDb>]", where src and dst may also be
+    // equally long ranges: "0:0,0:1" splits channel 0 to two outputs,
+    // "2:0@-3,3:0@-3" merges two channels, "0-7:16-23" patches a block.
+    // An empty spec means straight through.
+    static bool parse(const std::string& spec, ChannelRouting& routing, std::string& error);
+    std::string toString() const;
+};
+
+// Applies a ChannelRouting on the audio thread.
+//
+// compile() turns the routes into a plan ordered by destination: the first
+// route into each destination copies (or scales) into it, later ones add to
+// it, and destinations nothing routes to are cleared. The callback then only
+// walks that list of contiguous copy/gain loops, with no lookups. Plans are
+// built off the audio thread and swapped in with setPlan(); the previous one
+// is freed once no block is using it.
+//
+// begin()/end() must only be called from one thread at a time.
+class ChannelRouter {
+public:
+    static constexpr int MAX_BLOCK_FRAMES = 8192;
+
+    class Plan {
+    public:
+        int networkChannels() const { return networkChannels_; }
+
+        // Planar network-side buffers, MAX_BLOCK_FRAMES long
+        float* const* networkBuffers() { return networkPtrs_.data(); }
+
+        // Mixes frames of input (from inputOffset) into output (from
+        // outputOffset). Channel counts other than the ones compiled for
+        // only happen while a device is being reopened; routes that fall
+        // outside them are skipped.
+        void route(const float* const* input, int numInputs, int inputOffset,
+                   float* const* output, int numOutputs, int outputOffset, int frames) const;
+
+    private:
+        friend class ChannelRouter;
+
+        struct Step {
+            int source;
+            int destination;
+            float gain;
+            bool add;  // Later routes into a destination sum with the first
+        };
+
+        std::vector<Step> steps_;
+        std::vector<int> silent_;  // Destinations without a route
+        int numInputs_ = 0;
+        int numOutputs_ = 0;
+        int networkChannels_ = 0;
+        std::vector<float> network_;
+        std::vector<float*> networkPtrs_;
+    };
+
+    struct Summary {
+        std::vector<int> deviceChannels;  // Active device channels the plan was built for
+        uint32_t ignoredRoutes = 0;       // Outside the stream's channels or the device's
+    };
+
+    ChannelRouter() = default;
+    ~ChannelRouter();
+
+    ChannelRouter(const ChannelRouter&) = delete;
+    ChannelRouter& operator=(const ChannelRouter&) = delete;
+
+    // deviceChannels are the device's active channels, in the order the
+    // callback passes them. Returns null for straight-through routing.
+    static std::unique_ptr<Plan> compile(const ChannelRouting& routing, bool sender, int networkChannels,
+                                         const std::vector<int>& deviceChannels, Summary& summary);
+
+    void setPlan(std::unique_ptr<Plan> plan);
+
+    // Audio thread: the plan to use for this block, or null to pass audio
+    // straight through. Every begin() is paired with end().
+    Plan* begin();
+    void end() { applying_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<Plan*> plan_{nullptr};
+    std::unique_ptr<Plan> owned_;
+
+    // setPlan() waits for applying_ to clear before freeing the old plan
+    std::atomic<bool> applying_{false};
+};
+
+} // namespace audioserver
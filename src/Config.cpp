@@ -1,10 +1,31 @@
 #include "Config.h"
+#include "PlayoutScheduler.h"
 #include <iostream>
 #include <cstring>
 #include <stdexcept>
 
 namespace audioserver {
 
+namespace {
+    ThreadPolicy parseThreadPolicy(const std::string& option, const std::string& spec) {
+        ThreadPolicy policy;
+        std::string error;
+        if (!ThreadPolicy::parse(spec, policy, error)) {
+            throw std::runtime_error(option + ": " + error);
+        }
+        return policy;
+    }
+
+    ChannelRouting parseRouting(const std::string& option, const std::string& spec) {
+        ChannelRouting routing;
+        std::string error;
+        if (!ChannelRouting::parse(spec, routing, error)) {
+            throw std::runtime_error(option + ": " + error);
+        }
+        return routing;
+    }
+}
+
 Config Config::fromArgs(int argc, char* argv[]) {
     Config config;
 
@@ -51,6 +72,41 @@ Config Config::fromArgs(int argc, char* argv[]) {
             config.testTone = true;
         } else if (arg == "--test-tone-freq" && i + 1 < argc) {
             config.testToneFrequency = static_cast<uint32_t>(std::stoi(argv[++i]));
+        } else if (arg == "--play-file" && i + 1 < argc) {
+            config.playFile = argv[++i];
+        } else if (arg == "--loop") {
+            config.loopPlayback = true;
+        } else if (arg == "--headless") {
+            config.headless = true;
+        } else if (arg == "--input-file" && i + 1 < argc) {
+            config.inputFile = argv[++i];
+            config.headless = true;
+        } else if (arg == "--output-file" && i + 1 < argc) {
+            config.outputFile = argv[++i];
+            config.headless = true;
+        } else if (arg == "--spectrum-rate" && i + 1 < argc) {
+            config.spectrumRate = static_cast<uint32_t>(std::stoi(argv[++i]));
+        } else if (arg == "--sched-audio" && i + 1 < argc) {
+            config.audioThreads = parseThreadPolicy(arg, argv[++i]);
+        } else if (arg == "--sched-network" && i + 1 < argc) {
+            config.networkThreads = parseThreadPolicy(arg, argv[++i]);
+        } else if (arg == "--sched-api" && i + 1 < argc) {
+            config.apiThreads = parseThreadPolicy(arg, argv[++i]);
+        } else if (arg == "--mlock") {
+            config.lockMemory = true;
+        } else if (arg == "--record-dir" && i + 1 < argc) {
+            config.recordDir = argv[++i];
+        } else if (arg == "--timeshift-mb" && i + 1 < argc) {
+            config.timeShiftMb = static_cast<uint32_t>(std::stoi(argv[++i]));
+        } else if (arg == "--sync-delay-ms" && i + 1 < argc) {
+            config.syncDelayMs = static_cast<uint32_t>(std::stoi(argv[++i]));
+            if (config.syncDelayMs > static_cast<uint32_t>(PlayoutScheduler::MAX_DELAY_MS)) {
+                throw std::runtime_error(arg + ": at most " + std::to_string(PlayoutScheduler::MAX_DELAY_MS) + " ms");
+            }
+        } else if (arg == "--route" && i + 1 < argc) {
+            config.routing = parseRouting(arg, argv[++i]);
+        } else if (arg == "--stream" && i + 1 < argc) {
+            config.streams.push_back(argv[++i]);  // Parsed against the finished config in main()
         } else {
             throw std::runtime_error("Unknown argument: " + arg);
         }
@@ -77,6 +133,28 @@ OPTIONS:
     --transport <TYPE>      Transport backend: tcp-pcm (default: tcp-pcm)
     --test-tone             Generate test tone instead of capturing audio (sender only)
     --test-tone-freq <HZ>   Test tone frequency in Hz (default: 440)
+    --play-file <WAV>       Stream a WAV/RF64 file instead of capturing audio (sender only)
+    --loop                  Loop --play-file instead of sending silence at the end
+    --headless              Use a virtual timer-driven audio device instead of hardware
+    --input-file <WAV>      Loop a WAV file as headless capture input (implies --headless)
+    --output-file <WAV>     Record headless playback output to a WAV file (implies --headless)
+    --spectrum-rate <HZ>    Spectrum analyses per second for /spectrum, 0 disables (default: 10)
+    --sched-audio <SPEC>    Audio thread policy: <fifo|rr|other>[:<PRIO>][@<CPUS>], e.g. fifo:80@2
+    --sched-network <SPEC>  Transport event loop thread policy (same format)
+    --sched-api <SPEC>      HTTP API thread policy (same format)
+    --mlock                 Lock all memory (mlockall) at stream start
+    --record-dir <DIR>      Directory for /record/start files (default: recordings)
+    --timeshift-mb <MB>     Memory for the receiver's /timeshift replay history, 0 disables (default: 64)
+    --sync-delay-ms <MS>    Receiver: play audio this long after the sender captured it, on the
+                            sender's clock, so receivers with the same delay play in phase
+                            (default: 0, play as it arrives)
+    --route <SPEC>          Channel routing: <src>:<dst>[@<gainDb>],... from network to device
+                            channels (receiver) or device to network channels (sender), e.g.
+                            0:4,1:5 or 0-7:16-23 (default: channel N to channel N)
+    --stream <SPEC>         Run another stream in this process, repeatable:
+                            name=<NAME>;mode=<MODE>;port=<PORT>[;<key>=<value>...] with keys
+                            device, target, sampleRate, channels, bufferSize, routes,
+                            testTone, testToneFreq, playFile, loop, syncDelayMs
     --list-devices          List available audio devices and exit
     --verbose, -v           Enable verbose logging
     --help, -h              Show this help message
@@ -90,6 +168,26 @@ EXAMPLES:
 
     # List available audio devices
     audio-server --list-devices
+
+    # Stream a multitrack file on repeat, seekable through PUT /playback
+    audio-server --mode sender --target 192.168.1.100 --play-file rehearsal.wav --loop
+
+    # Receive without a sound card, recording what would be played
+    audio-server --mode receiver --output-file received.wav
+
+    # Play a stereo stream on device channels 8-9 and a mono mix of it on channel 0
+    audio-server --mode receiver --route 0-1:8-9,0:0@-6,1:0@-6
+
+    # One process receiving two streams on different outputs of one interface
+    audio-server --mode receiver --device "UFX" --route 0-1:0-1 \
+        --stream "name=drums;mode=receiver;port=9877;device=UFX;routes=0-7:8-15"
+
+    # Two rooms fed by one sender host, playing in phase 150 ms after capture
+    audio-server --mode receiver --device "Kitchen" --sync-delay-ms 150 \
+        --stream "name=lounge;mode=receiver;port=9877;device=Lounge;syncDelayMs=150"
+
+    # Realtime audio on CPU 2, network on CPU 3, all memory locked
+    audio-server --mode receiver --sched-audio fifo:80@2 --sched-network fifo:70@3 --mlock
 )";
 }
 
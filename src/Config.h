@@ -1,7 +1,10 @@
 #pragma once
 
+#include "ChannelRouter.h"
+#include "ThreadPolicy.h"
 #include <string>
 #include <cstdint>
+#include <vector>
 
 namespace audioserver {
 
@@ -29,16 +32,56 @@ struct Config {
     bool showHelp = false;
     bool testTone = false;
     uint32_t testToneFrequency = 440;
+    std::string playFile;       // Sender source: WAV/RF64 file streamed instead of a device
+    bool loopPlayback = false;  // Restart playFile at the end instead of going silent
+    bool headless = false;
+    std::string inputFile;   // Headless capture source (WAV)
+    std::string outputFile;  // Headless playback sink (WAV)
+    uint32_t spectrumRate = 10;  // /spectrum analyses per second (0 = off)
+    ThreadPolicy audioThreads;
+    ThreadPolicy networkThreads;
+    ThreadPolicy apiThreads;
+    bool lockMemory = false;
+    std::string recordDir = "recordings";  // Where /record/start writes files
+    uint32_t timeShiftMb = 64;  // Receiver replay history for /timeshift (0 = off)
+    uint32_t syncDelayMs = 0;   // Receiver: play this long after capture, on the sender's clock (0 = as it arrives)
+    ChannelRouting routing;     // Network <-> device channels; empty = straight through
+    std::vector<std::string> streams;  // --stream specs, started next to the primary stream
 
     static Config fromArgs(int argc, char* argv[]);
     static void printUsage();
 };
 
 struct StreamConfig {
+    static constexpr uint32_t MIN_SAMPLE_RATE = 8000;
+    static constexpr uint32_t MAX_SAMPLE_RATE = 384000;
+    static constexpr uint16_t MAX_CHANNELS = 64;
+    static constexpr uint32_t MIN_BUFFER_SIZE = 16;
+    static constexpr uint32_t MAX_BUFFER_SIZE = 8192;
+
     uint32_t sampleRate = 48000;
     uint16_t channels = 2;
     uint16_t bitsPerSample = 32;  // float32
     uint32_t bufferSize = 512;
+
+    // Whether the format is within the limits above; error says why not
+    bool validate(std::string& error) const {
+        if (sampleRate < MIN_SAMPLE_RATE || sampleRate > MAX_SAMPLE_RATE) {
+            error = "sampleRate must be between " + std::to_string(MIN_SAMPLE_RATE)
+                  + " and " + std::to_string(MAX_SAMPLE_RATE);
+            return false;
+        }
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            error = "channels must be between 1 and " + std::to_string(MAX_CHANNELS);
+            return false;
+        }
+        if (bufferSize < MIN_BUFFER_SIZE || bufferSize > MAX_BUFFER_SIZE) {
+            error = "bufferSize must be between " + std::to_string(MIN_BUFFER_SIZE)
+                  + " and " + std::to_string(MAX_BUFFER_SIZE);
+            return false;
+        }
+        return true;
+    }
 };
 
 } // namespace audioserver
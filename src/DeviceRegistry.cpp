@@ -0,0 +1,187 @@
+#include "DeviceRegistry.h"
+#include <algorithm>
+#include <chrono>
+
+namespace audioserver {
+
+namespace {
+    const AudioDeviceInfo* findDevice(const std::vector<AudioDeviceInfo>& devices,
+                                      const std::string& type, const std::string& name) {
+        for (const auto& device : devices) {
+            if (device.type == type && device.name == name) {
+                return &device;
+            }
+        }
+        return nullptr;
+    }
+}
+
+DeviceRegistry::DeviceRegistry(juce::AudioDeviceManager& deviceManager)
+    : deviceManager_(deviceManager)
+    , snapshot_(std::make_shared<Snapshot>()) {
+    deviceManager_.addChangeListener(this);
+}
+
+DeviceRegistry::~DeviceRegistry() {
+    deviceManager_.removeChangeListener(this);
+    cancelPendingUpdate();
+}
+
+void DeviceRegistry::scan() {
+    refresh(true, true);
+}
+
+uint64_t DeviceRegistry::requestRescan() {
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ticket = ++requestedTicket_;
+    }
+    triggerAsyncUpdate();  // Coalesces with any rescan already pending
+    return ticket;
+}
+
+bool DeviceRegistry::waitForRescan(uint64_t ticket, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                        [&] { return completedTicket_ >= ticket; });
+}
+
+std::shared_ptr<const DeviceRegistry::Snapshot> DeviceRegistry::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshot_;
+}
+
+void DeviceRegistry::setActiveDevice(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    activeDevice_ = name;
+}
+
+void DeviceRegistry::changeListenerCallback(juce::ChangeBroadcaster*) {
+    // The manager also broadcasts plain setup changes (including our own
+    // device opens). Device types rescan themselves before reporting a
+    // hot-plug, so their name lists are current and cheap to compare.
+    if (deviceListChanged()) {
+        refresh(false, false);
+    }
+}
+
+void DeviceRegistry::handleAsyncUpdate() {
+    refresh(true, true);
+}
+
+bool DeviceRegistry::deviceListChanged() const {
+    auto current = snapshot();
+
+    size_t inputs = 0;
+    size_t outputs = 0;
+    for (auto* type : deviceManager_.getAvailableDeviceTypes()) {
+        std::string typeName = type->getTypeName().toStdString();
+        for (const auto& name : type->getDeviceNames(true)) {
+            if (!findDevice(current->inputs, typeName, name.toStdString())) {
+                return true;
+            }
+            inputs++;
+        }
+        for (const auto& name : type->getDeviceNames(false)) {
+            if (!findDevice(current->outputs, typeName, name.toStdString())) {
+                return true;
+            }
+            outputs++;
+        }
+    }
+    return inputs != current->inputs.size() || outputs != current->outputs.size();
+}
+
+void DeviceRegistry::refresh(bool scanTypes, bool reprobeAll) {
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t ticket;
+    std::string active;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ticket = requestedTicket_;
+        active = activeDevice_;
+    }
+
+    auto previous = snapshot();
+    auto next = std::make_shared<Snapshot>();
+    auto* currentDevice = deviceManager_.getCurrentAudioDevice();
+
+    for (auto* type : deviceManager_.getAvailableDeviceTypes()) {
+        if (scanTypes) {
+            type->scanForDevices();
+        }
+
+        std::string typeName = type->getTypeName().toStdString();
+        for (bool input : {true, false}) {
+            auto names = type->getDeviceNames(input);
+            int defaultIndex = type->getDefaultDeviceIndex(input);
+            auto& devices = input ? next->inputs : next->outputs;
+
+            for (int i = 0; i < names.size(); ++i) {
+                // Reuse what we already know when allowed, and always for the open device
+                std::string name = names[i].toStdString();
+                const AudioDeviceInfo* known = nullptr;
+                if (!reprobeAll || name == active) {
+                    known = findDevice(input ? previous->inputs : previous->outputs, typeName, name);
+                }
+
+                AudioDeviceInfo info;
+                if (known) {
+                    info = *known;
+                } else if (name == active && currentDevice && currentDevice->getName() == names[i]) {
+                    info = describe(*currentDevice, typeName);  // First scan after opening it
+                } else {
+                    info = probe(*type, names[i], input);
+                }
+                info.isDefault = i == defaultIndex;
+                devices.push_back(std::move(info));
+            }
+        }
+    }
+
+    next->generation = previous->generation + 1;
+    next->scanDurationMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot_ = std::move(next);
+        completedTicket_ = std::max(completedTicket_, ticket);
+    }
+    cv_.notify_all();
+}
+
+AudioDeviceInfo DeviceRegistry::probe(juce::AudioIODeviceType& type, const juce::String& name, bool input) {
+    AudioDeviceInfo info;
+    info.name = name.toStdString();
+    info.type = type.getTypeName().toStdString();
+
+    std::unique_ptr<juce::AudioIODevice> device(
+        type.hasSeparateInputsAndOutputs()
+            ? (input ? type.createDevice({}, name) : type.createDevice(name, {}))
+            : type.createDevice(name, name));
+    if (!device) {
+        return info;  // Listed but not openable right now; report no capabilities
+    }
+
+    return describe(*device, info.type);
+}
+
+AudioDeviceInfo DeviceRegistry::describe(juce::AudioIODevice& device, const std::string& type) {
+    AudioDeviceInfo info;
+    info.name = device.getName().toStdString();
+    info.type = type;
+    info.numInputChannels = device.getInputChannelNames().size();
+    info.numOutputChannels = device.getOutputChannelNames().size();
+    for (double rate : device.getAvailableSampleRates()) {
+        info.sampleRates.push_back(rate);
+    }
+    for (int size : device.getAvailableBufferSizes()) {
+        info.bufferSizes.push_back(size);
+    }
+    return info;
+}
+
+} // namespace audioserver
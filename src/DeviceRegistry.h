@@ -0,0 +1,84 @@
+#pragma once
+
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+
+struct AudioDeviceInfo {
+    std::string name;
+    std::string type;
+    int numInputChannels = 0;
+    int numOutputChannels = 0;
+    bool isDefault = false;
+    std::vector<double> sampleRates;
+    std::vector<int> bufferSizes;
+};
+
+// Cached audio device list, so /devices never scans hardware.
+//
+// Scanning and probing (which can take hundreds of milliseconds on ALSA)
+// happen on the JUCE message thread, where device types expect to be used:
+// once at startup, when the device manager reports a change (hot-plug on
+// CoreAudio/WASAPI), and on explicit rescan requests from any thread, which
+// are coalesced. Each scan publishes an immutable snapshot that readers
+// share without copying.
+class DeviceRegistry : private juce::ChangeListener, private juce::AsyncUpdater {
+public:
+    static constexpr int RESCAN_TIMEOUT_MS = 5000;
+
+    struct Snapshot {
+        uint64_t generation = 0;
+        double scanDurationMs = 0.0;
+        std::vector<AudioDeviceInfo> inputs;
+        std::vector<AudioDeviceInfo> outputs;
+    };
+
+    explicit DeviceRegistry(juce::AudioDeviceManager& deviceManager);
+    ~DeviceRegistry() override;
+
+    // Full synchronous scan; message thread only (used by --list-devices)
+    void scan();
+
+    // Queues a full rescan on the message thread. Returns a ticket that
+    // waitForRescan() accepts. Safe from any thread.
+    uint64_t requestRescan();
+
+    // Blocks until the rescan for ticket has been published. Returns false
+    // on timeout (e.g. the message loop is not running).
+    bool waitForRescan(uint64_t ticket, int timeoutMs);
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    // The open device is never re-probed (it may refuse a second open);
+    // its last known capabilities are kept instead
+    void setActiveDevice(const std::string& name);
+
+private:
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void handleAsyncUpdate() override;
+
+    // reprobeAll = false keeps the capabilities of devices already listed
+    void refresh(bool scanTypes, bool reprobeAll);
+    bool deviceListChanged() const;
+
+    // Opens a temporary device instance to read channel counts, rates and sizes
+    AudioDeviceInfo probe(juce::AudioIODeviceType& type, const juce::String& name, bool input);
+    static AudioDeviceInfo describe(juce::AudioIODevice& device, const std::string& type);
+
+    juce::AudioDeviceManager& deviceManager_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::shared_ptr<const Snapshot> snapshot_;
+    std::string activeDevice_;
+    uint64_t requestedTicket_ = 0;
+    uint64_t completedTicket_ = 0;
+};
+
+} // namespace audioserver
@@ -0,0 +1,324 @@
+#include "FilePlayer.h"
+#include "Interleave.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace audioserver {
+
+namespace {
+    uint16_t readLE16(const uint8_t* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t readLE32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+             | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint64_t readLE64(const uint8_t* p) {
+        return static_cast<uint64_t>(readLE32(p)) | (static_cast<uint64_t>(readLE32(p + 4)) << 32);
+    }
+
+    bool isTag(const uint8_t* p, const char* tag) {
+        return std::memcmp(p, tag, 4) == 0;
+    }
+
+    // Kernel hint for a range of the mapping; page-aligned as madvise requires
+    void advise(const uint8_t* start, size_t length, [[maybe_unused]] int advice) {
+#ifndef _WIN32
+        static const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto begin = reinterpret_cast<uintptr_t>(start) & ~(pageSize - 1);
+        auto end = reinterpret_cast<uintptr_t>(start) + length;
+        madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+#else
+        (void)start;
+        (void)length;
+#endif
+    }
+
+#ifdef _WIN32
+    constexpr int ADVICE_SEQUENTIAL = 0;
+    constexpr int ADVICE_WILLNEED = 0;
+#else
+    constexpr int ADVICE_SEQUENTIAL = MADV_SEQUENTIAL;
+    constexpr int ADVICE_WILLNEED = MADV_WILLNEED;
+#endif
+}
+
+FilePlayer::FilePlayer() = default;
+FilePlayer::~FilePlayer() = default;
+
+bool FilePlayer::open(const std::string& path, std::string& error) {
+    juce::File file(path);
+    if (!file.existsAsFile()) {
+        error = "File not found: " + path;
+        return false;
+    }
+
+    map_ = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    if (map_->getData() == nullptr) {
+        error = "Failed to map " + path;
+        map_.reset();
+        return false;
+    }
+
+    path_ = path;
+    if (!parseHeader(error)) {
+        map_.reset();
+        data_ = nullptr;
+        return false;
+    }
+
+    interleaved_.assign(static_cast<size_t>(MAX_BLOCK_FRAMES) * static_cast<size_t>(channels_), 0.0f);
+
+    size_t dataBytes = lengthFrames_ * bytesPerFrame_;
+    advise(data_, dataBytes, ADVICE_SEQUENTIAL);
+    prefetchedTo_ = 0;
+    prefetch(0);
+    return true;
+}
+
+bool FilePlayer::parseHeader(std::string& error) {
+    const auto* base = static_cast<const uint8_t*>(map_->getData());
+    const size_t size = map_->getSize();
+
+    if (size < 12 || !(isTag(base, "RIFF") || isTag(base, "RF64")) || !isTag(base + 8, "WAVE")) {
+        error = "Not a WAV or RF64 file";
+        return false;
+    }
+
+    uint64_t rf64DataSize = 0;
+    uint64_t dataBytes = 0;
+    bool haveFormat = false;
+    int formatTag = 0;
+    size_t offset = 12;
+
+    while (offset + 8 <= size) {
+        const uint8_t* chunk = base + offset;
+        uint64_t chunkSize = readLE32(chunk + 4);
+        const uint8_t* body = chunk + 8;
+        size_t available = size - offset - 8;
+
+        if (isTag(chunk, "ds64") && chunkSize >= 24 && available >= 24) {
+            rf64DataSize = readLE64(body + 8);
+        } else if (isTag(chunk, "fmt ") && chunkSize >= 16 && available >= 16) {
+            formatTag = readLE16(body);
+            channels_ = readLE16(body + 2);
+            sampleRate_ = readLE32(body + 4);
+            bitsPerSample_ = readLE16(body + 14);
+            if (formatTag == 0xFFFE && chunkSize >= 26 && available >= 26) {
+                formatTag = readLE16(body + 24);  // Extensible: the subformat GUID starts with the tag
+            }
+            haveFormat = true;
+        } else if (isTag(chunk, "data")) {
+            if (!haveFormat) {
+                error = "data chunk before fmt chunk";
+                return false;
+            }
+
+            // RF64 keeps the real size in ds64; an unfinished recording may
+            // leave 0 here. Either way never read past the end of the file.
+            if (chunkSize == UINT32_MAX && rf64DataSize != 0) {
+                chunkSize = rf64DataSize;
+            }
+            if (chunkSize == 0 || chunkSize > available) {
+                chunkSize = available;
+            }
+
+            data_ = body;
+            dataBytes = chunkSize;
+            break;
+        }
+
+        offset += 8 + chunkSize + (chunkSize & 1);
+        if (chunkSize == UINT32_MAX) {
+            break;  // Unknown size anywhere but data: cannot continue
+        }
+    }
+
+    if (!data_) {
+        error = "No audio data found";
+        return false;
+    }
+
+    if (formatTag == 1 && bitsPerSample_ == 16) {
+        format_ = SampleFormat::Int16;
+    } else if (formatTag == 1 && bitsPerSample_ == 24) {
+        format_ = SampleFormat::Int24;
+    } else if (formatTag == 1 && bitsPerSample_ == 32) {
+        format_ = SampleFormat::Int32;
+    } else if (formatTag == 3 && bitsPerSample_ == 32) {
+        format_ = SampleFormat::Float32;
+    } else if (formatTag == 3 && bitsPerSample_ == 64) {
+        format_ = SampleFormat::Float64;
+    } else {
+        error = "Unsupported sample format (tag " + std::to_string(formatTag)
+              + ", " + std::to_string(bitsPerSample_) + " bits)";
+        data_ = nullptr;
+        return false;
+    }
+
+    if (channels_ < 1 || channels_ > MAX_CHANNELS || sampleRate_ <= 0.0) {
+        error = "Unsupported layout: " + std::to_string(channels_) + " channels at "
+              + std::to_string(static_cast<int>(sampleRate_)) + " Hz";
+        data_ = nullptr;
+        return false;
+    }
+
+    bytesPerFrame_ = static_cast<size_t>(channels_) * static_cast<size_t>(bitsPerSample_ / 8);
+    lengthFrames_ = dataBytes / bytesPerFrame_;
+    return true;
+}
+
+void FilePlayer::read(float* const* channelData, int numChannels, int numSamples) {
+    int64_t target = pendingSeek_.exchange(-1);
+    if (target >= 0) {
+        position_ = std::min(static_cast<uint64_t>(target), lengthFrames_);
+        finished_ = false;
+        prefetchedTo_ = position_ * bytesPerFrame_;
+        prefetch(position_);
+    }
+
+    uint64_t position = position_.load(std::memory_order_relaxed);
+    std::array<float*, MAX_CHANNELS> outputs{};
+    int produced = 0;
+
+    while (produced < numSamples) {
+        if (position >= lengthFrames_) {
+            if (!loop_ || lengthFrames_ == 0) {
+                for (int ch = 0; ch < numChannels; ++ch) {
+                    std::fill(channelData[ch] + produced, channelData[ch] + numSamples, 0.0f);
+                }
+                finished_ = true;
+                break;
+            }
+            position = 0;
+            prefetchedTo_ = 0;
+            prefetch(0);
+        }
+
+        int frames = static_cast<int>(std::min<uint64_t>(
+            {static_cast<uint64_t>(numSamples - produced), lengthFrames_ - position,
+             static_cast<uint64_t>(MAX_BLOCK_FRAMES)}));
+
+        convert(position, frames, interleaved_.data());
+
+        if (numChannels == channels_) {
+            for (int ch = 0; ch < numChannels; ++ch) {
+                outputs[static_cast<size_t>(ch)] = channelData[ch] + produced;
+            }
+            deinterleave(interleaved_.data(), channels_, frames, outputs.data());
+        } else {
+            for (int ch = 0; ch < numChannels; ++ch) {
+                float* out = channelData[ch] + produced;
+                if (ch >= channels_) {
+                    std::fill(out, out + frames, 0.0f);
+                    continue;
+                }
+                for (int i = 0; i < frames; ++i) {
+                    out[i] = interleaved_[static_cast<size_t>(i * channels_ + ch)];
+                }
+            }
+        }
+
+        position += static_cast<uint64_t>(frames);
+        produced += frames;
+        prefetch(position);
+    }
+
+    position_.store(position, std::memory_order_relaxed);
+}
+
+void FilePlayer::convert(uint64_t frame, int frames, float* dest) const {
+    const uint8_t* src = data_ + frame * bytesPerFrame_;
+    const size_t count = static_cast<size_t>(frames) * static_cast<size_t>(channels_);
+
+    // Plain contiguous loops over a copy-free view of the mapping, which
+    // GCC/Clang/MSVC turn into SIMD conversions at -O2/-O3
+    switch (format_) {
+        case SampleFormat::Int16: {
+            constexpr float scale = 1.0f / 32768.0f;
+            for (size_t i = 0; i < count; ++i) {
+                int16_t sample;
+                std::memcpy(&sample, src + i * 2, sizeof(sample));
+                dest[i] = static_cast<float>(sample) * scale;
+            }
+            break;
+        }
+        case SampleFormat::Int24: {
+            constexpr float scale = 1.0f / 2147483648.0f;
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t* p = src + i * 3;
+                // Assemble in the top three bytes so the sign comes for free
+                auto sample = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8)
+                                                 | (static_cast<uint32_t>(p[1]) << 16)
+                                                 | (static_cast<uint32_t>(p[2]) << 24));
+                dest[i] = static_cast<float>(sample) * scale;
+            }
+            break;
+        }
+        case SampleFormat::Int32: {
+            constexpr float scale = 1.0f / 2147483648.0f;
+            for (size_t i = 0; i < count; ++i) {
+                int32_t sample;
+                std::memcpy(&sample, src + i * 4, sizeof(sample));
+                dest[i] = static_cast<float>(sample) * scale;
+            }
+            break;
+        }
+        case SampleFormat::Float32:
+            std::memcpy(dest, src, count * sizeof(float));
+            break;
+        case SampleFormat::Float64:
+            for (size_t i = 0; i < count; ++i) {
+                double sample;
+                std::memcpy(&sample, src + i * 8, sizeof(sample));
+                dest[i] = static_cast<float>(sample);
+            }
+            break;
+    }
+}
+
+void FilePlayer::prefetch(uint64_t frame) {
+    // Keep READAHEAD_BYTES requested ahead, in half-window steps so the
+    // hint costs one syscall per few megabytes played
+    uint64_t dataBytes = lengthFrames_ * bytesPerFrame_;
+    uint64_t from = frame * bytesPerFrame_;
+    if (prefetchedTo_ > from + READAHEAD_BYTES / 2 || prefetchedTo_ >= dataBytes) {
+        return;
+    }
+
+    uint64_t start = std::max(prefetchedTo_, from);
+    uint64_t end = std::min<uint64_t>(from + READAHEAD_BYTES, dataBytes);
+    if (end > start) {
+        advise(data_ + start, static_cast<size_t>(end - start), ADVICE_WILLNEED);
+    }
+    prefetchedTo_ = end;
+}
+
+void FilePlayer::seek(uint64_t frame) {
+    pendingSeek_ = static_cast<int64_t>(frame);
+}
+
+FilePlayer::Status FilePlayer::status() const {
+    Status status;
+    status.path = path_;
+    status.sampleRate = sampleRate_;
+    status.channels = channels_;
+    status.bitsPerSample = bitsPerSample_;
+    status.lengthFrames = lengthFrames_;
+    int64_t pending = pendingSeek_.load();
+    status.positionFrames = pending >= 0 ? std::min(static_cast<uint64_t>(pending), lengthFrames_)
+                                         : position_.load(std::memory_order_relaxed);
+    status.loop = loop_;
+    status.finished = finished_;
+    return status;
+}
+
+} // namespace audioserver
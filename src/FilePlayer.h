@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+
+// Sender source that plays a WAV or RF64 file straight out of a read-only
+// memory mapping.
+//
+// Nothing is decoded up front: read() converts the next block of the mapped
+// data chunk (16/24/32-bit PCM or 32/64-bit float) to float in one contiguous
+// pass the compiler vectorizes, then deinterleaves it. The kernel is told the
+// access is sequential, and READAHEAD_BYTES ahead of the play position are
+// requested as playback advances, so even a multi-GB multitrack file starts
+// immediately and never waits on the disk.
+//
+// read() must only be called from one thread (the paced source thread);
+// seek() and setLooping() may be called from anywhere and take effect at the
+// next read().
+class FilePlayer {
+public:
+    enum class SampleFormat { Int16, Int24, Int32, Float32, Float64 };
+
+    static constexpr int MAX_CHANNELS = 64;
+    static constexpr int MAX_BLOCK_FRAMES = 8192;
+    static constexpr size_t READAHEAD_BYTES = 8 << 20;
+
+    struct Status {
+        std::string path;
+        double sampleRate = 0.0;
+        int channels = 0;
+        int bitsPerSample = 0;
+        uint64_t lengthFrames = 0;
+        uint64_t positionFrames = 0;
+        bool loop = false;
+        bool finished = false;  // Reached the end without looping; now plays silence
+    };
+
+    FilePlayer();
+    ~FilePlayer();
+
+    bool open(const std::string& path, std::string& error);
+    bool isOpen() const { return data_ != nullptr; }
+
+    double getSampleRate() const { return sampleRate_; }
+    int getNumChannels() const { return channels_; }
+    uint64_t getLengthFrames() const { return lengthFrames_; }
+
+    // Fills numSamples frames, looping or padding with silence at the end.
+    // File channels beyond numChannels are skipped, missing ones are silent.
+    void read(float* const* channelData, int numChannels, int numSamples);
+
+    void seek(uint64_t frame);
+    void setLooping(bool loop) { loop_ = loop; }
+    bool isLooping() const { return loop_; }
+
+    Status status() const;
+
+private:
+    bool parseHeader(std::string& error);
+    void convert(uint64_t frame, int frames, float* dest) const;
+    void prefetch(uint64_t frame);
+
+    std::string path_;
+    std::unique_ptr<juce::MemoryMappedFile> map_;
+    const uint8_t* data_ = nullptr;  // First byte of the data chunk
+    double sampleRate_ = 0.0;
+    int channels_ = 0;
+    int bitsPerSample_ = 0;
+    SampleFormat format_ = SampleFormat::Int16;
+    size_t bytesPerFrame_ = 0;
+    uint64_t lengthFrames_ = 0;
+
+    // Source thread only
+    std::vector<float> interleaved_;
+    uint64_t prefetchedTo_ = 0;  // Byte offset into the data chunk
+
+    std::atomic<uint64_t> position_{0};
+    std::atomic<int64_t> pendingSeek_{-1};
+    std::atomic<bool> loop_{false};
+    std::atomic<bool> finished_{false};
+};
+
+} // namespace audioserver
@@ -0,0 +1,285 @@
+#include "HeadlessAudioDevice.h"
+#include <algorithm>
+#include <chrono>
+
+namespace audioserver {
+
+HeadlessAudioDevice::HeadlessAudioDevice(const juce::String& deviceName, const juce::String& typeName,
+                                         const HeadlessOptions& options)
+    : juce::AudioIODevice(deviceName, typeName)
+    , options_(options) {
+}
+
+HeadlessAudioDevice::~HeadlessAudioDevice() {
+    close();
+}
+
+juce::StringArray HeadlessAudioDevice::getOutputChannelNames() {
+    juce::StringArray names;
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        names.add("Output " + juce::String(ch + 1));
+    }
+    return names;
+}
+
+juce::StringArray HeadlessAudioDevice::getInputChannelNames() {
+    juce::StringArray names;
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        names.add("Input " + juce::String(ch + 1));
+    }
+    return names;
+}
+
+juce::Array<double> HeadlessAudioDevice::getAvailableSampleRates() {
+    juce::Array<double> rates;
+    for (double rate : {44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0}) {
+        rates.add(rate);
+    }
+    return rates;
+}
+
+juce::Array<int> HeadlessAudioDevice::getAvailableBufferSizes() {
+    juce::Array<int> sizes;
+    for (int size = 32; size <= 4096; size *= 2) {
+        sizes.add(size);
+    }
+    return sizes;
+}
+
+int HeadlessAudioDevice::getDefaultBufferSize() {
+    return 512;
+}
+
+juce::String HeadlessAudioDevice::open(const juce::BigInteger& inputChannels,
+                                       const juce::BigInteger& outputChannels,
+                                       double sampleRate,
+                                       int bufferSizeSamples) {
+    close();
+    lastError_ = {};
+
+    activeInputs_ = inputChannels;
+    activeOutputs_ = outputChannels;
+    numInputs_ = std::min(inputChannels.countNumberOfSetBits(), MAX_CHANNELS);
+    numOutputs_ = std::min(outputChannels.countNumberOfSetBits(), MAX_CHANNELS);
+    sampleRate_ = sampleRate > 0 ? sampleRate : 48000.0;
+    bufferSize_ = bufferSizeSamples > 0 ? bufferSizeSamples : getDefaultBufferSize();
+
+    if (!options_.inputFile.empty() && numInputs_ > 0) {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        reader_.reset(formatManager.createReaderFor(juce::File(options_.inputFile)));
+        if (!reader_) {
+            lastError_ = "Cannot read input file: " + juce::String(options_.inputFile);
+            return lastError_;
+        }
+        readPosition_ = 0;
+    }
+
+    if (!options_.outputFile.empty() && numOutputs_ > 0) {
+        juce::File file(options_.outputFile);
+        file.deleteFile();
+
+        auto stream = file.createOutputStream();
+        if (!stream) {
+            lastError_ = "Cannot create output file: " + juce::String(options_.outputFile);
+            reader_.reset();
+            return lastError_;
+        }
+
+        juce::WavAudioFormat wav;
+        writer_.reset(wav.createWriterFor(stream.get(), sampleRate_,
+                                          static_cast<unsigned int>(numOutputs_), 32, {}, 0));
+        if (!writer_) {
+            lastError_ = "Cannot write WAV to: " + juce::String(options_.outputFile);
+            reader_.reset();
+            return lastError_;
+        }
+        stream.release();  // Owned by the writer now
+    }
+
+    // Allocate everything up front so the timer thread never allocates
+    inputBuffer_.setSize(std::max(numInputs_, 1), bufferSize_);
+    outputBuffer_.setSize(std::max(numOutputs_, 1), bufferSize_);
+    inputBuffer_.clear();
+    outputBuffer_.clear();
+
+    open_ = true;
+    return {};
+}
+
+void HeadlessAudioDevice::close() {
+    stop();
+    writer_.reset();  // Finalizes the WAV header
+    reader_.reset();
+    open_ = false;
+}
+
+bool HeadlessAudioDevice::isOpen() {
+    return open_;
+}
+
+void HeadlessAudioDevice::start(juce::AudioIODeviceCallback* callback) {
+    if (!open_ || callback == nullptr || playing_) {
+        return;
+    }
+
+    callback_ = callback;
+    callback_->audioDeviceAboutToStart(this);
+
+    playing_ = true;
+    thread_ = std::thread(&HeadlessAudioDevice::timerThread, this);
+}
+
+void HeadlessAudioDevice::stop() {
+    if (!playing_) {
+        return;
+    }
+
+    playing_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    if (callback_) {
+        callback_->audioDeviceStopped();
+        callback_ = nullptr;
+    }
+}
+
+bool HeadlessAudioDevice::isPlaying() {
+    return playing_;
+}
+
+juce::String HeadlessAudioDevice::getLastError() {
+    return lastError_;
+}
+
+int HeadlessAudioDevice::getCurrentBufferSizeSamples() {
+    return bufferSize_;
+}
+
+double HeadlessAudioDevice::getCurrentSampleRate() {
+    return sampleRate_;
+}
+
+int HeadlessAudioDevice::getCurrentBitDepth() {
+    return 32;
+}
+
+juce::BigInteger HeadlessAudioDevice::getActiveOutputChannels() const {
+    return activeOutputs_;
+}
+
+juce::BigInteger HeadlessAudioDevice::getActiveInputChannels() const {
+    return activeInputs_;
+}
+
+int HeadlessAudioDevice::getOutputLatencyInSamples() {
+    return 0;
+}
+
+int HeadlessAudioDevice::getInputLatencyInSamples() {
+    return 0;
+}
+
+int HeadlessAudioDevice::getXRunCount() const noexcept {
+    return xruns_;
+}
+
+void HeadlessAudioDevice::timerThread() {
+    // Deadlines are absolute so scheduling jitter never accumulates into drift
+    auto period = std::chrono::nanoseconds(
+        static_cast<int64_t>(1.0e9 * bufferSize_ / sampleRate_));
+    auto nextTime = std::chrono::steady_clock::now();
+
+    while (playing_) {
+        readInput(bufferSize_);
+        outputBuffer_.clear();
+
+        uint64_t hostTimeNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(nextTime.time_since_epoch()).count());
+        juce::AudioIODeviceCallbackContext context;
+        context.hostTimeNs = &hostTimeNs;
+
+        callback_->audioDeviceIOCallbackWithContext(
+            inputBuffer_.getArrayOfReadPointers(), numInputs_,
+            outputBuffer_.getArrayOfWritePointers(), numOutputs_,
+            bufferSize_, context);
+
+        if (writer_) {
+            writer_->writeFromFloatArrays(outputBuffer_.getArrayOfReadPointers(), numOutputs_, bufferSize_);
+        }
+
+        callbackCount_++;
+
+        nextTime += period;
+        auto now = std::chrono::steady_clock::now();
+        if (nextTime > now) {
+            std::this_thread::sleep_until(nextTime);
+        } else {
+            // Missed the deadline, count it and restart the schedule from now
+            xruns_++;
+            nextTime = now;
+        }
+    }
+}
+
+void HeadlessAudioDevice::readInput(int numSamples) {
+    if (!reader_ || reader_->lengthInSamples <= 0) {
+        return;  // Input buffer stays silent
+    }
+
+    // Loop the file so arbitrarily long runs can be sourced from a short clip
+    int done = 0;
+    while (done < numSamples) {
+        auto remaining = reader_->lengthInSamples - readPosition_;
+        int toRead = static_cast<int>(std::min<int64_t>(numSamples - done, remaining));
+
+        reader_->read(&inputBuffer_, done, toRead, readPosition_, true, true);
+
+        done += toRead;
+        readPosition_ += toRead;
+        if (readPosition_ >= reader_->lengthInSamples) {
+            readPosition_ = 0;
+        }
+    }
+}
+
+HeadlessAudioDeviceType::HeadlessAudioDeviceType(const HeadlessOptions& options)
+    : juce::AudioIODeviceType(TYPE_NAME)
+    , options_(options) {
+}
+
+void HeadlessAudioDeviceType::scanForDevices() {
+}
+
+juce::StringArray HeadlessAudioDeviceType::getDeviceNames(bool /*wantInputNames*/) const {
+    juce::StringArray names;
+    names.add(DEVICE_NAME);
+    return names;
+}
+
+int HeadlessAudioDeviceType::getDefaultDeviceIndex(bool /*forInput*/) const {
+    return 0;
+}
+
+int HeadlessAudioDeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool /*asInput*/) const {
+    return dynamic_cast<HeadlessAudioDevice*>(device) != nullptr ? 0 : -1;
+}
+
+bool HeadlessAudioDeviceType::hasSeparateInputsAndOutputs() const {
+    return false;
+}
+
+juce::AudioIODevice* HeadlessAudioDeviceType::createDevice(const juce::String& outputDeviceName,
+                                                           const juce::String& inputDeviceName) {
+    if (outputDeviceName.isNotEmpty() && outputDeviceName != DEVICE_NAME) {
+        return nullptr;
+    }
+    if (inputDeviceName.isNotEmpty() && inputDeviceName != DEVICE_NAME) {
+        return nullptr;
+    }
+    return new HeadlessAudioDevice(DEVICE_NAME, TYPE_NAME, options_);
+}
+
+} // namespace audioserver
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace audioserver {
+
+struct HeadlessOptions {
+    std::string inputFile;   // WAV file looped as capture input (empty = silence)
+    std::string outputFile;  // WAV file receiving playback output (empty = discard)
+};
+
+// Virtual audio device for machines without sound cards. The audio callback is
+// driven from a timer thread at the configured buffer period instead of by
+// hardware, so the full capture/playback pipeline runs headless.
+class HeadlessAudioDevice : public juce::AudioIODevice {
+public:
+    static constexpr int MAX_CHANNELS = 64;
+
+    HeadlessAudioDevice(const juce::String& deviceName, const juce::String& typeName,
+                        const HeadlessOptions& options);
+    ~HeadlessAudioDevice() override;
+
+    juce::StringArray getOutputChannelNames() override;
+    juce::StringArray getInputChannelNames() override;
+    juce::Array<double> getAvailableSampleRates() override;
+    juce::Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override;
+
+    juce::String open(const juce::BigInteger& inputChannels,
+                      const juce::BigInteger& outputChannels,
+                      double sampleRate,
+                      int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override;
+
+    void start(juce::AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override;
+    juce::String getLastError() override;
+
+    int getCurrentBufferSizeSamples() override;
+    double getCurrentSampleRate() override;
+    int getCurrentBitDepth() override;
+
+    juce::BigInteger getActiveOutputChannels() const override;
+    juce::BigInteger getActiveInputChannels() const override;
+
+    int getOutputLatencyInSamples() override;
+    int getInputLatencyInSamples() override;
+
+    // Number of periods where the timer thread woke up too late to keep pace
+    int getXRunCount() const noexcept override;
+
+    uint64_t getCallbackCount() const { return callbackCount_; }
+
+private:
+    void timerThread();
+    void readInput(int numSamples);
+
+    HeadlessOptions options_;
+
+    juce::BigInteger activeInputs_;
+    juce::BigInteger activeOutputs_;
+    int numInputs_ = 0;
+    int numOutputs_ = 0;
+    double sampleRate_ = 48000.0;
+    int bufferSize_ = 512;
+    bool open_ = false;
+    juce::String lastError_;
+
+    std::unique_ptr<juce::AudioFormatReader> reader_;
+    std::unique_ptr<juce::AudioFormatWriter> writer_;
+    int64_t readPosition_ = 0;
+
+    juce::AudioBuffer<float> inputBuffer_;
+    juce::AudioBuffer<float> outputBuffer_;
+
+    juce::AudioIODeviceCallback* callback_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> playing_{false};
+    std::atomic<uint64_t> callbackCount_{0};
+    std::atomic<int> xruns_{0};
+};
+
+// Device type exposing a single headless device. When registered before the
+// device manager first scans, the platform device types are never created.
+class HeadlessAudioDeviceType : public juce::AudioIODeviceType {
+public:
+    static constexpr const char* TYPE_NAME = "Headless";
+    static constexpr const char* DEVICE_NAME = "Headless";
+
+    explicit HeadlessAudioDeviceType(const HeadlessOptions& options);
+
+    void scanForDevices() override;
+    juce::StringArray getDeviceNames(bool wantInputNames) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override;
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName,
+                                      const juce::String& inputDeviceName) override;
+
+private:
+    HeadlessOptions options_;
+};
+
+} // namespace audioserver
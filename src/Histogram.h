@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace audioserver {
+
+// Log-linear histogram for timing values (HDR style). Each power of two is
+// split into SUB_BUCKETS linear buckets, giving ~6% relative resolution from
+// 1 up to 2^MAX_MAGNITUDE with a fixed footprint and no allocation.
+//
+// record() is wait-free and must only be called from a single writer thread
+// (the audio callback); it uses plain atomic loads/stores, no locked
+// read-modify-write. Any thread may read a snapshot concurrently.
+class Histogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_MAGNITUDE = 40;
+    static constexpr int NUM_BUCKETS = (MAX_MAGNITUDE - SUB_BITS + 1) * SUB_BUCKETS;
+    static constexpr uint64_t MAX_VALUE = (uint64_t{1} << MAX_MAGNITUDE) - 1;
+
+    struct Snapshot {
+        std::array<uint64_t, NUM_BUCKETS> buckets{};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        // Upper bound of the bucket containing the given quantile (0..1), capped at max
+        uint64_t percentile(double quantile) const {
+            if (count == 0) {
+                return 0;
+            }
+            auto target = static_cast<uint64_t>(quantile * static_cast<double>(count));
+            if (target == 0) {
+                target = 1;
+            }
+            uint64_t seen = 0;
+            for (int i = 0; i < NUM_BUCKETS; ++i) {
+                seen += buckets[static_cast<size_t>(i)];
+                if (seen >= target) {
+                    uint64_t upper = bucketUpperBound(i);
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+
+        double mean() const {
+            return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+        }
+    };
+
+    void record(uint64_t value) {
+        if (value > MAX_VALUE) {
+            value = MAX_VALUE;
+        }
+        auto& bucket = buckets_[static_cast<size_t>(bucketIndex(value))];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+        // Published last so readers see at least this many bucket entries
+        count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snap;
+        snap.count = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        snap.sum = sum_.load(std::memory_order_relaxed);
+        snap.max = max_.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+    static int bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int msb = 63 - countLeadingZeros(value);
+        int shift = msb - SUB_BITS;
+        auto sub = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t bucketUpperBound(int index) {
+        int shift = index / SUB_BUCKETS - 1;
+        if (shift < 0) {
+            return static_cast<uint64_t>(index);
+        }
+        auto sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+        uint64_t low = (SUB_BUCKETS + sub) << shift;
+        return low + (uint64_t{1} << shift) - 1;
+    }
+
+private:
+    static int countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(value);
+#else
+        int n = 0;
+        for (uint64_t bit = uint64_t{1} << 63; (value & bit) == 0; bit >>= 1) {
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace audioserver
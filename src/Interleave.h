@@ -0,0 +1,23 @@
+#pragma once
+
+namespace audioserver {
+
+// Planar (one buffer per channel) to interleaved frames, as sent on the wire
+inline void interleave(const float* const* channelData, int numChannels, int numSamples, float* dest) {
+    for (int i = 0; i < numSamples; ++i) {
+        for (int ch = 0; ch < numChannels; ++ch) {
+            dest[i * numChannels + ch] = channelData[ch][i];
+        }
+    }
+}
+
+// Interleaved frames back to planar buffers, as the audio device expects
+inline void deinterleave(const float* src, int numChannels, int numSamples, float* const* channelData) {
+    for (int i = 0; i < numSamples; ++i) {
+        for (int ch = 0; ch < numChannels; ++ch) {
+            channelData[ch][i] = src[i * numChannels + ch];
+        }
+    }
+}
+
+} // namespace audioserver
@@ -1,182 +1,218 @@
 #pragma once
 
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <string>
-#include <sstream>
-#include <vector>
-#include <utility>
+#include <string_view>
+#include <type_traits>
 
 namespace audioserver {
 
+// Streaming JSON writer appending straight into one reserved buffer.
+//
+// Keys and strings are escaped in place, numbers are formatted with
+// std::to_chars (shortest round-trip form for doubles; non-finite doubles
+// become null) and comma state is a single flag, so building a document
+// performs no allocations beyond growing the buffer. build() hands the
+// buffer over; clear() keeps its capacity for reuse.
 class JsonBuilder {
 public:
+    static constexpr size_t DEFAULT_RESERVE = 512;
+
+    JsonBuilder() {
+        buffer_.reserve(DEFAULT_RESERVE);
+    }
+
+    explicit JsonBuilder(size_t reserveBytes) {
+        buffer_.reserve(reserveBytes);
+    }
+
     JsonBuilder& beginObject() {
-        append("{");
-        depth_++;
-        needsComma_.push_back(false);
+        maybeComma();
+        buffer_ += '{';
+        needsComma_ = false;
         return *this;
     }
 
     JsonBuilder& endObject() {
-        depth_--;
-        needsComma_.pop_back();
-        append("}");
-        markNeedsComma();
+        buffer_ += '}';
+        needsComma_ = true;
         return *this;
     }
 
     JsonBuilder& beginArray() {
-        append("[");
-        depth_++;
-        needsComma_.push_back(false);
+        maybeComma();
+        buffer_ += '[';
+        needsComma_ = false;
         return *this;
     }
 
     JsonBuilder& endArray() {
-        depth_--;
-        needsComma_.pop_back();
-        append("]");
-        markNeedsComma();
+        buffer_ += ']';
+        needsComma_ = true;
         return *this;
     }
 
-    JsonBuilder& key(const std::string& k) {
+    JsonBuilder& key(std::string_view k) {
         maybeComma();
-        append("\"" + escape(k) + "\":");
+        appendString(k);
+        buffer_ += ':';
+        needsComma_ = false;
         return *this;
     }
 
-    JsonBuilder& value(const std::string& v) {
+    JsonBuilder& value(std::string_view v) {
         maybeComma();
-        append("\"" + escape(v) + "\"");
-        markNeedsComma();
+        appendString(v);
+        needsComma_ = true;
         return *this;
     }
 
+    // Without this, string literals would convert to bool before string_view
     JsonBuilder& value(const char* v) {
-        return value(std::string(v));
+        return value(std::string_view(v));
     }
 
-    JsonBuilder& value(int v) {
-        maybeComma();
-        append(std::to_string(v));
-        markNeedsComma();
-        return *this;
+    JsonBuilder& value(const std::string& v) {
+        return value(std::string_view(v));
     }
 
-    JsonBuilder& value(uint32_t v) {
-        maybeComma();
-        append(std::to_string(v));
-        markNeedsComma();
-        return *this;
-    }
+    // Every integer type, so size_t, long and long long never depend on
+    // which fixed-width type the platform aliases them to
+    template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>
+                                          && !std::is_same_v<T, char>, int> = 0>
+    JsonBuilder& value(T v) { return number(v); }
 
-    JsonBuilder& value(uint16_t v) {
-        maybeComma();
-        append(std::to_string(v));
-        markNeedsComma();
-        return *this;
-    }
+    JsonBuilder& value(float v) { return number(v); }
+    JsonBuilder& value(double v) { return number(v); }
 
     JsonBuilder& value(bool v) {
         maybeComma();
-        append(v ? "true" : "false");
-        markNeedsComma();
+        buffer_ += v ? "true" : "false";
+        needsComma_ = true;
         return *this;
     }
 
-    JsonBuilder& value(double v) {
+    JsonBuilder& null() {
         maybeComma();
-        append(std::to_string(v));
-        markNeedsComma();
+        buffer_ += "null";
+        needsComma_ = true;
         return *this;
     }
 
-    JsonBuilder& keyValue(const std::string& k, const std::string& v) {
+    template<typename T>
+    JsonBuilder& keyValue(std::string_view k, const T& v) {
         key(k);
-        append("\"" + escape(v) + "\"");
-        markNeedsComma();
-        return *this;
+        return value(v);
     }
 
-    JsonBuilder& keyValue(const std::string& k, const char* v) {
-        return keyValue(k, std::string(v));
+    // Hands the document over and leaves the builder empty
+    std::string build() {
+        std::string result = std::move(buffer_);
+        buffer_.clear();
+        needsComma_ = false;
+        return result;
     }
 
-    JsonBuilder& keyValue(const std::string& k, int v) {
-        key(k);
-        append(std::to_string(v));
-        markNeedsComma();
-        return *this;
-    }
+    const std::string& str() const { return buffer_; }
 
-    JsonBuilder& keyValue(const std::string& k, uint32_t v) {
-        key(k);
-        append(std::to_string(v));
-        markNeedsComma();
-        return *this;
+    // Starts a new document, keeping the buffer's capacity
+    void clear() {
+        buffer_.clear();
+        needsComma_ = false;
     }
 
-    JsonBuilder& keyValue(const std::string& k, uint16_t v) {
-        key(k);
-        append(std::to_string(v));
-        markNeedsComma();
-        return *this;
-    }
+    void reserve(size_t bytes) { buffer_.reserve(bytes); }
 
-    JsonBuilder& keyValue(const std::string& k, bool v) {
-        key(k);
-        append(v ? "true" : "false");
-        markNeedsComma();
-        return *this;
+private:
+    void maybeComma() {
+        if (needsComma_) {
+            buffer_ += ',';
+        }
     }
 
-    JsonBuilder& keyValue(const std::string& k, double v) {
-        key(k);
-        append(std::to_string(v));
-        markNeedsComma();
+    template<typename T>
+    JsonBuilder& number(T v) {
+        maybeComma();
+        appendNumber(v);
+        needsComma_ = true;
         return *this;
     }
 
-    std::string build() const {
-        return ss_.str();
-    }
-
-private:
-    void append(const std::string& s) {
-        ss_ << s;
+    template<typename T>
+    void appendNumber(T v) {
+        static_assert(std::is_integral_v<T>, "floating point has its own overload");
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), v);
+        buffer_.append(digits, result.ptr);
     }
 
-    void maybeComma() {
-        if (!needsComma_.empty() && needsComma_.back()) {
-            append(",");
-            needsComma_.back() = false;
+    // Floats keep their own shortest form (-6.02, not -6.019999980926514)
+    template<typename T>
+    void appendFloatingPoint(T v) {
+        if (!std::isfinite(v)) {
+            buffer_ += "null";  // JSON has no NaN or Infinity
+            return;
         }
-    }
 
-    void markNeedsComma() {
-        if (!needsComma_.empty()) {
-            needsComma_.back() = true;
+        char digits[32];
+#ifdef __cpp_lib_to_chars
+        auto result = std::to_chars(digits, digits + sizeof(digits), v);
+        buffer_.append(digits, result.ptr);
+#else
+        // Standard libraries without floating-point to_chars: shortest of
+        // the two precisions that round-trips
+        constexpr int shortPrecision = std::is_same_v<T, float> ? 6 : 15;
+        constexpr int fullPrecision = std::is_same_v<T, float> ? 9 : 17;
+        int length = std::snprintf(digits, sizeof(digits), "%.*g", shortPrecision, static_cast<double>(v));
+        if (static_cast<T>(std::strtod(digits, nullptr)) != v) {
+            length = std::snprintf(digits, sizeof(digits), "%.*g", fullPrecision, static_cast<double>(v));
         }
+        buffer_.append(digits, static_cast<size_t>(length));
+#endif
     }
 
-    std::string escape(const std::string& s) {
-        std::string result;
-        for (char c : s) {
+    void appendNumber(float v) { appendFloatingPoint(v); }
+    void appendNumber(double v) { appendFloatingPoint(v); }
+
+    void appendString(std::string_view s) {
+        static constexpr char hex[] = "0123456789abcdef";
+
+        buffer_ += '"';
+        size_t runStart = 0;
+        for (size_t i = 0; i < s.size(); ++i) {
+            auto c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+
+            // Copy the clean run, then the escape
+            buffer_.append(s.data() + runStart, i - runStart);
+            runStart = i + 1;
             switch (c) {
-                case '"': result += "\\\""; break;
-                case '\\': result += "\\\\"; break;
-                case '\n': result += "\\n"; break;
-                case '\r': result += "\\r"; break;
-                case '\t': result += "\\t"; break;
-                default: result += c; break;
+                case '"': buffer_ += "\\\""; break;
+                case '\\': buffer_ += "\\\\"; break;
+                case '\b': buffer_ += "\\b"; break;
+                case '\f': buffer_ += "\\f"; break;
+                case '\n': buffer_ += "\\n"; break;
+                case '\r': buffer_ += "\\r"; break;
+                case '\t': buffer_ += "\\t"; break;
+                default: {
+                    char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F]};
+                    buffer_.append(escaped, sizeof(escaped));
+                    break;
+                }
             }
         }
-        return result;
+        buffer_.append(s.data() + runStart, s.size() - runStart);
+        buffer_ += '"';
     }
 
-    std::stringstream ss_;
-    int depth_ = 0;
-    std::vector<bool> needsComma_;
+    std::string buffer_;
+    bool needsComma_ = false;
 };
 
 } // namespace audioserver
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace audioserver {
+
+// Reads the flat JSON objects the API takes as request bodies
+// ({"sampleRate": 48000, "routes": "0-1:8-9"}), JsonBuilder's counterpart.
+//
+// The whole document is validated, but only the top-level members are
+// kept: strings unescaped, numbers and literals as written, nested objects
+// and arrays as their raw JSON. Keys are matched exactly, so a key that also
+// appears as a value or inside another key is never mistaken for the field.
+class JsonReader {
+public:
+    static constexpr int MAX_DEPTH = 32;
+
+    enum class Type { String, Number, Bool, Null, Object, Array };
+
+    struct Value {
+        Type type = Type::Null;
+        std::string text;
+    };
+
+    // Fails unless text is exactly one JSON object (whitespace aside)
+    bool parse(std::string_view text, std::string& error) {
+        text_ = text;
+        pos_ = 0;
+        members_.clear();
+
+        skipWhitespace();
+        if (!peek('{')) {
+            error = "Expected a JSON object";
+            return false;
+        }
+        Value root;
+        if (!parseValue(root, 0, true)) {
+            error = error_ + " at offset " + std::to_string(pos_);
+            members_.clear();
+            return false;
+        }
+        skipWhitespace();
+        if (pos_ != text_.size()) {
+            error = "Unexpected data after the object at offset " + std::to_string(pos_);
+            members_.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // The member named key (the last one if repeated), or null
+    const Value* find(std::string_view key) const {
+        for (auto it = members_.rbegin(); it != members_.rend(); ++it) {
+            if (it->first == key) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const { return members_.size(); }
+
+private:
+    bool fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+
+    bool peek(char c) const { return pos_ < text_.size() && text_[pos_] == c; }
+
+    void skipWhitespace() {
+        while (pos_ < text_.size()
+               && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            pos_++;
+        }
+    }
+
+    // top: members of this object are the ones kept
+    bool parseValue(Value& value, int depth, bool top = false) {
+        if (depth > MAX_DEPTH) {
+            return fail("Nested too deeply");
+        }
+        skipWhitespace();
+        if (pos_ >= text_.size()) {
+            return fail("Unexpected end of input");
+        }
+
+        size_t start = pos_;
+        char c = text_[pos_];
+        if (c == '{') {
+            value.type = Type::Object;
+            if (!parseObject(depth, top)) {
+                return false;
+            }
+        } else if (c == '[') {
+            value.type = Type::Array;
+            if (!parseArray(depth)) {
+                return false;
+            }
+        } else if (c == '"') {
+            value.type = Type::String;
+            return parseString(value.text);
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            return parseLiteral(value);
+        } else {
+            value.type = Type::Number;
+            if (!parseNumber()) {
+                return false;
+            }
+        }
+        value.text.assign(text_.substr(start, pos_ - start));
+        return true;
+    }
+
+    bool parseObject(int depth, bool top) {
+        pos_++;  // {
+        skipWhitespace();
+        if (peek('}')) {
+            pos_++;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            std::string key;
+            if (!peek('"')) {
+                return fail("Expected a string key");
+            }
+            if (!parseString(key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (!peek(':')) {
+                return fail("Expected ':'");
+            }
+            pos_++;
+
+            Value member;
+            if (!parseValue(member, depth + 1)) {
+                return false;
+            }
+            if (top) {
+                members_.emplace_back(std::move(key), std::move(member));
+            }
+
+            skipWhitespace();
+            if (peek(',')) {
+                pos_++;
+            } else if (peek('}')) {
+                pos_++;
+                return true;
+            } else {
+                return fail("Expected ',' or '}'");
+            }
+        }
+    }
+
+    bool parseArray(int depth) {
+        pos_++;  // [
+        skipWhitespace();
+        if (peek(']')) {
+            pos_++;
+            return true;
+        }
+        while (true) {
+            Value element;
+            if (!parseValue(element, depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (peek(',')) {
+                pos_++;
+            } else if (peek(']')) {
+                pos_++;
+                return true;
+            } else {
+                return fail("Expected ',' or ']'");
+            }
+        }
+    }
+
+    bool parseLiteral(Value& value) {
+        for (const char* literal : {"true", "false", "null"}) {
+            std::string_view word(literal);
+            if (text_.substr(pos_, word.size()) == word) {
+                pos_ += word.size();
+                value.type = word == "null" ? Type::Null : Type::Bool;
+                value.text.assign(word);
+                return true;
+            }
+        }
+        return fail("Unexpected character");
+    }
+
+    bool parseNumber() {
+        auto digits = [this] {
+            size_t start = pos_;
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+                pos_++;
+            }
+            return pos_ - start;
+        };
+
+        if (peek('-')) {
+            pos_++;
+        }
+        if (peek('0')) {
+            pos_++;
+        } else if (digits() == 0) {
+            return fail("Invalid number");
+        }
+        if (peek('.')) {
+            pos_++;
+            if (digits() == 0) {
+                return fail("Invalid number");
+            }
+        }
+        if (peek('e') || peek('E')) {
+            pos_++;
+            if (peek('+') || peek('-')) {
+                pos_++;
+            }
+            if (digits() == 0) {
+                return fail("Invalid number");
+            }
+        }
+        return true;
+    }
+
+    bool parseHex4(uint32_t& code) {
+        if (pos_ + 4 > text_.size()) {
+            return fail("Truncated \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text_[pos_++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return fail("Invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        pos_++;  // "
+        out.clear();
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '"') {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("Control character in string");
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                break;
+            }
+            char escape = text_[pos_++];
+            switch (escape) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    uint32_t code = 0;
+                    if (!parseHex4(code)) {
+                        return false;
+                    }
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        // High surrogate; the low half must follow
+                        uint32_t low = 0;
+                        if (text_.substr(pos_, 2) != "\\u") {
+                            return fail("Unpaired surrogate");
+                        }
+                        pos_ += 2;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            return fail("Unpaired surrogate");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xDC00 && code < 0xE000) {
+                        return fail("Unpaired surrogate");
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape");
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::string error_;
+    std::vector<std::pair<std::string, Value>> members_;
+};
+
+} // namespace audioserver
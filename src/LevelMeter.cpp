@@ -0,0 +1,192 @@
+#include "LevelMeter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audioserver {
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    // Largest |x| in the block. Eight independent lanes let the compiler
+    // vectorize the reduction without -ffast-math.
+    float peakOf(const float* samples, int numSamples) {
+        float lanes[8] = {};
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8) {
+            for (int l = 0; l < 8; ++l) {
+                lanes[l] = std::max(lanes[l], std::fabs(samples[i + l]));
+            }
+        }
+        float peak = 0.0f;
+        for (float lane : lanes) {
+            peak = std::max(peak, lane);
+        }
+        for (; i < numSamples; ++i) {
+            peak = std::max(peak, std::fabs(samples[i]));
+        }
+        return peak;
+    }
+
+    // Sum of x^2 over the block, laned like peakOf
+    float sumOfSquares(const float* samples, int numSamples) {
+        float lanes[8] = {};
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8) {
+            for (int l = 0; l < 8; ++l) {
+                lanes[l] += samples[i + l] * samples[i + l];
+            }
+        }
+        float sum = 0.0f;
+        for (float lane : lanes) {
+            sum += lane;
+        }
+        for (; i < numSamples; ++i) {
+            sum += samples[i] * samples[i];
+        }
+        return sum;
+    }
+}
+
+LevelMeter::LevelMeter()
+    : scratch_(static_cast<size_t>(SCRATCH_SAMPLES + HISTORY), 0.0f)
+    , interpolated_(static_cast<size_t>(SCRATCH_SAMPLES), 0.0f) {
+    // Blackman-windowed sinc prototype split into OVERSAMPLING phases. With
+    // an odd length centred on a tap, the last phase is a pure delay (the
+    // original samples, already covered by the sample peak) and is skipped.
+    constexpr int taps = OVERSAMPLING * TAPS_PER_PHASE - 1;
+    constexpr int center = (taps - 1) / 2;
+    static_assert(center % OVERSAMPLING == OVERSAMPLING - 1, "identity phase must be the last one");
+    for (int n = 0; n < taps; ++n) {
+        double x = static_cast<double>(n - center) / OVERSAMPLING;
+        double sinc = n == center ? 1.0 : std::sin(PI * x) / (PI * x);
+        double window = 0.42 - 0.5 * std::cos(2.0 * PI * n / (taps - 1))
+                      + 0.08 * std::cos(4.0 * PI * n / (taps - 1));
+        phases_[static_cast<size_t>(n % OVERSAMPLING)][static_cast<size_t>(n / OVERSAMPLING)] =
+            static_cast<float>(sinc * window);
+    }
+
+    // Unity DC gain per phase
+    for (auto& phase : phases_) {
+        float sum = 0.0f;
+        for (float c : phase) {
+            sum += c;
+        }
+        for (float& c : phase) {
+            c /= sum;
+        }
+    }
+
+    prepare(48000.0);
+}
+
+void LevelMeter::prepare(double sampleRate) {
+    windowLength_ = std::max<int64_t>(1, static_cast<int64_t>(sampleRate * WINDOW_SECONDS));
+    holdLength_ = static_cast<int64_t>(sampleRate * PEAK_HOLD_SECONDS);
+    windowSamples_ = 0;
+    windowChannels_ = 0;
+    windowPeak_.fill(0.0f);
+    windowTruePeak_.fill(0.0f);
+    windowSumSquares_.fill(0.0);
+    holdPeak_.fill(0.0f);
+    holdRemaining_.fill(0);
+    for (auto& h : history_) {
+        h.fill(0.0f);
+    }
+}
+
+void LevelMeter::process(const float* const* channelData, int numChannels, int numSamples) {
+    numChannels = std::min(numChannels, MAX_CHANNELS);
+    windowChannels_ = std::max(windowChannels_, numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        auto c = static_cast<size_t>(ch);
+        const float* samples = channelData[ch];
+
+        windowPeak_[c] = std::max(windowPeak_[c], peakOf(samples, numSamples));
+        windowSumSquares_[c] += sumOfSquares(samples, numSamples);
+        windowTruePeak_[c] = std::max(windowTruePeak_[c], processTruePeak(ch, samples, numSamples));
+    }
+
+    windowSamples_ += numSamples;
+    if (windowSamples_ >= windowLength_) {
+        publish();
+    }
+}
+
+float LevelMeter::processTruePeak(int channel, const float* samples, int numSamples) {
+    auto& history = history_[static_cast<size_t>(channel)];
+    float peak = 0.0f;
+
+    for (int offset = 0; offset < numSamples; offset += SCRATCH_SAMPLES) {
+        int n = std::min(SCRATCH_SAMPLES, numSamples - offset);
+
+        // Contiguous [previous HISTORY samples | this chunk] so the FIR never wraps
+        std::copy(history.begin(), history.end(), scratch_.begin());
+        std::copy(samples + offset, samples + offset + n, scratch_.begin() + HISTORY);
+
+        for (int p = 0; p < OVERSAMPLING - 1; ++p) {
+            const auto& phase = phases_[static_cast<size_t>(p)];
+            float* out = interpolated_.data();
+            std::fill(out, out + n, 0.0f);
+
+            // Tap-major so the inner loop is a straight vectorizable multiply-add
+            for (int k = 0; k < TAPS_PER_PHASE; ++k) {
+                const float coeff = phase[static_cast<size_t>(k)];
+                const float* in = scratch_.data() + HISTORY - k;
+                for (int i = 0; i < n; ++i) {
+                    out[i] += coeff * in[i];
+                }
+            }
+            peak = std::max(peak, peakOf(out, n));
+        }
+
+        std::copy(scratch_.begin() + n, scratch_.begin() + n + HISTORY, history.begin());
+    }
+
+    return peak;
+}
+
+void LevelMeter::publish() {
+    window_.version++;
+    window_.numChannels = windowChannels_;
+
+    for (int ch = 0; ch < windowChannels_; ++ch) {
+        auto c = static_cast<size_t>(ch);
+        float rms = static_cast<float>(std::sqrt(windowSumSquares_[c] / static_cast<double>(windowSamples_)));
+        float peak = windowPeak_[c];
+
+        holdRemaining_[c] -= windowSamples_;
+        if (peak >= holdPeak_[c] || holdRemaining_[c] <= 0) {
+            holdPeak_[c] = peak;
+            holdRemaining_[c] = holdLength_;
+        }
+
+        auto& levels = window_.channels[c];
+        levels.peak = peak;
+        levels.rms = rms;
+        levels.peakHold = holdPeak_[c];
+        levels.truePeak = std::max(windowTruePeak_[c], peak);
+
+        windowPeak_[c] = 0.0f;
+        windowTruePeak_[c] = 0.0f;
+        windowSumSquares_[c] = 0.0;
+    }
+
+    published_.store(window_);
+    windowSamples_ = 0;
+    windowChannels_ = 0;
+}
+
+LevelMeter::Snapshot LevelMeter::snapshot() const {
+    return published_.load();
+}
+
+float LevelMeter::toDecibels(float linear) {
+    constexpr float floorDb = -120.0f;
+    if (linear <= 0.0f) {
+        return floorDb;
+    }
+    return std::max(floorDb, 20.0f * std::log10(linear));
+}
+
+} // namespace audioserver
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SeqLock.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace audioserver {
+
+// Per-channel level meter fed from the audio callback.
+//
+// process() accumulates peak, mean square and an oversampled true-peak
+// estimate over a short window, then publishes the window as a Snapshot
+// through a SeqLock. It never allocates or locks, and readers never block
+// the audio thread.
+//
+// process() must only be called from one thread at a time.
+class LevelMeter {
+public:
+    static constexpr int MAX_CHANNELS = 64;
+    static constexpr double WINDOW_SECONDS = 0.05;
+    static constexpr double PEAK_HOLD_SECONDS = 2.0;
+
+    // True-peak: 4x oversampling through a 47-tap windowed-sinc interpolator
+    static constexpr int OVERSAMPLING = 4;
+    static constexpr int TAPS_PER_PHASE = 12;
+
+    struct ChannelLevels {
+        float peak = 0.0f;      // Linear sample peak over the last window
+        float rms = 0.0f;       // Linear RMS over the last window
+        float peakHold = 0.0f;  // Highest peak in the last PEAK_HOLD_SECONDS
+        float truePeak = 0.0f;  // Linear inter-sample peak estimate over the last window
+    };
+
+    struct Snapshot {
+        uint64_t version = 0;  // 0 = nothing published yet
+        int numChannels = 0;
+        std::array<ChannelLevels, MAX_CHANNELS> channels{};
+    };
+
+    LevelMeter();
+
+    // Call before audio starts flowing (not concurrently with process())
+    void prepare(double sampleRate);
+
+    void process(const float* const* channelData, int numChannels, int numSamples);
+
+    Snapshot snapshot() const;
+
+    static float toDecibels(float linear);
+
+private:
+    static constexpr int SCRATCH_SAMPLES = 1024;
+    static constexpr int HISTORY = TAPS_PER_PHASE - 1;
+
+    float processTruePeak(int channel, const float* samples, int numSamples);
+    void publish();
+
+    // Audio-thread state
+    std::array<std::array<float, TAPS_PER_PHASE>, OVERSAMPLING> phases_{};
+    std::array<std::array<float, HISTORY>, MAX_CHANNELS> history_{};
+    std::vector<float> scratch_;
+    std::vector<float> interpolated_;
+    std::array<float, MAX_CHANNELS> windowPeak_{};
+    std::array<float, MAX_CHANNELS> windowTruePeak_{};
+    std::array<double, MAX_CHANNELS> windowSumSquares_{};
+    std::array<float, MAX_CHANNELS> holdPeak_{};
+    std::array<int64_t, MAX_CHANNELS> holdRemaining_{};
+    int windowChannels_ = 0;
+    int64_t windowSamples_ = 0;
+    int64_t windowLength_ = 2400;
+    int64_t holdLength_ = 96000;
+
+    Snapshot window_;  // The next snapshot, filled in by publish()
+    SeqLock<Snapshot> published_;
+};
+
+} // namespace audioserver
@@ -0,0 +1,114 @@
+#include "ListenTap.h"
+#include "Interleave.h"
+#include <algorithm>
+#include <thread>
+
+namespace audioserver {
+
+namespace {
+    size_t queueCapacity(double sampleRate, int channels) {
+        // Never smaller than one maximal push, or large device buffers at low
+        // rates could not be queued at all
+        auto frames = std::max(static_cast<size_t>(sampleRate * ListenTap::QUEUE_MS / 1000),
+                               static_cast<size_t>(ListenTap::MAX_PUSH_FRAMES));
+        return frames * static_cast<size_t>(channels) + 1;  // RingBuffer keeps one slot free
+    }
+}
+
+ListenTap::Listener::Listener(double sampleRate, int channels)
+    : sampleRate_(sampleRate)
+    , channels_(channels)
+    , queue_(queueCapacity(sampleRate, channels)) {
+}
+
+ListenTap::ListenTap()
+    : scratch_(static_cast<size_t>(MAX_PUSH_FRAMES) * MAX_CHANNELS) {
+}
+
+ListenTap::~ListenTap() = default;
+
+void ListenTap::prepare(double sampleRate) {
+    sampleRate_.store(static_cast<uint32_t>(sampleRate), std::memory_order_relaxed);
+}
+
+void ListenTap::push(const float* const* channelData, int numChannels, int numSamples) {
+    numChannels = std::min(numChannels, MAX_CHANNELS);
+    channels_.store(numChannels, std::memory_order_relaxed);
+    if (listenerCount_.load(std::memory_order_relaxed) == 0 || numChannels <= 0) {
+        return;
+    }
+
+    pushing_.store(true);  // seq_cst, paired with unsubscribe()
+    const uint32_t sampleRate = sampleRate_.load(std::memory_order_relaxed);
+
+    for (int offset = 0; offset < numSamples; offset += MAX_PUSH_FRAMES) {
+        int frames = std::min(numSamples - offset, MAX_PUSH_FRAMES);
+        const float* inputs[MAX_CHANNELS];
+        for (int ch = 0; ch < numChannels; ++ch) {
+            inputs[ch] = channelData[ch] + offset;
+        }
+        interleave(inputs, numChannels, frames, scratch_.data());
+
+        const size_t total = static_cast<size_t>(frames) * static_cast<size_t>(numChannels);
+        for (auto& slot : slots_) {
+            Listener* listener = slot.load();
+            if (!listener || listener->dropped_.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            if (listener->channels_ != numChannels
+                || static_cast<uint32_t>(listener->sampleRate_) != sampleRate
+                || listener->queue_.available() < total) {
+                drop(*listener);
+                continue;
+            }
+            listener->queue_.write(scratch_.data(), total);
+        }
+    }
+
+    pushing_.store(false, std::memory_order_release);
+}
+
+void ListenTap::drop(Listener& listener) {
+    listener.dropped_.store(true, std::memory_order_release);
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<ListenTap::Listener> ListenTap::subscribe() {
+    uint32_t sampleRate = sampleRate_.load(std::memory_order_relaxed);
+    int channels = channels_.load(std::memory_order_relaxed);
+    if (sampleRate == 0 || channels <= 0) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Listener> listener(new Listener(sampleRate, channels));
+    for (auto& slot : slots_) {
+        Listener* empty = nullptr;
+        if (slot.compare_exchange_strong(empty, listener.get())) {
+            listenerCount_.fetch_add(1, std::memory_order_relaxed);
+            return listener;
+        }
+    }
+    return nullptr;
+}
+
+void ListenTap::unsubscribe(const std::shared_ptr<Listener>& listener) {
+    for (auto& slot : slots_) {
+        Listener* expected = listener.get();
+        if (slot.compare_exchange_strong(expected, nullptr)) {
+            listenerCount_.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    // A push that loaded the slot before it was cleared may still be writing
+    while (pushing_.load()) {
+        std::this_thread::yield();
+    }
+}
+
+size_t ListenTap::read(Listener& listener, float* dest, size_t maxFrames) {
+    const auto channels = static_cast<size_t>(listener.channels_);
+    return listener.queue_.read(dest, maxFrames * channels) / channels;
+}
+
+} // namespace audioserver
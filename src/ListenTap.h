@@ -0,0 +1,86 @@
+#pragma once
+
+#include "RingBuffer.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace audioserver {
+
+// Copies the audio path out to a handful of live listeners (GET /listen).
+//
+// Each listener owns a small queue holding QUEUE_MS of interleaved audio.
+// push() runs on the audio thread: with nobody listening it returns at once,
+// otherwise it interleaves the block once and appends it to every queue. A
+// listener whose queue is too full to take the block is marked dropped and
+// skipped from then on, so a slow client never holds up playback; its HTTP
+// worker sees the flag and ends the stream. A change of sample rate or
+// channel count drops every listener, since their headers no longer match.
+//
+// push() must only be called from one thread at a time; the rest may be
+// called from any thread.
+class ListenTap {
+public:
+    static constexpr size_t MAX_LISTENERS = 8;
+    static constexpr int QUEUE_MS = 500;
+    static constexpr int MAX_CHANNELS = 64;
+    static constexpr int MAX_PUSH_FRAMES = 8192;
+
+    class Listener {
+    public:
+        double sampleRate() const { return sampleRate_; }
+        int channels() const { return channels_; }
+        bool dropped() const { return dropped_.load(std::memory_order_acquire); }
+
+    private:
+        friend class ListenTap;
+
+        Listener(double sampleRate, int channels);
+
+        double sampleRate_;
+        int channels_;
+        RingBuffer<float> queue_;
+        std::atomic<bool> dropped_{false};
+    };
+
+    ListenTap();
+    ~ListenTap();
+
+    ListenTap(const ListenTap&) = delete;
+    ListenTap& operator=(const ListenTap&) = delete;
+
+    // Called before the device starts calling back (any thread)
+    void prepare(double sampleRate);
+
+    void push(const float* const* channelData, int numChannels, int numSamples);
+
+    // A listener for the format currently flowing. Null when MAX_LISTENERS
+    // are already connected or no audio has passed yet.
+    std::shared_ptr<Listener> subscribe();
+    void unsubscribe(const std::shared_ptr<Listener>& listener);
+
+    // Moves up to maxFrames queued frames (interleaved) to dest
+    size_t read(Listener& listener, float* dest, size_t maxFrames);
+
+    size_t listenerCount() const { return listenerCount_.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void drop(Listener& listener);
+
+    std::array<std::atomic<Listener*>, MAX_LISTENERS> slots_{};
+    std::atomic<size_t> listenerCount_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    // unsubscribe() waits for pushing_ to clear after emptying a slot, so a
+    // listener is never freed under a push in flight
+    std::atomic<bool> pushing_{false};
+    std::vector<float> scratch_;  // Audio thread only
+
+    std::atomic<uint32_t> sampleRate_{0};
+    std::atomic<int> channels_{0};  // Of the last push
+};
+
+} // namespace audioserver
@@ -1,37 +1,121 @@
 #include "Config.h"
 #include "AudioEngine.h"
 #include "ApiServer.h"
-#include "RingBuffer.h"
-#include "ToneGenerator.h"
-#include "transport/TcpPcmBackend.h"
+#include "StreamManager.h"
+#include "ThreadPolicy.h"
+#include "transport/EventLoop.h"
 #include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
 #include <iostream>
 #include <csignal>
 #include <atomic>
-#include <thread>
 #include <chrono>
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
 namespace {
     std::atomic<bool> g_running{true};
+
+#ifndef _WIN32
+    // Self-pipe: the handler only writes a byte, the event loop does the rest
+    int g_signalPipe[2] = {-1, -1};
+#endif
 }
 
 void signalHandler(int) {
     g_running = false;
+#ifndef _WIN32
+    char byte = 0;
+    [[maybe_unused]] auto written = write(g_signalPipe[1], &byte, 1);
+#endif
+}
+
+std::string stateToString(audioserver::TransportState state) {
+    switch (state) {
+        case audioserver::TransportState::Disconnected: return "disconnected";
+        case audioserver::TransportState::Connecting: return "connecting";
+        case audioserver::TransportState::Connected: return "connected";
+        case audioserver::TransportState::Streaming: return "streaming";
+        case audioserver::TransportState::Error: return "error";
+    }
+    return "unknown";
+}
+
+void printStatusLine(const audioserver::TransportBackend& transport) {
+    auto status = transport.getStatus();
+    std::cout << "\rState: " << stateToString(status.state)
+              << " | Sent: " << status.bytesSent / 1024 << " KB"
+              << " | Recv: " << status.bytesReceived / 1024 << " KB"
+              << " | Lost: " << status.packetsLost << "   " << std::flush;
+}
+
+// Runs the JUCE message loop on this thread until SIGINT/SIGTERM. Pumping it
+// here delivers device hot-plug notifications and queued device rescans.
+void runUntilSignalled(const audioserver::Config& config, const audioserver::TransportBackend& transport) {
+#ifdef _WIN32
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    while (g_running) {
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(100);
+        if (config.verbose) {
+            printStatusLine(transport);
+        }
+    }
+#else
+    if (pipe(g_signalPipe) != 0) {
+        std::cerr << "Failed to create signal pipe\n";
+        return;
+    }
+    fcntl(g_signalPipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(g_signalPipe[1], F_SETFL, O_NONBLOCK);
+
+    // The loop thread stops the message loop, which may be done from any thread
+    auto& loop = audioserver::EventLoop::shared();
+    audioserver::EventLoop::TimerId statusTimer = 0;
+    loop.runSync([&] {
+        loop.watch(g_signalPipe[0], audioserver::EventLoop::READABLE, [](uint32_t) {
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        });
+        if (config.verbose) {
+            statusTimer = loop.addTimer(std::chrono::milliseconds(0), std::chrono::milliseconds(100),
+                                        [&transport] { printStatusLine(transport); });
+        }
+    });
+
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+
+    juce::MessageManager::getInstance()->runDispatchLoop();
+
+    loop.runSync([&] {
+        loop.unwatch(g_signalPipe[0]);
+        if (statusTimer != 0) {
+            loop.cancelTimer(statusTimer);
+        }
+    });
+#endif
 }
 
 void listDevices(audioserver::AudioEngine& engine) {
     std::cout << "Input Devices:\n";
     for (const auto& device : engine.getInputDevices()) {
-        std::cout << "  - " << device.name << " (" << device.type << ")\n";
+        std::cout << "  - " << device.name << " (" << device.type << ", "
+                  << device.numInputChannels << " ch)" << (device.isDefault ? " [default]" : "") << "\n";
     }
 
     std::cout << "\nOutput Devices:\n";
     for (const auto& device : engine.getOutputDevices()) {
-        std::cout << "  - " << device.name << " (" << device.type << ")\n";
+        std::cout << "  - " << device.name << " (" << device.type << ", "
+                  << device.numOutputChannels << " ch)" << (device.isDefault ? " [default]" : "") << "\n";
     }
 }
 
 int main(int argc, char* argv[]) {
+    auto launchTime = std::chrono::steady_clock::now();
     juce::ScopedJuceInitialiser_GUI juceInit;
 
     audioserver::Config config;
@@ -48,13 +132,13 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    audioserver::AudioEngine audioEngine;
-    if (!audioEngine.initialize(config)) {
-        std::cerr << "Failed to initialize audio engine\n";
-        return 1;
-    }
-
     if (config.listDevices) {
+        audioserver::AudioEngine audioEngine;
+        if (!audioEngine.initialize(config)) {
+            std::cerr << "Failed to initialize audio engine\n";
+            return 1;
+        }
+        audioEngine.getDeviceRegistry().scan();
         listDevices(audioEngine);
         return 0;
     }
@@ -65,92 +149,69 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Set up transport
-    audioserver::TcpPcmBackend transport;
-
-    // Ring buffer for receiver jitter handling (1 second buffer)
-    size_t ringBufferSize = config.sampleRate * config.channels * 1;
-    audioserver::RingBuffer<float> ringBuffer(ringBufferSize);
-
-    // Connect audio engine and transport
-    bool useTestTone = config.testTone && config.mode == audioserver::Mode::Sender;
-
-    if (config.mode == audioserver::Mode::Sender && !useTestTone) {
-        audioEngine.setAudioCallback([&transport](const float* const* data, int channels, int samples) {
-            transport.sendAudio(data, channels, samples);
-        });
-    } else if (config.mode == audioserver::Mode::Receiver) {
-        transport.setAudioReceivedCallback([&ringBuffer](const float* data, int channels, int samples) {
-            size_t totalSamples = static_cast<size_t>(channels * samples);
-            ringBuffer.write(data, totalSamples);
-        });
-
-        audioEngine.setPlaybackCallback([&ringBuffer](float* const* data, int channels, int samples) {
-            size_t totalSamples = static_cast<size_t>(channels * samples);
-            std::vector<float> interleavedBuffer(totalSamples);
-
-            size_t read = ringBuffer.read(interleavedBuffer.data(), totalSamples);
-            if (read < totalSamples) {
-                // Underrun - fill remainder with silence
-                std::fill(interleavedBuffer.begin() + static_cast<long>(read), interleavedBuffer.end(), 0.0f);
-            }
-
-            // De-interleave
-            for (int i = 0; i < samples; ++i) {
-                for (int ch = 0; ch < channels; ++ch) {
-                    data[ch][i] = interleavedBuffer[static_cast<size_t>(i * channels + ch)];
-                }
-            }
-
-            return read > 0;
-        });
+    // Policies apply as each thread starts; the event loop thread starts here
+    auto& scheduler = audioserver::ThreadScheduler::shared();
+    scheduler.configure(audioserver::ThreadRole::Audio, config.audioThreads);
+    scheduler.configure(audioserver::ThreadRole::Network, config.networkThreads);
+    scheduler.configure(audioserver::ThreadRole::Api, config.apiThreads);
+    audioserver::EventLoop::shared().post([&scheduler] {
+        scheduler.applyToCurrentThread(audioserver::ThreadRole::Network, "network");
+    });
+
+    // Wire each stream's audio engine to its transport and start streaming;
+    // the command line's own stream is the primary
+    audioserver::StreamManager streams;
+    std::string error;
+    auto primary = streams.add(audioserver::StreamManager::PRIMARY_NAME, config, error);
+    if (!primary) {
+        std::cerr << error << "\n";
+        return 1;
     }
+    auto& audioEngine = primary->audioEngine();
+    auto& transport = primary->transport();
+    auto& stream = primary->controller();
 
-    audioserver::StreamConfig streamConfig;
-    streamConfig.sampleRate = config.sampleRate;
-    streamConfig.channels = config.channels;
-    streamConfig.bufferSize = config.bufferSize;
+    // Probing every device can take longer than the rest of startup, so the
+    // list is filled in on the message loop once it is running
+    audioEngine.getDeviceRegistry().requestRescan();
 
-    // Open audio device (not needed for test-tone sender)
-    if (!useTestTone) {
-        if (!audioEngine.openDevice(config.device, config.mode)) {
-            std::cerr << "Failed to open audio device\n";
+    for (const auto& spec : config.streams) {
+        std::string name;
+        audioserver::Config streamConfig;
+        if (!audioserver::StreamManager::parseSpec(spec, config, name, streamConfig, error)
+            || !streams.add(name, streamConfig, error)) {
+            std::cerr << "--stream " << spec << ": " << error << "\n";
             return 1;
         }
-        streamConfig = audioEngine.getStreamConfig();
-    }
-
-    // Start transport
-    bool transportStarted = false;
-    if (config.mode == audioserver::Mode::Sender) {
-        transportStarted = transport.startSender(config.target, config.port, streamConfig);
-    } else {
-        transportStarted = transport.startReceiver(config.port, streamConfig);
-    }
-
-    if (!transportStarted) {
-        auto status = transport.getStatus();
-        std::cerr << "Failed to start transport: " << status.errorMessage << "\n";
-        return 1;
     }
 
     // Start API server
-    audioserver::ApiServer apiServer(audioEngine, transport, config);
+    audioserver::ApiServer apiServer(streams);
     if (!apiServer.start(config.apiPort)) {
         std::cerr << "Failed to start API server on port " << config.apiPort << "\n";
         return 1;
     }
 
+    double readyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+
     // Print startup info
+    auto streamConfig = stream.getStreamConfig();
     std::string modeStr = (config.mode == audioserver::Mode::Sender) ? "sender" : "receiver";
     std::cout << "audio-server started in " << modeStr << " mode\n";
-    if (useTestTone) {
+    if (stream.getSource() == audioserver::StreamController::Source::TestTone) {
         std::cout << "  Source: Test tone (" << config.testToneFrequency << " Hz)\n";
+    } else if (auto* player = stream.getFilePlayer()) {
+        std::cout << "  Source: " << config.playFile << " ("
+                  << player->getLengthFrames() / player->getSampleRate() << " s"
+                  << (player->isLooping() ? ", looping" : "") << ")\n";
     } else {
         std::cout << "  Device: " << audioEngine.getCurrentDeviceName() << "\n";
     }
     std::cout << "  Sample rate: " << streamConfig.sampleRate << " Hz\n";
     std::cout << "  Channels: " << streamConfig.channels << "\n";
+    if (!config.routing.straightThrough()) {
+        std::cout << "  Routing: " << config.routing.toString() << "\n";
+    }
     std::cout << "  Buffer size: " << streamConfig.bufferSize << " samples\n";
     std::cout << "  Streaming port: " << config.port << "\n";
     std::cout << "  API port: " << config.apiPort << "\n";
@@ -158,93 +219,26 @@ int main(int argc, char* argv[]) {
     if (config.mode == audioserver::Mode::Sender) {
         std::cout << "  Target: " << config.target << "\n";
     }
-
-    std::cout << "\nPress Ctrl+C to exit\n";
-
-    // Set up signal handler
-    std::signal(SIGINT, signalHandler);
-    std::signal(SIGTERM, signalHandler);
-
-    // Test tone generator thread for sender mode
-    std::thread toneThread;
-    if (useTestTone) {
-        toneThread = std::thread([&]() {
-            audioserver::ToneGenerator toneGen(streamConfig.sampleRate,
-                                                config.testToneFrequency,
-                                                streamConfig.channels);
-
-            const int bufferSize = static_cast<int>(streamConfig.bufferSize);
-            const int channels = static_cast<int>(streamConfig.channels);
-
-            std::vector<float*> channelPtrs(static_cast<size_t>(channels));
-            std::vector<std::vector<float>> channelBuffers(static_cast<size_t>(channels));
-
-            for (int ch = 0; ch < channels; ++ch) {
-                channelBuffers[static_cast<size_t>(ch)].resize(static_cast<size_t>(bufferSize));
-                channelPtrs[static_cast<size_t>(ch)] = channelBuffers[static_cast<size_t>(ch)].data();
-            }
-
-            // Use steady clock for accurate timing
-            auto bufferDuration = std::chrono::microseconds(
-                static_cast<long>(1000000.0 * bufferSize / streamConfig.sampleRate));
-            auto nextTime = std::chrono::steady_clock::now();
-
-            while (g_running) {
-                auto status = transport.getStatus();
-                if (status.state == audioserver::TransportState::Streaming) {
-                    toneGen.generate(channelPtrs.data(), channels, bufferSize);
-                    transport.sendAudio(const_cast<const float* const*>(channelPtrs.data()),
-                                       channels, bufferSize);
-
-                    // Schedule next buffer at precise interval
-                    nextTime += bufferDuration;
-                    auto now = std::chrono::steady_clock::now();
-                    if (nextTime > now) {
-                        std::this_thread::sleep_until(nextTime);
-                    } else {
-                        // We're behind, reset timing
-                        nextTime = now;
-                    }
-                } else {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                    nextTime = std::chrono::steady_clock::now();
-                }
-            }
-        });
-    }
-
-    // Main loop
-    while (g_running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        if (config.verbose) {
-            auto status = transport.getStatus();
-            std::string stateStr;
-            switch (status.state) {
-                case audioserver::TransportState::Disconnected: stateStr = "disconnected"; break;
-                case audioserver::TransportState::Connecting: stateStr = "connecting"; break;
-                case audioserver::TransportState::Connected: stateStr = "connected"; break;
-                case audioserver::TransportState::Streaming: stateStr = "streaming"; break;
-                case audioserver::TransportState::Error: stateStr = "error"; break;
-            }
-            std::cout << "\rState: " << stateStr
-                      << " | Sent: " << status.bytesSent / 1024 << " KB"
-                      << " | Recv: " << status.bytesReceived / 1024 << " KB"
-                      << " | Lost: " << status.packetsLost << "   " << std::flush;
+    for (const auto& other : streams.list()) {
+        if (other != primary) {
+            const auto& otherConfig = other->config();
+            std::cout << "  Stream " << other->name() << ": "
+                      << (otherConfig.mode == audioserver::Mode::Sender ? "sender to " + otherConfig.target : "receiver")
+                      << " on port " << otherConfig.port << "\n";
         }
     }
+    std::cout << "  Startup: " << juce::String(readyMs - stream.getDeviceOpenMs(), 1).toStdString()
+              << " ms (+" << juce::String(stream.getDeviceOpenMs(), 1).toStdString() << " ms device open)\n";
 
-    // Wait for tone thread to finish
-    if (toneThread.joinable()) {
-        toneThread.join();
-    }
+    std::cout << "\nPress Ctrl+C to exit\n";
+
+    runUntilSignalled(config, transport);
 
     std::cout << "\nShutting down...\n";
 
     // Clean shutdown
     apiServer.stop();
-    transport.stop();
-    audioEngine.shutdown();
+    streams.stopAll();
 
     return 0;
 }
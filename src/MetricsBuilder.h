@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Histogram.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace audioserver {
+
+// Builds an OpenMetrics text exposition, always served as CONTENT_TYPE:
+// counters get the mandatory _total suffix, values are in base units
+// (seconds, bytes) and the body ends with # EOF. Histograms from Histogram
+// are exposed as summaries with fixed quantiles.
+class MetricsBuilder {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    static constexpr const char* CONTENT_TYPE =
+        "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+    MetricsBuilder& family(const std::string& name, const char* type, const std::string& help) {
+        out_ += "# TYPE " + name + " " + type + "\n";
+        out_ += "# HELP " + name + " " + help + "\n";
+        return *this;
+    }
+
+    MetricsBuilder& sample(const std::string& name, const Labels& labels, uint64_t value) {
+        appendName(name, labels);
+        out_ += std::to_string(value);
+        out_ += '\n';
+        return *this;
+    }
+
+    MetricsBuilder& sample(const std::string& name, const Labels& labels, double value) {
+        appendName(name, labels);
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.9g", value);
+        out_ += buf;
+        out_ += '\n';
+        return *this;
+    }
+
+    MetricsBuilder& counter(const std::string& name, const std::string& help, uint64_t value) {
+        family(name, "counter", help);
+        return counterSample(name, {}, value);
+    }
+
+    // For counters of a base unit kept at a finer one (seconds from ms)
+    MetricsBuilder& counter(const std::string& name, const std::string& help, double value) {
+        family(name, "counter", help);
+        return counterSample(name, {}, value);
+    }
+
+    // One labelled sample of a counter family declared with family()
+    MetricsBuilder& counterSample(const std::string& name, const Labels& labels, uint64_t value) {
+        return sample(name + "_total", labels, value);
+    }
+
+    MetricsBuilder& counterSample(const std::string& name, const Labels& labels, double value) {
+        return sample(name + "_total", labels, value);
+    }
+
+    MetricsBuilder& gauge(const std::string& name, const std::string& help, double value) {
+        family(name, "gauge", help);
+        return sample(name, {}, value);
+    }
+
+    // Quantiles, sum and count of a histogram, values divided by scale
+    MetricsBuilder& summary(const std::string& name, const std::string& help,
+                            const Histogram::Snapshot& snap, double scale) {
+        family(name, "summary", help);
+        return summarySample(name, {}, snap, scale);
+    }
+
+    // One labelled summary of a family declared with family()
+    MetricsBuilder& summarySample(const std::string& name, const Labels& labels,
+                                  const Histogram::Snapshot& snap, double scale) {
+        for (double q : {0.5, 0.9, 0.99}) {
+            char quantile[16];
+            std::snprintf(quantile, sizeof(quantile), "%g", q);
+            Labels withQuantile = labels;
+            withQuantile.emplace_back("quantile", quantile);
+            sample(name, withQuantile, static_cast<double>(snap.percentile(q)) / scale);
+        }
+        sample(name + "_sum", labels, static_cast<double>(snap.sum) / scale);
+        sample(name + "_count", labels, snap.count);
+        return *this;
+    }
+
+    std::string build() const {
+        return out_ + "# EOF\n";
+    }
+
+private:
+    void appendName(const std::string& name, const Labels& labels) {
+        out_ += name;
+        if (!labels.empty()) {
+            out_ += '{';
+            for (size_t i = 0; i < labels.size(); ++i) {
+                if (i > 0) {
+                    out_ += ',';
+                }
+                out_ += labels[i].first;
+                out_ += "=\"";
+                appendEscaped(labels[i].second);
+                out_ += '"';
+            }
+            out_ += '}';
+        }
+        out_ += ' ';
+    }
+
+    void appendEscaped(const std::string& s) {
+        for (char c : s) {
+            switch (c) {
+                case '"': out_ += "\\\""; break;
+                case '\\': out_ += "\\\\"; break;
+                case '\n': out_ += "\\n"; break;
+                default: out_ += c; break;
+            }
+        }
+    }
+
+    std::string out_;
+};
+
+} // namespace audioserver
@@ -0,0 +1,109 @@
+#include "PlayoutScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audioserver {
+
+void PlayoutScheduler::setDelayMs(int delayMs) {
+    delayNs_.store(static_cast<int64_t>(std::clamp(delayMs, 0, MAX_DELAY_MS)) * 1000000,
+                   std::memory_order_relaxed);
+}
+
+int PlayoutScheduler::getDelayMs() const {
+    return static_cast<int>(delayNs_.load(std::memory_order_relaxed) / 1000000);
+}
+
+void PlayoutScheduler::written(int64_t firstMediaNs, size_t frames, uint32_t sampleRate) {
+    mark_.endFrame += frames;
+    mark_.sampleRate = sampleRate;
+    mark_.timestamped = firstMediaNs != NO_TIMESTAMP && sampleRate > 0;
+    if (mark_.timestamped) {
+        mark_.endMediaNs = firstMediaNs + static_cast<int64_t>(1.0e9 * static_cast<double>(frames) / sampleRate);
+    }
+    marks_.store(mark_);
+}
+
+void PlayoutScheduler::reset() {
+    mark_ = WriteMark{mark_.epoch + 1};
+    marks_.store(mark_);
+}
+
+PlayoutScheduler::Plan PlayoutScheduler::plan(int64_t outputNs, int frames, const ClockEstimate& clock) {
+    Plan plan;
+    WriteMark mark = marks_.load();
+    if (mark.epoch != epoch_) {
+        // Frames read from the old buffer say nothing about the new one
+        epoch_ = mark.epoch;
+        framesRead_ = 0;
+        aligned_ = false;
+    }
+
+    const int64_t delayNs = delayNs_.load(std::memory_order_relaxed);
+    status_.enabled = delayNs > 0;
+    status_.timestamped = mark.timestamped;
+    status_.clockLocked = clock.locked;
+    status_.delayNs = delayNs;
+    status_.clockOffsetNs = clock.offsetNs;
+    status_.clockRttNs = clock.rttNs;
+    status_.outputNs = outputNs;
+
+    if (!status_.enabled || !mark.timestamped || !clock.locked) {
+        aligned_ = false;
+        status_.aligned = false;
+        status_.errorNs = 0;
+        published_.store(status_);
+        return plan;
+    }
+
+    // Media time of the frame at the read position, and the one due at the
+    // output. Both in the sender's clock; the difference is how early we are.
+    const double nsPerFrame = 1.0e9 / mark.sampleRate;
+    const auto pending = static_cast<int64_t>(mark.endFrame - framesRead_);
+    const int64_t headNs = mark.endMediaNs - static_cast<int64_t>(static_cast<double>(pending) * nsPerFrame);
+    const int64_t dueNs = outputNs + clock.offsetNs - delayNs;
+    const int64_t errorNs = headNs - dueNs;
+
+    if (!aligned_ || errorNs > REALIGN_NS || errorNs < -REALIGN_NS) {
+        if (aligned_) {
+            status_.realigns++;
+        }
+        auto errorFrames = static_cast<int64_t>(std::llround(static_cast<double>(errorNs) / nsPerFrame));
+        if (errorFrames >= 0) {
+            // Early: silence until the head frame is due, which may be blocks away
+            plan.hold = static_cast<int>(std::min<int64_t>(errorFrames, frames));
+            aligned_ = plan.hold < frames;
+            status_.alignFramesHeld += static_cast<uint64_t>(plan.hold);
+        } else {
+            // Late: drop what should already have played, as far as it has arrived
+            auto available = std::max<int64_t>(pending, 0);
+            plan.skip = static_cast<size_t>(std::min(-errorFrames, available));
+            aligned_ = -errorFrames <= available;
+            status_.alignFramesSkipped += plan.skip;
+        }
+        errorNs_ = 0;
+        status_.errorNs = errorNs;
+    } else {
+        errorNs_ += (errorNs - errorNs_) / ERROR_SMOOTHING;
+        const int64_t frameNs = static_cast<int64_t>(nsPerFrame);
+        const int64_t tolerance = std::max(SLEW_TOLERANCE_NS, frameNs);
+        if (errorNs_ > tolerance) {
+            plan.hold = 1;
+            plan.repeat = true;
+            errorNs_ -= frameNs;
+            status_.framesInserted++;
+        } else if (errorNs_ < -tolerance && pending > 0) {
+            plan.skip = 1;
+            errorNs_ += frameNs;
+            status_.framesSkipped++;
+        }
+        status_.errorNs = errorNs_;
+    }
+
+    status_.aligned = aligned_;
+    status_.mediaNs = headNs + static_cast<int64_t>(static_cast<double>(plan.skip) * nsPerFrame)
+                    - static_cast<int64_t>(plan.hold * nsPerFrame);
+    published_.store(status_);
+    return plan;
+}
+
+} // namespace audioserver
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "SeqLock.h"
+#include "transport/ClockSync.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace audioserver {
+
+// Plays a receiver's stream on the sender's schedule: every frame is heard
+// a fixed delay after the sender captured it, measured on the sender's media
+// clock. Receivers of one sender - or of senders on one host, which share a
+// clock - given the same delay therefore play each frame at the same moment,
+// whatever their network path, buffer size or output latency.
+//
+// The receive thread reports each chunk it writes to the jitter buffer with
+// written(); from the last report and the frames consumed since, the audio
+// thread knows the media time of the frame at the buffer's read position.
+// plan() compares that with the media time due at the output, using the
+// transport's ClockEstimate to translate between the clocks:
+// - further out than REALIGN_NS (starting up, after a dropout) the block is
+//   realigned at once, skipping late frames or holding back with silence
+// - within it, the smoothed error is slewed away one frame per block,
+//   skipping or repeating a single frame, which is inaudible in practice
+//
+// written() and reset() must be serialized by the caller; plan() and
+// consumed() belong to the audio thread. status() is safe from any thread.
+class PlayoutScheduler {
+public:
+    static constexpr int MAX_DELAY_MS = 2000;
+    static constexpr int64_t REALIGN_NS = 5000000;
+    static constexpr int64_t SLEW_TOLERANCE_NS = 50000;  // Or one frame, whichever is longer
+    static constexpr int64_t ERROR_SMOOTHING = 16;       // Blocks the error is averaged over
+
+    // What the audio thread does with the jitter buffer for one block
+    struct Plan {
+        size_t skip = 0;      // Frames to drop before reading
+        int hold = 0;         // Frames at the start of the block not taken from the buffer
+        bool repeat = false;  // Fill the held frames with the first frame read, not silence
+    };
+
+    struct Status {
+        bool enabled = false;
+        bool timestamped = false;   // The sender stamps its chunks
+        bool clockLocked = false;
+        bool aligned = false;       // Playing on schedule
+        int64_t delayNs = 0;
+        int64_t clockOffsetNs = 0;  // Sender's clock minus ours
+        int64_t clockRttNs = 0;
+        int64_t errorNs = 0;        // Smoothed playout error; positive means early
+        int64_t outputNs = 0;       // Our steady clock when the last block started playing
+        int64_t mediaNs = 0;        // Sender's media time of the frame playing then
+        uint64_t framesSkipped = 0;       // Slewing: single frames dropped while on schedule
+        uint64_t framesInserted = 0;      // Slewing: single frames repeated while on schedule
+        uint64_t alignFramesSkipped = 0;  // Late frames dropped while (re)aligning
+        uint64_t alignFramesHeld = 0;     // Frames of silence held back while (re)aligning
+        uint64_t realigns = 0;            // Lost the schedule while playing on it
+    };
+
+    PlayoutScheduler() = default;
+
+    PlayoutScheduler(const PlayoutScheduler&) = delete;
+    PlayoutScheduler& operator=(const PlayoutScheduler&) = delete;
+
+    // Presentation delay; zero turns scheduling off and audio plays as it arrives
+    void setDelayMs(int delayMs);
+    int getDelayMs() const;
+
+    // frames of a chunk were written at sampleRate; firstMediaNs is the
+    // sender's media time of the first of them, or NO_TIMESTAMP
+    void written(int64_t firstMediaNs, size_t frames, uint32_t sampleRate);
+
+    // The jitter buffer was replaced by an empty one
+    void reset();
+
+    // outputNs: our steady clock time the block's first frame reaches the output
+    Plan plan(int64_t outputNs, int frames, const ClockEstimate& clock);
+
+    // Frames taken from the jitter buffer for the block, skipped ones included
+    void consumed(size_t frames) { framesRead_ += frames; }
+
+    Status status() const { return published_.load(); }
+
+private:
+    // Published by the receive thread after each write
+    struct WriteMark {
+        uint64_t epoch = 0;          // Bumped by reset()
+        uint64_t endFrame = 0;       // Frames written since the last reset()
+        int64_t endMediaNs = 0;      // Media time just past the last frame written
+        uint32_t sampleRate = 0;
+        bool timestamped = false;
+    };
+
+    std::atomic<int64_t> delayNs_{0};
+
+    // Writer side
+    WriteMark mark_;
+    SeqLock<WriteMark> marks_;
+
+    // Audio thread
+    uint64_t epoch_ = 0;
+    uint64_t framesRead_ = 0;
+    bool aligned_ = false;
+    int64_t errorNs_ = 0;
+    Status status_;
+    SeqLock<Status> published_;
+};
+
+} // namespace audioserver
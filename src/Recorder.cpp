@@ -0,0 +1,516 @@
+#include "Recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+    #include <malloc.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace audioserver {
+
+namespace {
+    // Fixed-layout header fields, written at increasing offsets
+    class HeaderWriter {
+    public:
+        explicit HeaderWriter(uint8_t* out) : out_(out) {}
+
+        size_t offset() const { return offset_; }
+
+        void tag(const char* fourCC) {
+            std::memcpy(out_ + offset_, fourCC, 4);
+            offset_ += 4;
+        }
+
+        void le16(uint16_t v) { putLE(v, 2); }
+        void le32(uint32_t v) { putLE(v, 4); }
+        void le64(uint64_t v) { putLE(v, 8); }
+        void be16(uint16_t v) { putBE(v, 2); }
+        void be32(uint32_t v) { putBE(v, 4); }
+        void be64(uint64_t v) { putBE(v, 8); }
+
+        void bytes(std::initializer_list<uint8_t> values) {
+            for (uint8_t b : values) {
+                out_[offset_++] = b;
+            }
+        }
+
+        void zeros(size_t count) {
+            std::memset(out_ + offset_, 0, count);
+            offset_ += count;
+        }
+
+    private:
+        void putLE(uint64_t v, int size) {
+            for (int i = 0; i < size; ++i) {
+                out_[offset_++] = static_cast<uint8_t>(v >> (8 * i));
+            }
+        }
+
+        void putBE(uint64_t v, int size) {
+            for (int i = size - 1; i >= 0; --i) {
+                out_[offset_++] = static_cast<uint8_t>(v >> (8 * i));
+            }
+        }
+
+        uint8_t* out_;
+        size_t offset_ = 0;
+    };
+
+#ifdef _WIN32
+    int openFile(const std::string& path, bool) {
+        return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    }
+#else
+    int openFile(const std::string& path, bool direct) {
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    #ifdef O_CLOEXEC
+        flags |= O_CLOEXEC;
+    #endif
+    #ifdef O_DIRECT
+        if (direct) {
+            flags |= O_DIRECT;
+        }
+    #else
+        (void)direct;
+    #endif
+        return open(path.c_str(), flags, 0644);
+    }
+#endif
+
+    void closeFile(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+}
+
+void Recorder::AlignedDeleter::operator()(uint8_t* data) const {
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    std::free(data);
+#endif
+}
+
+Recorder::AlignedBlock Recorder::allocateAligned(size_t bytes) {
+#ifdef _WIN32
+    auto* data = static_cast<uint8_t*>(_aligned_malloc(bytes, ALIGNMENT));
+#else
+    void* data = nullptr;
+    if (posix_memalign(&data, ALIGNMENT, bytes) != 0) {
+        data = nullptr;
+    }
+#endif
+    if (data) {
+        std::memset(data, 0, bytes);  // Fault the pages in now, not on the first write
+    }
+    return AlignedBlock(static_cast<uint8_t*>(data));
+}
+
+Recorder::Recorder() = default;
+
+Recorder::~Recorder() {
+    stop();
+}
+
+bool Recorder::start(const Options& options, double sampleRate, int channels, std::string& error) {
+    std::lock_guard<std::mutex> control(controlMutex_);
+
+    if (recording_) {
+        error = "Already recording to " + options_.path;
+        return false;
+    }
+    if (channels < 1 || channels > MAX_CHANNELS) {
+        error = "Cannot record " + std::to_string(channels) + " channels";
+        return false;
+    }
+    if (sampleRate <= 0.0) {
+        error = "Invalid sample rate";
+        return false;
+    }
+
+    block_ = allocateAligned(BLOCK_BYTES);
+    if (!block_) {
+        error = "Failed to allocate the write buffer";
+        return false;
+    }
+
+    bool direct = options.direct;
+    int fd = openFile(options.path, direct);
+#ifndef _WIN32
+    if (fd < 0 && direct && errno == EINVAL) {
+        direct = false;  // Filesystem without O_DIRECT support (tmpfs, some FUSE)
+        fd = openFile(options.path, false);
+    }
+#endif
+    if (fd < 0) {
+        error = "Failed to open " + options.path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    auto capacity = static_cast<size_t>(sampleRate) * static_cast<size_t>(channels) * RING_SECONDS;
+    ring_ = std::make_unique<RingBuffer<float>>(capacity + 1);
+    scratch_.assign(static_cast<size_t>(MAX_PUSH_FRAMES) * static_cast<size_t>(channels), 0.0f);
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex_);
+        options_ = options;
+        sampleRate_ = sampleRate;
+        channels_ = channels;
+        direct_ = direct;
+        error_.clear();
+    }
+    fd_ = fd;
+    writeFailed_ = false;
+    allocatedEnd_ = 0;
+    bytesWritten_ = 0;
+    framesDropped_ = 0;
+
+    // Placeholder header, rewritten with the real sizes by finalize()
+    std::memset(block_.get(), 0, ALIGNMENT);
+    buildHeader(block_.get(), options_.format, sampleRate_, channels_, 0);
+    preallocate(static_cast<int64_t>(ALIGNMENT) + PREALLOCATE_BYTES);
+    if (!writeAt(block_.get(), ALIGNMENT, 0)) {
+        closeFile(fd_);
+        fd_ = -1;
+        error = error_;
+        return false;
+    }
+
+    writerRunning_ = true;
+    writer_ = std::thread(&Recorder::writerThread, this);
+    recording_.store(true, std::memory_order_release);
+    return true;
+}
+
+Recorder::Status Recorder::stop() {
+    std::lock_guard<std::mutex> control(controlMutex_);
+
+    if (!recording_) {
+        Status idle = status();
+        idle.active = false;
+        return idle;
+    }
+
+    // Once push() is seen idle with recording_ clear, it will not touch the
+    // ring again, so the writer can take everything that is left
+    recording_.store(false);
+    while (pushing_.load()) {
+        std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        writerRunning_ = false;
+    }
+    writerCv_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    closeFile(fd_);
+    fd_ = -1;
+
+    Status result = status();
+    result.active = false;
+    return result;
+}
+
+Recorder::Status Recorder::status() const {
+    Status status;
+    status.active = recording_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(statusMutex_);
+    status.path = options_.path;
+    status.format = options_.format;
+    status.direct = direct_;
+    status.sampleRate = sampleRate_;
+    status.channels = channels_;
+    status.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    status.framesWritten = channels_ > 0 ? status.bytesWritten / (sizeof(float) * static_cast<size_t>(channels_)) : 0;
+    status.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+    status.error = error_;
+    return status;
+}
+
+void Recorder::push(const float* const* channelData, int numChannels, int numSamples) {
+    // Announce first, then check: pairs with stop() clearing recording_
+    // before waiting for pushing_ (both sequentially consistent)
+    pushing_.store(true);
+    if (!recording_.load()) {
+        pushing_.store(false, std::memory_order_release);
+        return;
+    }
+
+    const int channels = channels_;
+    float* scratch = scratch_.data();
+
+    for (int offset = 0; offset < numSamples; offset += MAX_PUSH_FRAMES) {
+        int frames = std::min(MAX_PUSH_FRAMES, numSamples - offset);
+        size_t total = static_cast<size_t>(frames) * static_cast<size_t>(channels);
+
+        // Whole blocks or nothing, so a full ring never splits a frame
+        if (ring_->available() < total) {
+            framesDropped_.fetch_add(static_cast<uint64_t>(frames), std::memory_order_relaxed);
+            continue;
+        }
+
+        // Channels the device no longer delivers are recorded as silence
+        for (int i = 0; i < frames; ++i) {
+            float* frame = scratch + static_cast<size_t>(i) * static_cast<size_t>(channels);
+            for (int ch = 0; ch < channels; ++ch) {
+                frame[ch] = ch < numChannels ? channelData[ch][offset + i] : 0.0f;
+            }
+        }
+        ring_->write(scratch, total);
+    }
+
+    pushing_.store(false, std::memory_order_release);
+}
+
+void Recorder::writerThread() {
+    std::unique_lock<std::mutex> lock(writerMutex_);
+    while (writerRunning_) {
+        writerCv_.wait_for(lock, std::chrono::milliseconds(WRITER_PERIOD_MS), [this] { return !writerRunning_; });
+
+        lock.unlock();
+        drain(false);
+        lock.lock();
+    }
+    lock.unlock();
+
+    drain(true);
+    finalize();
+}
+
+bool Recorder::drain(bool flushTail) {
+    constexpr size_t blockSamples = BLOCK_BYTES / sizeof(float);
+    auto* samples = reinterpret_cast<float*>(block_.get());
+
+    if (writeFailed_) {
+        // Keep the ring moving so the audio thread is not stuck dropping
+        // against a full ring; the recording already reports the error
+        size_t discarded = 0;
+        while (size_t count = ring_->read(samples, blockSamples)) {
+            discarded += count;
+        }
+        framesDropped_.fetch_add(discarded / static_cast<size_t>(channels_), std::memory_order_relaxed);
+        return false;
+    }
+
+    while (ring_->size() >= blockSamples) {
+        ring_->read(samples, blockSamples);
+        auto offset = static_cast<int64_t>(ALIGNMENT + bytesWritten_.load(std::memory_order_relaxed));
+        if (offset + static_cast<int64_t>(BLOCK_BYTES) > allocatedEnd_) {
+            preallocate(allocatedEnd_ + PREALLOCATE_BYTES);
+        }
+        if (!writeAt(block_.get(), BLOCK_BYTES, offset)) {
+            return false;
+        }
+        bytesWritten_.fetch_add(BLOCK_BYTES, std::memory_order_relaxed);
+    }
+
+    if (!flushTail) {
+        return true;
+    }
+
+    size_t remaining = ring_->read(samples, blockSamples);
+    if (remaining == 0) {
+        return true;
+    }
+
+#if defined(O_DIRECT) && !defined(_WIN32)
+    // The tail is not a whole block, which O_DIRECT would refuse
+    if (direct_) {
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+    }
+#endif
+    size_t bytes = remaining * sizeof(float);
+    if (!writeAt(block_.get(), bytes, static_cast<int64_t>(ALIGNMENT + bytesWritten_.load()))) {
+        return false;
+    }
+    bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+    return true;
+}
+
+bool Recorder::writeAt(const uint8_t* data, size_t bytes, int64_t offset) {
+    while (bytes > 0) {
+#ifdef _WIN32
+        _lseeki64(fd_, offset, SEEK_SET);
+        auto written = _write(fd_, data, static_cast<unsigned int>(bytes));
+#else
+        auto written = pwrite(fd_, data, bytes, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (written <= 0) {
+            std::string message = std::string("Write failed: ") + std::strerror(errno);
+            std::cerr << "Recorder: " << message << std::endl;
+            std::lock_guard<std::mutex> lock(statusMutex_);
+            error_ = message;
+            writeFailed_ = true;
+            return false;
+        }
+        data += written;
+        bytes -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+void Recorder::preallocate(int64_t end) {
+#ifdef __linux__
+    // KEEP_SIZE: reserve extents without moving EOF, so a reader of the
+    // growing file never sees unwritten zeros. finalize() trims the excess.
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, allocatedEnd_, end - allocatedEnd_) == 0) {
+        allocatedEnd_ = end;
+        return;
+    }
+#endif
+    // Not supported here; writes simply allocate as they go
+    allocatedEnd_ = INT64_MAX;
+}
+
+bool Recorder::finalize() {
+    uint64_t dataBytes = bytesWritten_.load();
+
+    std::memset(block_.get(), 0, ALIGNMENT);
+    buildHeader(block_.get(), options_.format, sampleRate_, channels_, dataBytes);
+
+#if defined(O_DIRECT) && !defined(_WIN32)
+    if (direct_) {
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+    }
+#endif
+    bool ok = writeAt(block_.get(), ALIGNMENT, 0);
+
+    // Drop whatever was preallocated past the last sample
+    auto size = static_cast<int64_t>(ALIGNMENT + dataBytes);
+#ifdef _WIN32
+    _chsize_s(fd_, size);
+#else
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0 || fsync(fd_) != 0) {
+        ok = false;
+    }
+#endif
+    return ok;
+}
+
+std::vector<uint8_t> Recorder::header(Format format, double sampleRate, int channels, uint64_t dataBytes) {
+    std::vector<uint8_t> header(ALIGNMENT, 0);
+    buildHeader(header.data(), format, sampleRate, channels, dataBytes);
+    return header;
+}
+
+void Recorder::buildHeader(uint8_t* header, Format format, double sampleRate, int numChannels, uint64_t dataBytes) {
+    const auto channels = static_cast<uint16_t>(numChannels);
+    const uint32_t bytesPerFrame = sizeof(float) * channels;
+    HeaderWriter w(header);
+
+    if (format == Format::Caf) {
+        w.tag("caff");
+        w.be16(1);  // File version
+        w.be16(0);
+
+        w.tag("desc");
+        w.be64(32);
+        uint64_t rateBits;
+        std::memcpy(&rateBits, &sampleRate, sizeof(rateBits));
+        w.be64(rateBits);
+        w.tag("lpcm");
+        w.be32(1 | 2);  // kCAFLinearPCMFormatFlagIsFloat | kCAFLinearPCMFormatFlagIsLittleEndian
+        w.be32(bytesPerFrame);
+        w.be32(1);      // Frames per packet
+        w.be32(channels);
+        w.be32(32);
+
+        // Pad so the samples start at ALIGNMENT ('data' header + edit count follow)
+        size_t padding = ALIGNMENT - w.offset() - 12 - 12 - 4;
+        w.tag("free");
+        w.be64(padding);
+        w.zeros(padding);
+
+        // -1 means "runs to the end of the file", which keeps an unfinished
+        // recording readable
+        w.tag("data");
+        w.be64(dataBytes > 0 ? dataBytes + 4 : UINT64_MAX);
+        w.be32(0);  // Edit count
+        return;
+    }
+
+    // RIFF sizes are 32-bit; past that the file becomes RF64 and the real
+    // sizes move into the ds64 chunk, which the JUNK chunk reserves room for
+    uint64_t riffSize = ALIGNMENT - 8 + dataBytes;
+    bool rf64 = riffSize > UINT32_MAX;
+
+    w.tag(rf64 ? "RF64" : "RIFF");
+    w.le32(rf64 ? UINT32_MAX : static_cast<uint32_t>(riffSize));
+    w.tag("WAVE");
+
+    w.tag(rf64 ? "ds64" : "JUNK");
+    w.le32(28);
+    w.le64(rf64 ? riffSize : 0);
+    w.le64(rf64 ? dataBytes : 0);
+    w.le64(rf64 ? dataBytes / bytesPerFrame : 0);
+    w.le32(0);  // No table entries
+
+    // WAVE_FORMAT_EXTENSIBLE with the IEEE float subtype, required for > 2 channels
+    w.tag("fmt ");
+    w.le32(40);
+    w.le16(0xFFFE);
+    w.le16(channels);
+    w.le32(static_cast<uint32_t>(sampleRate));
+    w.le32(static_cast<uint32_t>(sampleRate) * bytesPerFrame);
+    w.le16(static_cast<uint16_t>(bytesPerFrame));
+    w.le16(32);
+    w.le16(22);
+    w.le16(32);  // Valid bits per sample
+    w.le32(channels == 1 ? 0x4 : channels == 2 ? 0x3 : 0);  // Speaker mask: mono centre, stereo L/R
+    w.le32(3);   // KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+    w.le16(0x0000);
+    w.le16(0x0010);
+    w.bytes({0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71});
+
+    size_t padding = ALIGNMENT - w.offset() - 8 - 8;
+    w.tag("JUNK");
+    w.le32(static_cast<uint32_t>(padding));
+    w.zeros(padding);
+
+    w.tag("data");
+    w.le32(rf64 ? UINT32_MAX : static_cast<uint32_t>(dataBytes));
+}
+
+bool Recorder::parseFormat(const std::string& name, Format& format) {
+    if (name == "wav" || name == "rf64") {
+        format = Format::Wav;
+    } else if (name == "caf") {
+        format = Format::Caf;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Recorder::formatToString(Format format) {
+    return format == Format::Caf ? "caf" : "wav";
+}
+
+const char* Recorder::extension(Format format) {
+    return format == Format::Caf ? ".caf" : ".wav";
+}
+
+} // namespace audioserver
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "RingBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace audioserver {
+
+// Records the audio path to a 32-bit float WAV (RF64 past 4 GiB) or CAF file.
+//
+// push() runs on the audio thread: it interleaves into a preallocated
+// scratch block and appends that to a lock-free ring sized for RING_SECONDS
+// of audio, dropping (and counting) whole blocks if the writer falls behind.
+// A writer thread drains the ring in BLOCK_BYTES writes at ALIGNMENT-aligned
+// offsets, which also makes O_DIRECT possible, and grows the file's
+// allocation PREALLOCATE_BYTES at a time with fallocate() where available.
+// The header is written up front and rewritten with the final sizes by stop().
+//
+// push() must only be called from one thread at a time; start() and stop()
+// may be called from any thread.
+class Recorder {
+public:
+    enum class Format { Wav, Caf };
+
+    static constexpr int RING_SECONDS = 2;
+    static constexpr int MAX_CHANNELS = 64;
+    static constexpr int MAX_PUSH_FRAMES = 8192;
+    static constexpr size_t ALIGNMENT = 4096;               // Header size and O_DIRECT unit
+    static constexpr size_t BLOCK_BYTES = 1 << 20;
+    static constexpr int64_t PREALLOCATE_BYTES = 256 << 20;
+    static constexpr int WRITER_PERIOD_MS = 20;
+
+    struct Options {
+        std::string path;
+        Format format = Format::Wav;
+        bool direct = false;  // O_DIRECT (Linux); falls back to buffered I/O if refused
+    };
+
+    struct Status {
+        bool active = false;
+        std::string path;
+        Format format = Format::Wav;
+        bool direct = false;
+        double sampleRate = 0.0;
+        int channels = 0;
+        uint64_t framesWritten = 0;
+        uint64_t framesDropped = 0;  // Lost because the writer fell behind
+        uint64_t bytesWritten = 0;   // Audio data only, excluding the header
+        std::string error;           // Last write error, if any
+    };
+
+    Recorder();
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    bool start(const Options& options, double sampleRate, int channels, std::string& error);
+
+    // Flushes everything queued, finalizes the header and returns the totals
+    Status stop();
+
+    Status status() const;
+    bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+    void push(const float* const* channelData, int numChannels, int numSamples);
+
+    static bool parseFormat(const std::string& name, Format& format);
+    static const char* formatToString(Format format);
+    static const char* extension(Format format);
+
+    // The ALIGNMENT-byte header of a file holding dataBytes of interleaved
+    // float samples; the audio starts right after it
+    static std::vector<uint8_t> header(Format format, double sampleRate, int channels, uint64_t dataBytes);
+
+private:
+    struct AlignedDeleter {
+        void operator()(uint8_t* data) const;
+    };
+    using AlignedBlock = std::unique_ptr<uint8_t[], AlignedDeleter>;
+
+    static AlignedBlock allocateAligned(size_t bytes);
+
+    void writerThread();
+    bool drain(bool flushTail);
+    bool writeAt(const uint8_t* data, size_t bytes, int64_t offset);
+    void preallocate(int64_t end);
+    bool finalize();
+    static void buildHeader(uint8_t* header, Format format, double sampleRate, int channels, uint64_t dataBytes);
+
+    // Serializes start() and stop()
+    std::mutex controlMutex_;
+
+    // Audio thread side. stop() waits for pushing_ to clear after clearing
+    // recording_, so the ring and scratch outlive any push in flight.
+    std::atomic<bool> recording_{false};
+    std::atomic<bool> pushing_{false};
+    std::unique_ptr<RingBuffer<float>> ring_;
+    std::vector<float> scratch_;
+    std::atomic<uint64_t> framesDropped_{0};
+
+    // Writer side
+    Options options_;
+    double sampleRate_ = 0.0;
+    int channels_ = 0;
+    int fd_ = -1;
+    bool direct_ = false;
+    bool writeFailed_ = false;
+    AlignedBlock block_;
+    int64_t allocatedEnd_ = 0;
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::string error_;  // Guarded by statusMutex_
+
+    mutable std::mutex statusMutex_;
+
+    std::thread writer_;
+    std::mutex writerMutex_;
+    std::condition_variable writerCv_;
+    bool writerRunning_ = false;
+};
+
+} // namespace audioserver
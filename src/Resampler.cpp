@@ -0,0 +1,204 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+namespace audioserver {
+
+namespace {
+    // Filter phases kept for ratios whose reduced numerator is larger; the
+    // output position is then rounded to the nearest 1/MAX_PHASES of a sample
+    constexpr uint32_t MAX_PHASES = 4096;
+
+    const uint32_t COMMON_RATES[] = {44100, 48000, 88200, 96000, 176400, 192000};
+
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; term > 1e-12 * sum; ++k) {
+            double factor = x / (2.0 * k);
+            term *= factor * factor;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Eight independent partial sums, so the loop vectorizes without
+    // -ffast-math being needed to reorder a single accumulator
+    float dot(const float* coefficients, const float* samples, int taps) {
+        float acc[8] = {};
+        for (int j = 0; j < taps; j += 8) {
+            for (int k = 0; k < 8; ++k) {
+                acc[k] += coefficients[j + k] * samples[j + k];
+            }
+        }
+        return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+    }
+
+    std::pair<uint32_t, uint32_t> reduce(uint32_t inputRate, uint32_t outputRate) {
+        uint32_t divisor = std::gcd(inputRate, outputRate);
+        return {outputRate / divisor, inputRate / divisor};
+    }
+}
+
+Resampler::Resampler(uint32_t inputRate, uint32_t outputRate, int channels)
+    : inputRate_(inputRate)
+    , outputRate_(outputRate)
+    , channels_(channels)
+    , table_(tableFor(inputRate, outputRate)) {
+    size_t history = static_cast<size_t>(table_->taps - 1);
+    stride_ = history + MAX_BLOCK_FRAMES;
+    work_.assign(stride_ * static_cast<size_t>(channels_), 0.0f);
+    next_ = history;
+}
+
+size_t Resampler::maxOutputFrames(int inputFrames) const {
+    return static_cast<size_t>(static_cast<uint64_t>(inputFrames) * table_->up / table_->down) + 2;
+}
+
+size_t Resampler::process(const float* input, int inputFrames, float* output) {
+    auto start = std::chrono::steady_clock::now();
+
+    size_t produced = 0;
+    for (int offset = 0; offset < inputFrames; offset += MAX_BLOCK_FRAMES) {
+        int frames = std::min(inputFrames - offset, MAX_BLOCK_FRAMES);
+        produced += processBlock(input + static_cast<size_t>(offset) * static_cast<size_t>(channels_), frames,
+                                 output + produced * static_cast<size_t>(channels_));
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    processingNs_.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    inputFrames_.fetch_add(static_cast<uint64_t>(inputFrames), std::memory_order_relaxed);
+    return produced;
+}
+
+size_t Resampler::processBlock(const float* input, int inputFrames, float* output) {
+    const Table& table = *table_;
+    const auto taps = static_cast<size_t>(table.taps);
+    const size_t history = taps - 1;
+    const auto channels = static_cast<size_t>(channels_);
+    const auto frames = static_cast<size_t>(inputFrames);
+    const uint32_t phases = static_cast<uint32_t>(table.coefficients.size() / taps);
+
+    for (size_t ch = 0; ch < channels; ++ch) {
+        float* work = work_.data() + ch * stride_ + history;
+        for (size_t i = 0; i < frames; ++i) {
+            work[i] = input[i * channels + ch];
+        }
+    }
+
+    const size_t end = history + frames;
+    size_t produced = 0;
+    while (next_ < end) {
+        uint32_t row = phases == table.up
+            ? phase_ : static_cast<uint32_t>(static_cast<uint64_t>(phase_) * phases / table.up);
+        const float* coefficients = table.coefficients.data() + row * taps;
+        const size_t first = next_ + 1 - taps;
+
+        float* out = output + produced * channels;
+        for (size_t ch = 0; ch < channels; ++ch) {
+            out[ch] = dot(coefficients, work_.data() + ch * stride_ + first, table.taps);
+        }
+        ++produced;
+
+        phase_ += table.down;
+        next_ += phase_ / table.up;
+        phase_ %= table.up;
+    }
+
+    // The newest taps - 1 samples become the next block's history
+    for (size_t ch = 0; ch < channels; ++ch) {
+        float* work = work_.data() + ch * stride_;
+        std::memmove(work, work + frames, history * sizeof(float));
+    }
+    next_ -= frames;
+    return produced;
+}
+
+Resampler::Stats Resampler::stats() const {
+    Stats stats;
+    stats.inputRate = inputRate_;
+    stats.outputRate = outputRate_;
+    stats.taps = table_->taps;
+    stats.inputFrames = inputFrames_.load(std::memory_order_relaxed);
+    if (stats.inputFrames > 0) {
+        double audioNs = static_cast<double>(stats.inputFrames) * 1.0e9 / inputRate_;
+        stats.cpuPercent = 100.0 * static_cast<double>(processingNs_.load(std::memory_order_relaxed)) / audioNs;
+    }
+    return stats;
+}
+
+std::shared_ptr<const Resampler::Table> Resampler::tableFor(uint32_t inputRate, uint32_t outputRate) {
+    static std::mutex mutex;
+    static std::map<std::pair<uint32_t, uint32_t>, std::shared_ptr<const Table>> cache;
+
+    auto ratio = reduce(inputRate, outputRate);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& table = cache[ratio];
+    if (!table) {
+        table = designTable(ratio.first, ratio.second);
+    }
+    return table;
+}
+
+void Resampler::prepareCommonRates() {
+    for (uint32_t from : COMMON_RATES) {
+        for (uint32_t to : COMMON_RATES) {
+            if (from != to) {
+                tableFor(from, to);
+            }
+        }
+    }
+}
+
+std::shared_ptr<const Resampler::Table> Resampler::designTable(uint32_t up, uint32_t down) {
+    auto table = std::make_shared<Table>();
+    table->up = up;
+    table->down = down;
+
+    // Downsampling narrows the passband, so the filter needs proportionally
+    // more input samples for the same steepness
+    double span = std::max(1.0, static_cast<double>(down) / up);
+    int taps = static_cast<int>(std::ceil(BASE_TAPS * span));
+    table->taps = std::min(MAX_TAPS, (taps + 7) / 8 * 8);
+
+    // Prototype lowpass at phases times the input rate, cut off just below
+    // the lower of the two Nyquist frequencies
+    const uint32_t phases = std::min(up, MAX_PHASES);
+    const size_t length = static_cast<size_t>(phases) * static_cast<size_t>(table->taps);
+    const double centre = (static_cast<double>(length) - 1.0) / 2.0;
+    const double cutoff = PASSBAND * 0.5 * std::min(1.0, static_cast<double>(up) / down) / phases;
+    const double kaiserNorm = besselI0(KAISER_BETA);
+
+    std::vector<double> prototype(length);
+    for (size_t n = 0; n < length; ++n) {
+        double t = static_cast<double>(n) - centre;
+        double x = 2.0 * cutoff * t;
+        double sinc = std::abs(x) < 1e-12 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        double r = t / (centre + 0.5);
+        double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / kaiserNorm;
+        prototype[n] = sinc * window;
+    }
+
+    // Split into one row per phase, reversed so it lines up with the oldest
+    // to newest samples, and normalized to unity gain at DC
+    table->coefficients.resize(length);
+    for (uint32_t p = 0; p < phases; ++p) {
+        double sum = 0.0;
+        for (int k = 0; k < table->taps; ++k) {
+            sum += prototype[p + static_cast<size_t>(k) * phases];
+        }
+        float* row = table->coefficients.data() + static_cast<size_t>(p) * static_cast<size_t>(table->taps);
+        for (int k = 0; k < table->taps; ++k) {
+            row[table->taps - 1 - k] = static_cast<float>(prototype[p + static_cast<size_t>(k) * phases] / sum);
+        }
+    }
+    return table;
+}
+
+} // namespace audioserver
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace audioserver {
+
+// Polyphase windowed-sinc sample rate converter for interleaved float audio.
+//
+// The rate ratio is reduced to up/down (44.1 -> 48 kHz is 160/147). Each
+// output sample is one dot product of the newest `taps` input samples with
+// the coefficient row for its phase, so the work per output is fixed and
+// independent of the ratio. Rows are stored reversed and padded to a
+// multiple of 8 so the dot product runs over contiguous memory with eight
+// independent accumulators, which compilers turn into SIMD.
+//
+// Filter tables are cached by ratio and shared between instances;
+// prepareCommonRates() builds the tables for every pairing of the usual
+// studio rates up front, so a format change never has to design a filter.
+// process() must only be called from one thread at a time.
+class Resampler {
+public:
+    static constexpr int BASE_TAPS = 96;         // Taps per phase when upsampling
+    static constexpr int MAX_TAPS = 192;
+    static constexpr int MAX_BLOCK_FRAMES = 8192;
+    static constexpr double PASSBAND = 0.94;     // -6 dB point, as a fraction of the lower Nyquist
+    static constexpr double KAISER_BETA = 8.6;   // About 90 dB stopband
+
+    struct Table {
+        uint32_t up = 1;
+        uint32_t down = 1;
+        int taps = 0;
+        std::vector<float> coefficients;  // One reversed row of taps per phase
+    };
+
+    struct Stats {
+        uint32_t inputRate = 0;
+        uint32_t outputRate = 0;
+        int taps = 0;
+        uint64_t inputFrames = 0;
+        double cpuPercent = 0.0;  // Processing time relative to the audio's duration
+    };
+
+    Resampler(uint32_t inputRate, uint32_t outputRate, int channels);
+
+    uint32_t getInputRate() const { return inputRate_; }
+    uint32_t getOutputRate() const { return outputRate_; }
+    int getNumChannels() const { return channels_; }
+
+    // Group delay: an output frame reflects the input from half the taps earlier
+    int64_t getLatencyNs() const {
+        return static_cast<int64_t>(0.5e9 * table_->taps / inputRate_);
+    }
+
+    // Upper bound on the frames process() produces from inputFrames
+    size_t maxOutputFrames(int inputFrames) const;
+
+    // Converts interleaved input and returns the number of frames written
+    size_t process(const float* input, int inputFrames, float* output);
+
+    Stats stats() const;
+
+    static std::shared_ptr<const Table> tableFor(uint32_t inputRate, uint32_t outputRate);
+    static void prepareCommonRates();
+
+private:
+    static std::shared_ptr<const Table> designTable(uint32_t up, uint32_t down);
+    size_t processBlock(const float* input, int inputFrames, float* output);
+
+    uint32_t inputRate_;
+    uint32_t outputRate_;
+    int channels_;
+    std::shared_ptr<const Table> table_;
+
+    // Per channel: taps - 1 samples of history followed by the current block
+    std::vector<float> work_;
+    size_t stride_ = 0;
+    size_t next_ = 0;     // Newest input sample the next output needs, into a channel's work area
+    uint32_t phase_ = 0;  // Which coefficient row the next output uses
+
+    std::atomic<uint64_t> inputFrames_{0};
+    std::atomic<uint64_t> processingNs_{0};
+};
+
+} // namespace audioserver
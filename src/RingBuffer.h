@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 
@@ -9,16 +10,21 @@ namespace audioserver {
 template<typename T>
 class RingBuffer {
 public:
-    explicit RingBuffer(size_t capacity)
+    // frameSize: items written as one unit, e.g. the channels of an
+    // interleaved frame. write() stores whole frames only, so a buffer
+    // that fills up never splits one and shifts every later frame.
+    explicit RingBuffer(size_t capacity, size_t frameSize = 1)
         : buffer_(capacity)
         , capacity_(capacity)
+        , frameSize_(std::max<size_t>(frameSize, 1))
         , readPos_(0)
         , writePos_(0) {
     }
 
+    // One slot stays free, otherwise a full buffer would look empty
     size_t write(const T* data, size_t count) {
-        size_t available = capacity_ - size();
-        size_t toWrite = std::min(count, available);
+        size_t toWrite = std::min(count, available());
+        toWrite -= toWrite % frameSize_;
 
         if (toWrite == 0) {
             return 0;
@@ -26,9 +32,10 @@ public:
 
         size_t writePos = writePos_.load(std::memory_order_relaxed);
 
-        for (size_t i = 0; i < toWrite; ++i) {
-            buffer_[(writePos + i) % capacity_] = data[i];
-        }
+        // At most two contiguous runs: up to the end, then from the start
+        size_t first = std::min(toWrite, capacity_ - writePos);
+        std::copy(data, data + first, buffer_.begin() + static_cast<std::ptrdiff_t>(writePos));
+        std::copy(data + first, data + toWrite, buffer_.begin());
 
         writePos_.store((writePos + toWrite) % capacity_, std::memory_order_release);
         return toWrite;
@@ -44,14 +51,23 @@ public:
 
         size_t readPos = readPos_.load(std::memory_order_relaxed);
 
-        for (size_t i = 0; i < toRead; ++i) {
-            data[i] = buffer_[(readPos + i) % capacity_];
-        }
+        size_t first = std::min(toRead, capacity_ - readPos);
+        auto begin = buffer_.begin() + static_cast<std::ptrdiff_t>(readPos);
+        std::copy(begin, begin + static_cast<std::ptrdiff_t>(first), data);
+        std::copy(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(toRead - first), data + first);
 
         readPos_.store((readPos + toRead) % capacity_, std::memory_order_release);
         return toRead;
     }
 
+    // Drops up to count of the oldest items without copying them out
+    size_t skip(size_t count) {
+        size_t toSkip = std::min(count, size());
+        size_t readPos = readPos_.load(std::memory_order_relaxed);
+        readPos_.store((readPos + toSkip) % capacity_, std::memory_order_release);
+        return toSkip;
+    }
+
     size_t size() const {
         size_t write = writePos_.load(std::memory_order_acquire);
         size_t read = readPos_.load(std::memory_order_acquire);
@@ -75,9 +91,14 @@ public:
         return capacity_;
     }
 
+    size_t frameSize() const {
+        return frameSize_;
+    }
+
 private:
     std::vector<T> buffer_;
     size_t capacity_;
+    size_t frameSize_;
     std::atomic<size_t> readPos_;
     std::atomic<size_t> writePos_;
 };
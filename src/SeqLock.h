@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace audioserver {
+
+// Publishes a small trivially copyable value to any number of readers
+// without locks or allocation on either side.
+//
+// Two-slot seqlock: the writer fills the slot readers are not pointed at and then bumps the
+// version; readers copy the slot for the version they saw and retry if it
+// changed meanwhile. The payload lives in relaxed atomic words, so a copy
+// racing a rewrite is a retry, not a data race. Writers must be serialized
+// by the caller.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied word by word");
+
+public:
+    SeqLock() {
+        store(T{});
+    }
+
+    void store(const T& value) {
+        Words words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        uint64_t next = version_.load(std::memory_order_relaxed) + 1;
+        auto& slot = slots_[next & 1];
+
+        // Orders the previous publish before this rewrite of the slot a slow
+        // reader may still be copying, so its version recheck catches it
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            slot[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        version_.store(next, std::memory_order_release);
+    }
+
+    T load() const {
+        Words words;
+        while (true) {
+            uint64_t version = version_.load(std::memory_order_acquire);
+            const auto& slot = slots_[version & 1];
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = slot[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version_.load(std::memory_order_relaxed) == version) {
+                break;
+            }
+        }
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    using Words = std::array<uint64_t, WORDS>;
+
+    std::atomic<uint64_t> version_{0};
+    std::array<std::atomic<uint64_t>, WORDS> slots_[2] = {};
+};
+
+} // namespace audioserver
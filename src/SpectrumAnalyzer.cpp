@@ -0,0 +1,242 @@
+#include "SpectrumAnalyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace audioserver {
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr int COPY_ATTEMPTS = 3;
+
+    float toDecibels(float linear) {
+        if (linear <= 0.0f) {
+            return SpectrumAnalyzer::FLOOR_DB;
+        }
+        return std::max(20.0f * std::log10(linear), SpectrumAnalyzer::FLOOR_DB);
+    }
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : tap_(new std::atomic<float>[static_cast<size_t>(MAX_CHANNELS) * TAP_SIZE])
+    , fft_(FFT_ORDER)
+    , window_(static_cast<size_t>(FFT_SIZE))
+    , frames_(static_cast<size_t>(MAX_CHANNELS), std::vector<float>(static_cast<size_t>(FFT_SIZE)))
+    , fftBuffer_(static_cast<size_t>(FFT_SIZE) * 2) {
+    for (size_t i = 0; i < static_cast<size_t>(MAX_CHANNELS) * TAP_SIZE; ++i) {
+        tap_[i].store(0.0f, std::memory_order_relaxed);
+    }
+
+    // Periodic Hann window. A full-scale sine then reads 0 dBFS once the
+    // one-sided magnitude is divided by half the window sum.
+    double windowSum = 0.0;
+    for (int i = 0; i < FFT_SIZE; ++i) {
+        double w = 0.5 - 0.5 * std::cos(2.0 * PI * i / FFT_SIZE);
+        window_[static_cast<size_t>(i)] = static_cast<float>(w);
+        windowSum += w;
+    }
+    magnitudeScale_ = static_cast<float>(2.0 / windowSum);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    stop();
+}
+
+void SpectrumAnalyzer::prepare(double sampleRate) {
+    sampleRate_.store(sampleRate > 0.0 ? sampleRate : 48000.0, std::memory_order_relaxed);
+    framesWritten_.store(0, std::memory_order_release);
+}
+
+void SpectrumAnalyzer::push(const float* const* channelData, int numChannels, int numSamples) {
+    numChannels = std::min(numChannels, MAX_CHANNELS);
+    tapChannels_.store(numChannels, std::memory_order_relaxed);
+
+    // Publish in pieces of at most MAX_PUSH frames so the worker's lap check
+    // stays valid for any callback size
+    uint64_t written = framesWritten_.load(std::memory_order_relaxed);
+    for (int offset = 0; offset < numSamples; offset += MAX_PUSH) {
+        int count = std::min(numSamples - offset, MAX_PUSH);
+        for (int ch = 0; ch < numChannels; ++ch) {
+            std::atomic<float>* tap = tap_.get() + static_cast<size_t>(ch) * TAP_SIZE;
+            const float* samples = channelData[ch] + offset;
+            for (int i = 0; i < count; ++i) {
+                tap[(written + static_cast<uint64_t>(i)) % TAP_SIZE].store(samples[i], std::memory_order_relaxed);
+            }
+        }
+        written += static_cast<uint64_t>(count);
+        framesWritten_.store(written, std::memory_order_release);
+    }
+}
+
+void SpectrumAnalyzer::start(double rateHz) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ || rateHz <= 0.0) {
+        return;
+    }
+    rateHz_ = std::min(rateHz, MAX_RATE_HZ);
+    running_ = true;
+    worker_ = std::thread(&SpectrumAnalyzer::workerThread, this);
+}
+
+void SpectrumAnalyzer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool SpectrumAnalyzer::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+double SpectrumAnalyzer::getRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_ ? rateHz_ : 0.0;
+}
+
+SpectrumAnalyzer::Snapshot SpectrumAnalyzer::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latest_;
+}
+
+void SpectrumAnalyzer::workerThread() {
+#ifdef __linux__
+    // Per-thread nice value on Linux; analysis should always yield to streaming
+    setpriority(PRIO_PROCESS, 0, 10);
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / rateHz_));
+    auto nextTime = std::chrono::steady_clock::now();
+
+    while (running_) {
+        if (cv_.wait_until(lock, nextTime, [this] { return !running_; })) {
+            break;
+        }
+
+        lock.unlock();
+        analyze();
+        lock.lock();
+
+        nextTime += period;
+        auto now = std::chrono::steady_clock::now();
+        if (nextTime < now) {
+            nextTime = now;
+        }
+    }
+}
+
+bool SpectrumAnalyzer::copyLatest(int numChannels) {
+    for (int attempt = 0; attempt < COPY_ATTEMPTS; ++attempt) {
+        uint64_t end = framesWritten_.load(std::memory_order_acquire);
+        if (end < static_cast<uint64_t>(FFT_SIZE)) {
+            return false;  // Not enough audio yet
+        }
+
+        uint64_t begin = end - FFT_SIZE;
+        for (int ch = 0; ch < numChannels; ++ch) {
+            const std::atomic<float>* tap = tap_.get() + static_cast<size_t>(ch) * TAP_SIZE;
+            float* frame = frames_[static_cast<size_t>(ch)].data();
+            for (int i = 0; i < FFT_SIZE; ++i) {
+                frame[i] = tap[(begin + static_cast<uint64_t>(i)) % TAP_SIZE].load(std::memory_order_relaxed);
+            }
+        }
+
+        // The copy is intact unless the writer may have wrapped onto the
+        // oldest frames read (including a push still in progress), or the
+        // tap was reset underneath us
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now = framesWritten_.load(std::memory_order_relaxed);
+        if (now >= end && now - end + MAX_PUSH <= static_cast<uint64_t>(TAP_SIZE - FFT_SIZE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SpectrumAnalyzer::updateBands(double sampleRate) {
+    if (sampleRate == bandSampleRate_) {
+        return;
+    }
+    bandSampleRate_ = sampleRate;
+
+    bandFrequencies_.assign(static_cast<size_t>(NUM_BANDS), 0.0f);
+    bandFirstBin_.assign(static_cast<size_t>(NUM_BANDS), 0);
+    bandLastBin_.assign(static_cast<size_t>(NUM_BANDS), 0);
+
+    double nyquist = sampleRate / 2.0;
+    double binWidth = sampleRate / FFT_SIZE;
+    double ratio = nyquist / MIN_FREQUENCY;
+    constexpr int lastBin = FFT_SIZE / 2;
+
+    for (int b = 0; b < NUM_BANDS; ++b) {
+        double low = MIN_FREQUENCY * std::pow(ratio, static_cast<double>(b) / NUM_BANDS);
+        double high = MIN_FREQUENCY * std::pow(ratio, static_cast<double>(b + 1) / NUM_BANDS);
+        double centre = std::sqrt(low * high);
+
+        int first = static_cast<int>(std::ceil(low / binWidth));
+        int last = static_cast<int>(std::ceil(high / binWidth)) - 1;
+        if (last < first) {
+            // Narrower than a bin (low bands): use the nearest one
+            first = last = static_cast<int>(std::lround(centre / binWidth));
+        }
+
+        auto index = static_cast<size_t>(b);
+        bandFrequencies_[index] = static_cast<float>(centre);
+        bandFirstBin_[index] = std::clamp(first, 1, lastBin);
+        bandLastBin_[index] = std::clamp(last, 1, lastBin);
+    }
+}
+
+void SpectrumAnalyzer::analyze() {
+    int numChannels = tapChannels_.load(std::memory_order_relaxed);
+    double sampleRate = sampleRate_.load(std::memory_order_relaxed);
+    if (numChannels <= 0 || !copyLatest(numChannels)) {
+        return;
+    }
+
+    updateBands(sampleRate);
+
+    Snapshot result;
+    result.sampleRate = sampleRate;
+    result.numChannels = numChannels;
+    result.frequencies = bandFrequencies_;
+    result.magnitudes.resize(static_cast<size_t>(numChannels));
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        const float* frame = frames_[static_cast<size_t>(ch)].data();
+        for (int i = 0; i < FFT_SIZE; ++i) {
+            fftBuffer_[static_cast<size_t>(i)] = frame[i] * window_[static_cast<size_t>(i)];
+        }
+        std::fill(fftBuffer_.begin() + FFT_SIZE, fftBuffer_.end(), 0.0f);
+        fft_.performFrequencyOnlyForwardTransform(fftBuffer_.data(), true);
+
+        // Peak bin per band, so pure tones read their true level
+        auto& bands = result.magnitudes[static_cast<size_t>(ch)];
+        bands.resize(static_cast<size_t>(NUM_BANDS));
+        for (size_t b = 0; b < bands.size(); ++b) {
+            float peak = 0.0f;
+            for (int bin = bandFirstBin_[b]; bin <= bandLastBin_[b]; ++bin) {
+                peak = std::max(peak, fftBuffer_[static_cast<size_t>(bin)]);
+            }
+            bands[b] = toDecibels(peak * magnitudeScale_);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.version = latest_.version + 1;
+    latest_ = std::move(result);
+}
+
+} // namespace audioserver
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace audioserver {
+
+// Log-binned magnitude spectra computed off the audio thread.
+//
+// The audio callback only calls push(), which copies samples into a
+// per-channel circular tap and publishes the frame count. A worker thread
+// wakes at the configured rate, copies the newest FFT_SIZE frames out of the
+// tap (retrying if the audio thread lapped it mid-copy), applies a Hann
+// window, runs the FFT and folds the bins into NUM_BANDS log-spaced bands.
+//
+// push() must only be called from one thread at a time.
+class SpectrumAnalyzer {
+public:
+    static constexpr int MAX_CHANNELS = 16;
+    static constexpr int FFT_ORDER = 12;
+    static constexpr int FFT_SIZE = 1 << FFT_ORDER;
+    static constexpr int NUM_BANDS = 64;
+    static constexpr double MIN_FREQUENCY = 20.0;
+    static constexpr double MAX_RATE_HZ = 60.0;
+    static constexpr float FLOOR_DB = -120.0f;
+
+    struct Snapshot {
+        uint64_t version = 0;  // 0 = nothing analyzed yet
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        std::vector<float> frequencies;              // Band centres in Hz
+        std::vector<std::vector<float>> magnitudes;  // [channel][band] in dBFS
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer();
+
+    // Call before audio starts flowing (not concurrently with push())
+    void prepare(double sampleRate);
+
+    void push(const float* const* channelData, int numChannels, int numSamples);
+
+    // Starts the worker at rateHz analyses per second; <= 0 leaves it off
+    void start(double rateHz);
+    void stop();
+
+    bool isRunning() const;
+    double getRate() const;
+
+    Snapshot snapshot() const;
+
+private:
+    // Frames the worker may lag behind before a copy counts as torn
+    static constexpr int TAP_SIZE = FFT_SIZE * 4;
+    static constexpr int MAX_PUSH = FFT_SIZE;
+
+    void workerThread();
+    void analyze();
+    bool copyLatest(int numChannels);
+    void updateBands(double sampleRate);
+
+    // Tap, written by the audio thread and read by the worker
+    std::unique_ptr<std::atomic<float>[]> tap_;
+    std::atomic<uint64_t> framesWritten_{0};
+    std::atomic<int> tapChannels_{0};
+    std::atomic<double> sampleRate_{48000.0};
+
+    // Worker state
+    juce::dsp::FFT fft_;
+    std::vector<float> window_;
+    float magnitudeScale_ = 1.0f;
+    std::vector<std::vector<float>> frames_;
+    std::vector<float> fftBuffer_;
+    double bandSampleRate_ = 0.0;
+    std::vector<float> bandFrequencies_;
+    std::vector<int> bandFirstBin_;
+    std::vector<int> bandLastBin_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread worker_;
+    bool running_ = false;
+    double rateHz_ = 0.0;
+    Snapshot latest_;
+};
+
+} // namespace audioserver
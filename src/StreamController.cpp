@@ -0,0 +1,600 @@
+#include "StreamController.h"
+#include "Interleave.h"
+#include "ThreadPolicy.h"
+#include "ToneGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace audioserver {
+
+namespace {
+    bool sameFormat(const StreamConfig& a, const StreamConfig& b) {
+        return a.sampleRate == b.sampleRate
+            && a.channels == b.channels
+            && a.bufferSize == b.bufferSize;
+    }
+
+    StreamController::Source senderSource(const Config& config) {
+        if (config.mode != Mode::Sender) {
+            return StreamController::Source::Device;
+        }
+        if (!config.playFile.empty()) {
+            return StreamController::Source::File;
+        }
+        return config.testTone ? StreamController::Source::TestTone : StreamController::Source::Device;
+    }
+
+    // Audio scheduled for later waits in the jitter buffer, so it holds the
+    // sync delay on top of the usual margin
+    size_t jitterBufferCapacity(const StreamConfig& config, int syncDelayMs) {
+        return static_cast<size_t>(config.sampleRate) * config.channels
+             * static_cast<size_t>(StreamController::JITTER_BUFFER_MS + syncDelayMs) / 1000;
+    }
+}
+
+StreamController::StreamController(AudioEngine& audioEngine, TransportBackend& transport, Config& config)
+    : audioEngine_(audioEngine)
+    , transport_(transport)
+    , config_(config)
+    , source_(senderSource(config)) {
+    streamConfig_.sampleRate = config.sampleRate;
+    streamConfig_.channels = config.channels;
+    streamConfig_.bufferSize = config.bufferSize;
+    incoming_ = streamConfig_;
+    ringRate_ = config.sampleRate;
+    scheduler_.setDelayMs(static_cast<int>(config.syncDelayMs));
+}
+
+StreamController::~StreamController() {
+    stop();
+}
+
+bool StreamController::start() {
+    if (config_.lockMemory) {
+        // Before the buffers below are allocated, so they are locked as they are mapped
+        std::string error;
+        if (!ThreadScheduler::shared().lockMemory(error)) {
+            std::cerr << "Failed to lock memory: " << error << std::endl;
+        }
+    }
+
+    transport_.setConnectionCallback([this](bool) { notifyStateChange(); });
+
+    if (config_.mode == Mode::Sender && !generatesAudio()) {
+        audioEngine_.setAudioCallback([this](const float* const* data, int channels, int samples) {
+            if (sending_.load(std::memory_order_acquire)) {
+                transport_.sendAudio(data, channels, samples);
+            }
+        });
+    } else if (config_.mode == Mode::Receiver) {
+        jitterBuffer_ = std::make_shared<RingBuffer<float>>(
+            jitterBufferCapacity(streamConfig_, scheduler_.getDelayMs()), streamConfig_.channels);
+        playbackRing_.store(jitterBuffer_.get(), std::memory_order_release);
+        jitterCapacity_.store(jitterBuffer_->capacity(), std::memory_order_relaxed);
+        jitterFill_.store(0, std::memory_order_relaxed);
+
+        transport_.setAudioReceivedCallback([this](const float* data, int channels, int samples, int64_t mediaNs) {
+            if (reopening_.load(std::memory_order_acquire)) {
+                return;
+            }
+            size_t totalSamples = static_cast<size_t>(channels * samples);
+            std::lock_guard<std::mutex> lock(ringMutex_);
+            if (resampler_ && resampler_->getNumChannels() == channels) {
+                size_t needed = resampler_->maxOutputFrames(samples) * static_cast<size_t>(channels);
+                if (resampled_.size() < needed) {
+                    resampled_.resize(needed);  // Only for chunks larger than the stream's buffer size
+                }
+                totalSamples = resampler_->process(data, samples, resampled_.data()) * static_cast<size_t>(channels);
+                data = resampled_.data();
+                if (mediaNs != NO_TIMESTAMP) {
+                    mediaNs -= resampler_->getLatencyNs();
+                }
+            }
+            size_t written = jitterBuffer_->write(data, totalSamples);
+            jitterFill_.store(jitterBuffer_->size(), std::memory_order_relaxed);
+            if (written < totalSamples) {
+                audioEngine_.getMetrics().recordOverrun();
+            }
+            scheduler_.written(mediaNs, written / static_cast<size_t>(channels), ringRate_);
+        });
+
+        transport_.setStreamConfigCallback([this](const StreamConfig& remote) {
+            onRemoteConfig(remote);
+        });
+        startFormatThread();
+
+        // Sized for the configured format up front; only a device that
+        // delivers larger blocks than requested grows it, once
+        std::vector<float> scratch(static_cast<size_t>(streamConfig_.channels) * streamConfig_.bufferSize);
+        audioEngine_.setPlaybackCallback([this, primed = false, interleavedBuffer = std::move(scratch)](
+                float* const* data, int channels, int samples, int64_t outputNs) mutable {
+            size_t totalSamples = static_cast<size_t>(channels * samples);
+            if (interleavedBuffer.size() < totalSamples) {
+                interleavedBuffer.resize(totalSamples);
+            }
+
+            // Off without a sync delay or a timestamping sender: nothing skipped or held
+            auto plan = scheduler_.plan(outputNs, samples, transport_.getClockEstimate());
+            const auto frameSize = static_cast<size_t>(channels);
+            const size_t held = static_cast<size_t>(plan.hold) * frameSize;
+
+            readingRing_.store(true);  // seq_cst, paired with replaceJitterBuffer()
+            auto* ring = playbackRing_.load();
+            size_t skipped = ring->skip(plan.skip * frameSize);
+            size_t read = ring->read(interleavedBuffer.data() + held, totalSamples - held);
+            jitterFill_.store(ring->size(), std::memory_order_relaxed);
+            readingRing_.store(false, std::memory_order_release);
+            scheduler_.consumed((skipped + read) / frameSize);
+
+            if (held > 0) {
+                // Waiting for the first frame's turn, or slewing one frame late
+                for (size_t i = 0; i < held; ++i) {
+                    interleavedBuffer[i] = plan.repeat && read > 0 ? interleavedBuffer[held + i % frameSize] : 0.0f;
+                }
+            }
+            if (held + read < totalSamples) {
+                // Underrun - fill remainder with silence. Counted once per
+                // dropout, not for every callback while the stream is idle.
+                std::fill(interleavedBuffer.begin() + static_cast<long>(held + read),
+                          interleavedBuffer.begin() + static_cast<long>(totalSamples), 0.0f);
+                if (primed) {
+                    audioEngine_.getMetrics().recordUnderrun();
+                }
+            }
+            primed = read > 0;
+
+            deinterleave(interleavedBuffer.data(), channels, samples, data);
+
+            return read > 0;
+        });
+    }
+
+    if (source_ == Source::File) {
+        // The file decides the stream format; only the buffer size is ours
+        filePlayer_ = std::make_unique<FilePlayer>();
+        std::string error;
+        if (!filePlayer_->open(config_.playFile, error)) {
+            lastError_ = "Failed to open " + config_.playFile + ": " + error;
+            filePlayer_.reset();
+            return false;
+        }
+        filePlayer_->setLooping(config_.loopPlayback);
+
+        std::lock_guard<std::mutex> lock(configMutex_);
+        streamConfig_.sampleRate = static_cast<uint32_t>(filePlayer_->getSampleRate());
+        streamConfig_.channels = static_cast<uint16_t>(filePlayer_->getNumChannels());
+        if (!validate(streamConfig_, error)) {
+            lastError_ = "Cannot stream " + config_.playFile + ": " + error;
+            return false;
+        }
+    }
+
+    // Open audio device (not needed when the sender generates its own audio)
+    if (!generatesAudio()) {
+        auto openStart = std::chrono::steady_clock::now();
+        if (!audioEngine_.openDevice(config_.device, config_.mode)) {
+            lastError_ = "Failed to open audio device";
+            return false;
+        }
+        deviceOpenMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+
+        {
+            std::lock_guard<std::mutex> lock(configMutex_);
+            streamConfig_ = audioEngine_.getStreamConfig();
+        }
+        if (config_.mode == Mode::Receiver) {
+            updateResampler();
+        }
+    }
+
+    if (!startTransport()) {
+        lastError_ = "Failed to start transport: " + transport_.getStatus().errorMessage.str();
+        return false;
+    }
+
+    if (generatesAudio()) {
+        startSourceThread();
+    }
+    return true;
+}
+
+void StreamController::stop() {
+    sending_ = false;
+    stopSourceThread();
+    stopFormatThread();
+}
+
+const char* StreamController::sourceToString() const {
+    switch (source_) {
+        case Source::Device:   return "device";
+        case Source::TestTone: return "test-tone";
+        case Source::File:     return "file";
+    }
+    return "unknown";
+}
+
+StreamConfig StreamController::getStreamConfig() const {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return streamConfig_;
+}
+
+StreamController::JitterFill StreamController::getJitterFill() const {
+    JitterFill fill;
+    fill.capacity = jitterCapacity_.load(std::memory_order_relaxed);
+    // A fill from the buffer a swap just replaced may exceed the new capacity
+    fill.samples = std::min(jitterFill_.load(std::memory_order_relaxed), fill.capacity);
+    return fill;
+}
+
+std::shared_ptr<const Resampler> StreamController::getResampler() const {
+    std::lock_guard<std::mutex> lock(ringMutex_);
+    return resampler_;
+}
+
+bool StreamController::validate(const StreamConfig& config, std::string& error) {
+    return config.validate(error);
+}
+
+StreamController::ReconfigureResult StreamController::reconfigure(const StreamConfig& requested) {
+    std::lock_guard<std::mutex> reconfigureLock(reconfigureMutex_);
+
+    ReconfigureResult result;
+    if (!validate(requested, result.error)) {
+        result.config = getStreamConfig();
+        return result;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    StreamConfig previous = getStreamConfig();
+    if (source_ == Source::File
+        && (requested.sampleRate != previous.sampleRate || requested.channels != previous.channels)) {
+        result.error = "sampleRate and channels are fixed by the file being played";
+        result.config = previous;
+        return result;
+    }
+    endRecordingOnFormatChange(previous, requested);
+    bool wasStreaming = transport_.state() == TransportState::Streaming;
+
+    if (config_.mode == Mode::Sender) {
+        // Quiesce the sources, then reconnect so the receiver gets a new header
+        sending_ = false;
+        stopSourceThread();
+        transport_.stop();
+
+        StreamConfig applied = requested;
+        if (!generatesAudio()) {
+            if (audioEngine_.applyStreamConfig(requested)) {
+                applied = audioEngine_.getStreamConfig();
+            } else {
+                result.error = "Device rejected the new configuration";
+                audioEngine_.applyStreamConfig(previous);
+                applied = audioEngine_.getStreamConfig();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(configMutex_);
+            streamConfig_ = applied;
+        }
+
+        if (!startTransport()) {
+            result.error = "Failed to restart transport: " + transport_.getStatus().errorMessage.str();
+        } else if (generatesAudio()) {
+            startSourceThread();
+        }
+    } else if (!applyLocal(requested, result.error)) {
+        applyLocal(previous, result.error);
+    }
+
+    if (result.error.empty() && wasStreaming && !waitForStreaming(RESUME_TIMEOUT_MS)) {
+        result.error = "Stream did not resume within " + std::to_string(RESUME_TIMEOUT_MS) + " ms";
+    }
+
+    result.success = result.error.empty();
+    result.config = getStreamConfig();
+    result.gapMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config_.sampleRate = result.config.sampleRate;
+        config_.channels = result.config.channels;
+        config_.bufferSize = result.config.bufferSize;
+    }
+    return result;
+}
+
+bool StreamController::setRouting(const ChannelRouting& routing, std::string& error) {
+    std::lock_guard<std::mutex> reconfigureLock(reconfigureMutex_);
+    if (generatesAudio()) {
+        error = std::string("No audio device in use (source is ") + sourceToString() + ")";
+        return false;
+    }
+    if (!audioEngine_.setRouting(routing, error)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(configMutex_);
+    config_.routing = routing;
+    return true;
+}
+
+bool StreamController::setSyncDelay(uint32_t delayMs, std::string& error) {
+    std::lock_guard<std::mutex> reconfigureLock(reconfigureMutex_);
+    if (config_.mode != Mode::Receiver) {
+        error = "Only receivers schedule playout";
+        return false;
+    }
+    if (delayMs > static_cast<uint32_t>(PlayoutScheduler::MAX_DELAY_MS)) {
+        error = "delayMs must be at most " + std::to_string(PlayoutScheduler::MAX_DELAY_MS);
+        return false;
+    }
+
+    scheduler_.setDelayMs(static_cast<int>(delayMs));
+    replaceJitterBuffer(getStreamConfig());
+
+    std::lock_guard<std::mutex> lock(configMutex_);
+    config_.syncDelayMs = delayMs;
+    return true;
+}
+
+bool StreamController::startTransport() {
+    StreamConfig config = getStreamConfig();
+
+    bool started = false;
+    if (config_.mode == Mode::Sender) {
+        started = transport_.startSender(config_.target, config_.port, config);
+    } else {
+        started = transport_.startReceiver(config_.port, config);
+    }
+
+    sending_ = started;
+    return started;
+}
+
+bool StreamController::applyLocal(const StreamConfig& config, std::string& error) {
+    replaceJitterBuffer(config);
+
+    if (!audioEngine_.applyStreamConfig(config)) {
+        error = "Device rejected the new configuration";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        streamConfig_ = audioEngine_.getStreamConfig();
+    }
+    updateResampler();
+    return true;
+}
+
+void StreamController::replaceJitterBuffer(const StreamConfig& config) {
+    auto ring = std::make_shared<RingBuffer<float>>(jitterBufferCapacity(config, scheduler_.getDelayMs()),
+                                                    config.channels);
+
+    std::shared_ptr<RingBuffer<float>> retired;
+    {
+        std::lock_guard<std::mutex> lock(ringMutex_);
+        retired = std::move(jitterBuffer_);
+        jitterBuffer_ = ring;
+        playbackRing_.store(ring.get());  // seq_cst, paired with the playback callback
+        jitterCapacity_.store(ring->capacity(), std::memory_order_relaxed);
+        jitterFill_.store(0, std::memory_order_relaxed);
+        scheduler_.reset();
+    }
+
+    // A callback that loaded the old buffer before the swap may still be
+    // reading it; that takes microseconds, never a whole block
+    while (readingRing_.load()) {
+        std::this_thread::yield();
+    }
+}
+
+void StreamController::updateResampler() {
+    StreamConfig incoming;
+    StreamConfig device;
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        incoming = incoming_;
+        device = streamConfig_;
+    }
+
+    std::shared_ptr<Resampler> resampler;
+    if (incoming.sampleRate != device.sampleRate) {
+        resampler = std::make_shared<Resampler>(incoming.sampleRate, device.sampleRate, incoming.channels);
+        std::cerr << "Resampling " << incoming.sampleRate << " Hz stream to "
+                  << device.sampleRate << " Hz device" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(ringMutex_);
+    ringRate_ = device.sampleRate;
+    resampler_ = std::move(resampler);
+    if (resampler_) {
+        resampled_.assign(resampler_->maxOutputFrames(static_cast<int>(incoming.bufferSize))
+                          * incoming.channels, 0.0f);
+    }
+}
+
+void StreamController::onRemoteConfig(const StreamConfig& remote) {
+    // Runs on the event loop before the connection's first chunk
+    std::lock_guard<std::mutex> lock(formatMutex_);
+    if (!formatPending_) {
+        std::lock_guard<std::mutex> configLock(configMutex_);
+        if (sameFormat(remote, incoming_)) {
+            return;
+        }
+    }
+    pendingFormat_ = remote;
+    formatPending_ = true;
+    reopening_.store(true, std::memory_order_release);
+    formatCv_.notify_one();
+}
+
+void StreamController::startFormatThread() {
+    formatRunning_ = true;
+    formatThread_ = std::thread(&StreamController::formatThread, this);
+}
+
+void StreamController::stopFormatThread() {
+    {
+        std::lock_guard<std::mutex> lock(formatMutex_);
+        formatRunning_ = false;
+    }
+    formatCv_.notify_all();
+    if (formatThread_.joinable()) {
+        formatThread_.join();
+    }
+}
+
+void StreamController::formatThread() {
+    // Filter design takes a few ms, so do it here rather than on the startup
+    // path or the event loop; the tables are shared, so later streams find
+    // them cached
+    Resampler::prepareCommonRates();
+
+    std::unique_lock<std::mutex> lock(formatMutex_);
+    while (true) {
+        formatCv_.wait(lock, [this] { return !formatRunning_ || formatPending_; });
+        if (!formatRunning_) {
+            return;
+        }
+        StreamConfig remote = pendingFormat_;
+        formatPending_ = false;
+
+        lock.unlock();
+        applyRemoteConfig(remote);
+        lock.lock();
+
+        // A newer header may have queued another change meanwhile
+        if (!formatPending_) {
+            reopening_.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void StreamController::applyRemoteConfig(const StreamConfig& remote) {
+    std::lock_guard<std::mutex> reconfigureLock(reconfigureMutex_);
+    std::string error;
+    {
+        // Compared with what the sender sent last, not the device, which may
+        // run at another rate (resampled) or have been reconfigured locally
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (sameFormat(remote, incoming_)) {
+            return;
+        }
+    }
+    if (!validate(remote, error)) {
+        std::cerr << "Ignoring sender format: " << error << std::endl;
+        return;
+    }
+    endRecordingOnFormatChange(getStreamConfig(), remote);
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        incoming_ = remote;
+    }
+    if (!applyLocal(remote, error)) {
+        std::cerr << "Failed to follow sender format change: " << error << std::endl;
+    }
+}
+
+void StreamController::endRecordingOnFormatChange(const StreamConfig& current, const StreamConfig& next) {
+    // A file has one format; finish it rather than record garbage into it
+    auto& recorder = audioEngine_.getRecorder();
+    if (recorder.isRecording()
+        && (current.sampleRate != next.sampleRate || current.channels != next.channels)) {
+        auto finished = recorder.stop();
+        std::cerr << "Stream format changed, finished recording " << finished.path << std::endl;
+    }
+}
+
+bool StreamController::waitForStreaming(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    return stateCv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+        return transport_.state() == TransportState::Streaming;
+    });
+}
+
+void StreamController::notifyStateChange() {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    stateCv_.notify_all();
+}
+
+void StreamController::startSourceThread() {
+    sourceRunning_ = true;
+    sourceThread_ = std::thread(&StreamController::sourceThread, this, getStreamConfig());
+}
+
+void StreamController::stopSourceThread() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        sourceRunning_ = false;
+    }
+    stateCv_.notify_all();
+    if (sourceThread_.joinable()) {
+        sourceThread_.join();
+    }
+}
+
+void StreamController::sourceThread(StreamConfig streamConfig) {
+    ThreadScheduler::shared().applyToCurrentThread(ThreadRole::Audio,
+                                                   source_ == Source::File ? "file" : "tone");
+
+    ToneGenerator toneGen(streamConfig.sampleRate, config_.testToneFrequency, streamConfig.channels);
+
+    const int bufferSize = static_cast<int>(streamConfig.bufferSize);
+    const int channels = static_cast<int>(streamConfig.channels);
+
+    std::vector<float*> channelPtrs(static_cast<size_t>(channels));
+    std::vector<std::vector<float>> channelBuffers(static_cast<size_t>(channels));
+
+    for (int ch = 0; ch < channels; ++ch) {
+        channelBuffers[static_cast<size_t>(ch)].resize(static_cast<size_t>(bufferSize));
+        channelPtrs[static_cast<size_t>(ch)] = channelBuffers[static_cast<size_t>(ch)].data();
+    }
+
+    audioEngine_.getLevelMeter().prepare(streamConfig.sampleRate);
+    audioEngine_.getSpectrumAnalyzer().prepare(streamConfig.sampleRate);
+    audioEngine_.getListenTap().prepare(streamConfig.sampleRate);
+
+    // Use steady clock for accurate timing
+    auto bufferDuration = std::chrono::microseconds(
+        static_cast<long>(1000000.0 * bufferSize / streamConfig.sampleRate));
+    auto nextTime = std::chrono::steady_clock::now();
+
+    while (sourceRunning_) {
+        if (transport_.state() == TransportState::Streaming) {
+            if (filePlayer_) {
+                filePlayer_->read(channelPtrs.data(), channels, bufferSize);
+            } else {
+                toneGen.generate(channelPtrs.data(), channels, bufferSize);
+            }
+            audioEngine_.getLevelMeter().process(channelPtrs.data(), channels, bufferSize);
+            audioEngine_.getSpectrumAnalyzer().push(channelPtrs.data(), channels, bufferSize);
+            audioEngine_.getRecorder().push(channelPtrs.data(), channels, bufferSize);
+            audioEngine_.getListenTap().push(channelPtrs.data(), channels, bufferSize);
+            transport_.sendAudio(const_cast<const float* const*>(channelPtrs.data()),
+                                 channels, bufferSize);
+
+            // Schedule next buffer at precise interval
+            nextTime += bufferDuration;
+            auto now = std::chrono::steady_clock::now();
+            if (nextTime > now) {
+                std::this_thread::sleep_until(nextTime);
+            } else {
+                // We're behind, reset timing
+                nextTime = now;
+            }
+        } else {
+            // Sleep until the transport connects (or we are stopped)
+            std::unique_lock<std::mutex> lock(stateMutex_);
+            stateCv_.wait(lock, [this] {
+                return !sourceRunning_ || transport_.state() == TransportState::Streaming;
+            });
+            nextTime = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+} // namespace audioserver
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "AudioEngine.h"
+#include "Config.h"
+#include "FilePlayer.h"
+#include "PlayoutScheduler.h"
+#include "Resampler.h"
+#include "RingBuffer.h"
+#include "transport/TransportBackend.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace audioserver {
+
+// Wires the audio engine to the transport (plus the jitter buffer in
+// receiver mode and the test tone or file source in sender mode) and applies
+// stream format changes at runtime.
+//
+// A sender reconfigures by reopening its device and reconnecting with a new
+// stream header; receivers pick the new header up on the next connection and
+// follow it on their format thread, since reopening a device blocks and the
+// header arrives on the shared event loop. A receiver reconfigured locally
+// only changes its own device and jitter buffer. Either way the transport's
+// socket and threads are reused where possible so the audible gap stays
+// short.
+//
+// Whenever a receiver's device runs at a different rate from the stream
+// (the device refused the sender's rate, or was reconfigured locally),
+// incoming audio is resampled on the event loop before it reaches the
+// jitter buffer, so it never plays at the wrong speed.
+//
+// With a sync delay set, a receiver plays each chunk that delay after the
+// sender captured it, going by the sender's clock (see PlayoutScheduler), so
+// several receivers of one sender play in phase. The jitter buffer grows by
+// the delay to hold the audio waiting for its turn.
+class StreamController {
+public:
+    static constexpr int JITTER_BUFFER_MS = 1000;
+    static constexpr int RESUME_TIMEOUT_MS = 1000;
+
+    static constexpr uint32_t MIN_SAMPLE_RATE = StreamConfig::MIN_SAMPLE_RATE;
+    static constexpr uint32_t MAX_SAMPLE_RATE = StreamConfig::MAX_SAMPLE_RATE;
+    static constexpr uint16_t MAX_CHANNELS = StreamConfig::MAX_CHANNELS;
+    static constexpr uint32_t MIN_BUFFER_SIZE = StreamConfig::MIN_BUFFER_SIZE;
+    static constexpr uint32_t MAX_BUFFER_SIZE = StreamConfig::MAX_BUFFER_SIZE;
+
+    struct ReconfigureResult {
+        bool success = false;
+        std::string error;
+        StreamConfig config;  // What the device actually accepted
+        double gapMs = 0.0;   // Time until audio was flowing again
+    };
+
+    // Where a sender's audio comes from
+    enum class Source { Device, TestTone, File };
+
+    StreamController(AudioEngine& audioEngine, TransportBackend& transport, Config& config);
+    ~StreamController();
+
+    // Opens the device (or the file being played; nothing for a test tone)
+    // and starts the transport. On failure getLastError() says which step
+    // failed.
+    bool start();
+    void stop();
+
+    ReconfigureResult reconfigure(const StreamConfig& requested);
+
+    // Replaces the channel routing matrix; serialized with format changes.
+    // Fails when there is no device (a sender playing a tone or file).
+    bool setRouting(const ChannelRouting& routing, std::string& error);
+
+    // Receiver: presentation delay on the sender's clock, 0 to play audio as
+    // it arrives. Replaces the jitter buffer, so playback restarts briefly.
+    bool setSyncDelay(uint32_t delayMs, std::string& error);
+    PlayoutScheduler::Status getPlayoutStatus() const { return scheduler_.status(); }
+
+    StreamConfig getStreamConfig() const;
+    Source getSource() const { return source_; }
+    const char* sourceToString() const;
+    const std::string& getLastError() const { return lastError_; }
+
+    // Time start() spent opening the audio device
+    double getDeviceOpenMs() const { return deviceOpenMs_; }
+
+    struct JitterFill {
+        size_t samples = 0;
+        size_t capacity = 0;  // Zero without a jitter buffer (senders)
+    };
+
+    // Jitter buffer level as of its last write or read, from atomics, so
+    // monitoring never waits on the receive path
+    JitterFill getJitterFill() const;
+
+    // Receiver: converts the stream to the device rate; null when they match
+    std::shared_ptr<const Resampler> getResampler() const;
+
+    // File source (null unless --play-file is in use); seek and loop are
+    // safe to call while streaming
+    FilePlayer* getFilePlayer() { return filePlayer_.get(); }
+
+    static bool validate(const StreamConfig& config, std::string& error);
+
+private:
+    bool startTransport();
+    bool generatesAudio() const { return source_ != Source::Device; }
+    void startSourceThread();
+    void stopSourceThread();
+    void sourceThread(StreamConfig config);
+
+    // Receiver: swaps in a jitter buffer sized for config and reopens the
+    // device
+    bool applyLocal(const StreamConfig& config, std::string& error);
+
+    // Returns once no playback callback can still be reading the old buffer
+    void replaceJitterBuffer(const StreamConfig& config);
+    void updateResampler();
+    void onRemoteConfig(const StreamConfig& remote);
+    void applyRemoteConfig(const StreamConfig& remote);
+    void startFormatThread();
+    void stopFormatThread();
+    void formatThread();
+    void endRecordingOnFormatChange(const StreamConfig& current, const StreamConfig& next);
+    bool waitForStreaming(int timeoutMs);
+    void notifyStateChange();
+
+    AudioEngine& audioEngine_;
+    TransportBackend& transport_;
+    Config& config_;
+    Source source_ = Source::Device;
+    std::unique_ptr<FilePlayer> filePlayer_;
+    std::string lastError_;
+    double deviceOpenMs_ = 0.0;
+
+    // Signalled on transport connects and drops, so waiting for the stream
+    // (source thread, reconfigure) never polls
+    std::mutex stateMutex_;
+    std::condition_variable stateCv_;
+
+    // Serializes reconfigure() against format changes arriving from the peer
+    std::mutex reconfigureMutex_;
+    mutable std::mutex configMutex_;
+    StreamConfig streamConfig_;
+    StreamConfig incoming_;  // Receiver: the format the sender streams
+
+    // Guards jitterBuffer_; the event loop holds it while writing. The
+    // audio thread reads through playbackRing_, which may be swapped while
+    // the device runs (format and sync delay changes); it raises readingRing_
+    // around each read, and replaceJitterBuffer() waits for it to drop
+    // before releasing the old buffer, as ChannelRouter does with its plans.
+    mutable std::mutex ringMutex_;
+    std::shared_ptr<RingBuffer<float>> jitterBuffer_;
+    std::atomic<RingBuffer<float>*> playbackRing_{nullptr};
+    std::atomic<bool> readingRing_{false};
+
+    // For getJitterFill(): capacity set on every swap, fill stored after
+    // each write and each read. Relaxed; they order nothing.
+    std::atomic<size_t> jitterCapacity_{0};
+    std::atomic<size_t> jitterFill_{0};
+
+    // Also guarded by ringMutex_ and used by the event loop
+    std::shared_ptr<Resampler> resampler_;
+    std::vector<float> resampled_;
+    uint32_t ringRate_ = 0;  // Of the audio in the jitter buffer (the device's)
+
+    // Receiver: told about every write to the jitter buffer (under
+    // ringMutex_), asked how to read it by the playback callback
+    PlayoutScheduler scheduler_;
+
+    // Sender: capture callbacks skip the transport while it reconnects
+    std::atomic<bool> sending_{false};
+
+    // Receiver: follows the sender's format changes. onRemoteConfig() runs on
+    // the event loop and only queues the latest format; received audio is
+    // dropped while reopening_, as it no longer fits the jitter buffer.
+    std::thread formatThread_;
+    std::mutex formatMutex_;
+    std::condition_variable formatCv_;
+    bool formatRunning_ = false;
+    bool formatPending_ = false;
+    StreamConfig pendingFormat_;
+    std::atomic<bool> reopening_{false};
+
+    // Sender: paces the test tone or file source in place of a device
+    std::thread sourceThread_;
+    std::atomic<bool> sourceRunning_{false};
+};
+
+} // namespace audioserver
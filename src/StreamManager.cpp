@@ -0,0 +1,384 @@
+#include "StreamManager.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace audioserver {
+
+namespace {
+    std::string trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t");
+        size_t last = text.find_last_not_of(" \t");
+        return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+    }
+
+    bool validName(const std::string& name) {
+        if (name.empty() || name.size() > StreamManager::MAX_NAME_LENGTH) {
+            return false;
+        }
+        return std::all_of(name.begin(), name.end(), [](char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                || c == '-' || c == '_';
+        });
+    }
+
+    bool parseUnsigned(const std::string& key, const std::string& text, uint32_t max,
+                       uint32_t& value, std::string& error) {
+        const char* start = text.c_str();
+        char* end = nullptr;
+        unsigned long parsed = std::strtoul(start, &end, 10);
+        if (end == start || *end != '\0' || *start == '-' || parsed > max) {
+            error = key + " must be an integer between 0 and " + std::to_string(max);
+            return false;
+        }
+        value = static_cast<uint32_t>(parsed);
+        return true;
+    }
+
+    bool parseFlag(const std::string& key, const std::string& text, bool& value, std::string& error) {
+        if (text == "1" || text == "true") {
+            value = true;
+        } else if (text == "0" || text == "false") {
+            value = false;
+        } else {
+            error = key + " must be true or false";
+            return false;
+        }
+        return true;
+    }
+
+    // Senders playing a tone or a file never open their device
+    bool opensDevice(const Config& config) {
+        return config.mode == Mode::Receiver || (!config.testTone && config.playFile.empty());
+    }
+
+    bool sameDevice(const Config& a, const Config& b) {
+        return opensDevice(a) && opensDevice(b) && a.mode == b.mode && a.device == b.device;
+    }
+
+    std::string deviceLabel(const Config& config) {
+        return config.device.empty() ? std::string("the default device") : "'" + config.device + "'";
+    }
+
+    StreamConfig streamConfigOf(const Config& config) {
+        StreamConfig stream;
+        stream.sampleRate = config.sampleRate;
+        stream.channels = config.channels;
+        stream.bufferSize = config.bufferSize;
+        return stream;
+    }
+}
+
+StreamManager::Stream::Stream(std::string name, const Config& config)
+    : name_(std::move(name))
+    , config_(config)
+    , controller_(audioEngine_, transport_, config_) {
+}
+
+StreamManager::Stream::~Stream() {
+    stop();
+}
+
+bool StreamManager::Stream::start(std::string& error) {
+    if (!audioEngine_.initialize(config_)) {
+        error = "Failed to initialize audio engine";
+        return false;
+    }
+    if (!controller_.start()) {
+        error = controller_.getLastError();
+        return false;
+    }
+    return true;
+}
+
+void StreamManager::Stream::stop() {
+    controller_.stop();
+    transport_.stop();
+    audioEngine_.shutdown();
+}
+
+StreamManager::~StreamManager() {
+    stopAll();
+}
+
+std::shared_ptr<StreamManager::Stream> StreamManager::add(const std::string& name, const Config& config,
+                                                          std::string& error) {
+    std::lock_guard<std::mutex> changeLock(changeMutex_);
+    if (!validate(name, config, error)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Stream> stream(new Stream(name, config));
+    if (!stream->start(error)) {
+        stream->stop();
+
+        // The usual reason a device that exists will not open
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : streams_) {
+            if (sameDevice(entry.second->config(), config)) {
+                error += " (stream '" + entry.first + "' already has " + deviceLabel(config)
+                       + " open; if the platform allows one client per device, as ALSA hw: devices do,"
+                         " use a PipeWire or JACK device or route the channels through one stream)";
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_[name] = stream;
+    if (primaryName_.empty()) {
+        primaryName_ = name;
+    }
+    return stream;
+}
+
+bool StreamManager::remove(const std::string& name, std::string& error) {
+    std::lock_guard<std::mutex> changeLock(changeMutex_);
+    std::shared_ptr<Stream> stream;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(name);
+        if (it == streams_.end()) {
+            error = "No stream named '" + name + "'";
+            return false;
+        }
+        if (name == primaryName_) {
+            error = "The primary stream cannot be removed";
+            return false;
+        }
+        stream = std::move(it->second);
+        streams_.erase(it);
+    }
+
+    stream->stop();
+    return true;
+}
+
+std::shared_ptr<StreamManager::Stream> StreamManager::find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(name);
+    return it == streams_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<StreamManager::Stream> StreamManager::primary() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(primaryName_);
+    return it == streams_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<StreamManager::Stream>> StreamManager::list() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<Stream>> streams;
+    streams.reserve(streams_.size());
+    auto primary = streams_.find(primaryName_);
+    if (primary != streams_.end()) {
+        streams.push_back(primary->second);
+    }
+    for (const auto& entry : streams_) {
+        if (entry.first != primaryName_) {
+            streams.push_back(entry.second);
+        }
+    }
+    return streams;
+}
+
+void StreamManager::stopAll() {
+    std::lock_guard<std::mutex> changeLock(changeMutex_);
+    std::map<std::string, std::shared_ptr<Stream>> streams;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams = streams_;
+    }
+    for (auto& entry : streams) {
+        entry.second->stop();
+    }
+}
+
+bool StreamManager::validate(const std::string& name, const Config& config, std::string& error) const {
+    if (!validName(name)) {
+        error = "Stream names are 1-" + std::to_string(MAX_NAME_LENGTH) + " letters, digits, '-' or '_'";
+        return false;
+    }
+    if (config.mode == Mode::Sender && config.target.empty()) {
+        error = "A sender needs a target";
+        return false;
+    }
+    if (config.mode == Mode::Receiver && (config.testTone || !config.playFile.empty())) {
+        error = "testTone and playFile only apply to senders";
+        return false;
+    }
+    if (config.playFile.empty() && !StreamController::validate(streamConfigOf(config), error)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (streams_.count(name) > 0) {
+        error = "A stream named '" + name + "' already exists";
+        return false;
+    }
+    if (streams_.size() >= MAX_STREAMS) {
+        error = "At most " + std::to_string(MAX_STREAMS) + " streams";
+        return false;
+    }
+    for (const auto& entry : streams_) {
+        const Config& other = entry.second->config();
+        if (config.mode == Mode::Receiver && other.mode == Mode::Receiver && other.port == config.port) {
+            error = "Port " + std::to_string(config.port) + " is already used by stream '" + entry.first + "'";
+            return false;
+        }
+    }
+    return channelConflict(name, config, error).empty();
+}
+
+bool StreamManager::checkDeviceChannels(const std::string& name, uint16_t channels, const ChannelRouting& routing,
+                                        std::string& error) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(name);
+    if (it == streams_.end()) {
+        return true;
+    }
+    Config config = it->second->config();
+    config.channels = channels;
+    config.routing = routing;
+    return channelConflict(name, config, error).empty();
+}
+
+std::string StreamManager::channelConflict(const std::string& name, const Config& config, std::string& error) const {
+    const bool sender = config.mode == Mode::Sender;
+    auto claimed = config.routing.claimedChannels(sender, config.channels);
+    for (const auto& entry : streams_) {
+        const Config& other = entry.second->config();
+        if (entry.first == name || !sameDevice(config, other)) {
+            continue;
+        }
+        auto shared = ChannelRouting::overlap(claimed, other.routing.claimedChannels(sender, other.channels));
+        if (!shared.empty()) {
+            std::string list;
+            for (int channel : shared) {
+                list += (list.empty() ? "" : ",") + std::to_string(channel);
+            }
+            error = std::string(sender ? "Input" : "Output") + " channels " + list + " of " + deviceLabel(config)
+                  + " are already used by stream '" + entry.first + "'";
+            return entry.first;
+        }
+    }
+    return {};
+}
+
+Config StreamManager::streamDefaults(const Config& base) {
+    Config config = base;
+    config.device.clear();
+    config.target.clear();
+    config.testTone = false;
+    config.playFile.clear();
+    config.loopPlayback = false;
+    config.routing = ChannelRouting{};
+    config.inputFile.clear();
+    config.outputFile.clear();
+    config.streams.clear();
+
+    // Only the primary stream has endpoints for these, so the others do not
+    // pay for an analyzer thread or a replay history nobody can reach
+    config.spectrumRate = 0;
+    config.timeShiftMb = 0;
+    config.lockMemory = false;  // Process-wide, done once by the primary
+    return config;
+}
+
+bool StreamManager::setField(Config& config, const std::string& key, const std::string& value, std::string& error) {
+    uint32_t number = 0;
+    if (key == "mode") {
+        if (value == "sender") {
+            config.mode = Mode::Sender;
+        } else if (value == "receiver") {
+            config.mode = Mode::Receiver;
+        } else {
+            error = "mode must be sender or receiver";
+            return false;
+        }
+    } else if (key == "device") {
+        config.device = value;
+    } else if (key == "target") {
+        config.target = value;
+    } else if (key == "port") {
+        if (!parseUnsigned(key, value, UINT16_MAX, number, error)) {
+            return false;
+        }
+        config.port = static_cast<uint16_t>(number);
+    } else if (key == "sampleRate") {
+        if (!parseUnsigned(key, value, StreamController::MAX_SAMPLE_RATE, config.sampleRate, error)) {
+            return false;
+        }
+    } else if (key == "channels") {
+        if (!parseUnsigned(key, value, StreamController::MAX_CHANNELS, number, error)) {
+            return false;
+        }
+        config.channels = static_cast<uint16_t>(number);
+    } else if (key == "bufferSize") {
+        if (!parseUnsigned(key, value, StreamController::MAX_BUFFER_SIZE, config.bufferSize, error)) {
+            return false;
+        }
+    } else if (key == "routes") {
+        if (!ChannelRouting::parse(value, config.routing, error)) {
+            return false;
+        }
+    } else if (key == "testTone") {
+        if (!parseFlag(key, value, config.testTone, error)) {
+            return false;
+        }
+    } else if (key == "testToneFreq") {
+        if (!parseUnsigned(key, value, 20000, config.testToneFrequency, error)) {
+            return false;
+        }
+    } else if (key == "playFile") {
+        config.playFile = value;
+    } else if (key == "loop") {
+        if (!parseFlag(key, value, config.loopPlayback, error)) {
+            return false;
+        }
+    } else if (key == "syncDelayMs") {
+        if (!parseUnsigned(key, value, PlayoutScheduler::MAX_DELAY_MS, config.syncDelayMs, error)) {
+            return false;
+        }
+    } else {
+        error = "Unknown stream setting '" + key + "'";
+        return false;
+    }
+    return true;
+}
+
+bool StreamManager::parseSpec(const std::string& spec, const Config& base,
+                              std::string& name, Config& config, std::string& error) {
+    name.clear();
+    config = streamDefaults(base);
+
+    std::istringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ';')) {
+        field = trim(field);
+        if (field.empty()) {
+            continue;
+        }
+        size_t equals = field.find('=');
+        if (equals == std::string::npos) {
+            error = "Expected <key>=<value>, got '" + field + "'";
+            return false;
+        }
+        std::string key = trim(field.substr(0, equals));
+        std::string value = trim(field.substr(equals + 1));
+        if (key == "name") {
+            name = value;
+        } else if (!setField(config, key, value, error)) {
+            return false;
+        }
+    }
+
+    if (name.empty()) {
+        error = "Missing name=<name>";
+        return false;
+    }
+    return true;
+}
+
+} // namespace audioserver
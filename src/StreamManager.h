@@ -0,0 +1,127 @@
+#pragma once
+
+#include "AudioEngine.h"
+#include "Config.h"
+#include "StreamController.h"
+#include "transport/TcpPcmBackend.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+
+// Hosts the process's streams by name, so one process can serve many
+// senders and receivers instead of one process per stream.
+//
+// Every stream has its own device (or device channels, see --route),
+// transport and port, jitter buffer and controller. They share the
+// transport event loop, the HTTP API and the thread policies.
+//
+// Each stream opens its device through its own AudioEngine, so streams on
+// one interface rely on the platform letting several clients open it
+// (CoreAudio, WASAPI shared mode, PipeWire and JACK do; a raw ALSA hw:
+// device does not, and the second open fails with an error naming the
+// stream holding it). Streams may never claim the same channels of one
+// device in the same direction. The primary stream comes from the command
+// line, backs the single-stream endpoints (/stream/config, /record, ...)
+// and lives as long as the process; further streams are added with
+// --stream or POST /streams and removed with DELETE /streams/{name}.
+// Monitoring covers them all: /metrics labels each series with
+// stream="<name>", /events carries a "streams" array, and /status, /meters
+// and /spectrum take ?stream=<name> (the primary without one).
+class StreamManager {
+public:
+    static constexpr size_t MAX_STREAMS = 64;
+    static constexpr size_t MAX_NAME_LENGTH = 32;
+    static constexpr const char* PRIMARY_NAME = "main";
+
+    class Stream {
+    public:
+        ~Stream();
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+
+        const std::string& name() const { return name_; }
+        const Config& config() const { return config_; }
+        AudioEngine& audioEngine() { return audioEngine_; }
+        TransportBackend& transport() { return transport_; }
+        StreamController& controller() { return controller_; }
+
+    private:
+        friend class StreamManager;
+
+        Stream(std::string name, const Config& config);
+        bool start(std::string& error);
+        void stop();
+
+        std::string name_;
+        Config config_;  // Kept up to date by the controller on format changes
+        AudioEngine audioEngine_;
+        TcpPcmBackend transport_;
+        StreamController controller_;
+    };
+
+    StreamManager() = default;
+    ~StreamManager();
+
+    StreamManager(const StreamManager&) = delete;
+    StreamManager& operator=(const StreamManager&) = delete;
+
+    // Creates and starts a stream. The first one added is the primary.
+    std::shared_ptr<Stream> add(const std::string& name, const Config& config, std::string& error);
+
+    // Stops a stream and forgets it; handlers still holding it keep a
+    // stopped stream until they let go. The primary cannot be removed.
+    bool remove(const std::string& name, std::string& error);
+
+    // What add() checks before opening anything: the name, a target for
+    // senders, the format, that no other receiver has the port and that no
+    // other stream uses the same device channels
+    bool validate(const std::string& name, const Config& config, std::string& error) const;
+
+    // Whether stream name, changed to channels and routing, would still
+    // leave every other stream's device channels alone
+    bool checkDeviceChannels(const std::string& name, uint16_t channels, const ChannelRouting& routing,
+                             std::string& error) const;
+
+    std::shared_ptr<Stream> find(const std::string& name) const;
+    std::shared_ptr<Stream> primary() const;
+    std::vector<std::shared_ptr<Stream>> list() const;  // Primary first, then by name
+
+    void stopAll();
+
+    // Config for a further stream: the process-wide settings of base with the
+    // per-stream ones reset, so nothing (ports, files, devices) is shared by
+    // accident
+    static Config streamDefaults(const Config& base);
+
+    // One per-stream setting, the value as text. Keys: mode, device,
+    // target, port, sampleRate, channels, bufferSize, routes, testTone,
+    // testToneFreq, playFile, loop, syncDelayMs.
+    static bool setField(Config& config, const std::string& key, const std::string& value, std::string& error);
+
+    // "name=drums;mode=receiver;port=9880;routes=0-1:8-9" (--stream);
+    // semicolons separate the fields since device names contain spaces and
+    // routes contain commas
+    static bool parseSpec(const std::string& spec, const Config& base,
+                          std::string& name, Config& config, std::string& error);
+
+private:
+    // The stream other than name using one of config's device channels, or
+    // empty; mutex_ must be held
+    std::string channelConflict(const std::string& name, const Config& config, std::string& error) const;
+
+    // Serializes add() and remove(), which open and close devices; held
+    // while a stream starts so two streams never claim one port
+    std::mutex changeMutex_;
+
+    // Guards the map only, so lookups never wait for a device to open
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Stream>> streams_;
+    std::string primaryName_;
+};
+
+} // namespace audioserver
@@ -0,0 +1,162 @@
+#include "TelemetryHub.h"
+#include <algorithm>
+
+namespace audioserver {
+
+namespace {
+    std::string formatEvent(const char* type, uint64_t id, const std::string& data) {
+        std::string event;
+        event.reserve(data.size() + 48);
+        event += "event: ";
+        event += type;
+        event += "\nid: ";
+        event += std::to_string(id);
+        event += "\ndata: ";
+        event += data;
+        event += "\n\n";
+        return event;
+    }
+}
+
+TelemetryHub::TelemetryHub(Renderer renderStatus, Renderer renderStats)
+    : renderStatus_(std::move(renderStatus))
+    , renderStats_(std::move(renderStats)) {
+}
+
+TelemetryHub::~TelemetryHub() {
+    stop();
+}
+
+void TelemetryHub::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    producer_ = std::thread(&TelemetryHub::producerThread, this);
+}
+
+void TelemetryHub::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    if (producer_.joinable()) {
+        producer_.join();
+    }
+}
+
+std::shared_ptr<TelemetryHub::Subscriber> TelemetryHub::subscribe(int intervalMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscribers_ >= MAX_SUBSCRIBERS) {
+        return nullptr;
+    }
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->interval = std::chrono::milliseconds(std::clamp(intervalMs, MIN_INTERVAL_MS, MAX_INTERVAL_MS));
+    subscriber->nextStats = std::chrono::steady_clock::now();
+    subscriber->lastSend = subscriber->nextStats;
+
+    subscribers_++;
+    cv_.notify_all();  // Wake the producer if it was idle
+    return subscriber;
+}
+
+void TelemetryHub::unsubscribe(const std::shared_ptr<Subscriber>& subscriber) {
+    if (!subscriber) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscribers_ > 0) {
+        subscribers_--;
+    }
+}
+
+size_t TelemetryHub::subscriberCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_;
+}
+
+bool TelemetryHub::waitForEvents(Subscriber& subscriber, std::string& out) {
+    std::shared_ptr<const std::string> status;
+    std::shared_ptr<const std::string> stats;
+    bool heartbeat = false;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true) {
+            cv_.wait(lock, [&] { return !running_ || tick_ != subscriber.lastTick; });
+            if (!running_) {
+                return false;
+            }
+            subscriber.lastTick = tick_;
+
+            auto now = std::chrono::steady_clock::now();
+            if (statusVersion_ != subscriber.lastStatusVersion && statusEvent_) {
+                status = statusEvent_;
+                subscriber.lastStatusVersion = statusVersion_;
+            }
+            if (now >= subscriber.nextStats && statsEvent_) {
+                stats = statsEvent_;
+                subscriber.nextStats += subscriber.interval;
+                if (subscriber.nextStats < now) {
+                    subscriber.nextStats = now + subscriber.interval;
+                }
+            }
+            heartbeat = now - subscriber.lastSend >= std::chrono::milliseconds(HEARTBEAT_MS);
+
+            if (status || stats || heartbeat) {
+                subscriber.lastSend = now;
+                break;
+            }
+        }
+    }
+
+    // Copy outside the lock so a slow client never holds up the producer
+    if (status) {
+        out += *status;
+    }
+    if (stats) {
+        out += *stats;
+    }
+    if (heartbeat && !status && !stats) {
+        out += ": keepalive\n\n";
+    }
+    return true;
+}
+
+void TelemetryHub::producerThread() {
+    auto nextTick = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (subscribers_ == 0) {
+            // Nobody listening, render nothing until someone subscribes
+            cv_.wait(lock, [this] { return !running_ || subscribers_ > 0; });
+            nextTick = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        lock.unlock();
+        std::string status = renderStatus_();
+        std::string stats = renderStats_();
+        lock.lock();
+
+        tick_++;
+        if (status != lastStatus_) {
+            statusVersion_++;
+            statusEvent_ = std::make_shared<const std::string>(formatEvent("status", tick_, status));
+            lastStatus_ = std::move(status);
+        }
+        statsEvent_ = std::make_shared<const std::string>(formatEvent("stats", tick_, stats));
+        cv_.notify_all();
+
+        nextTick += std::chrono::milliseconds(TICK_MS);
+        cv_.wait_until(lock, nextTick, [this] { return !running_; });
+    }
+}
+
+} // namespace audioserver
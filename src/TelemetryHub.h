@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace audioserver {
+
+// Fans live telemetry out to Server-Sent Events subscribers. A single
+// producer thread renders each tick once; subscribers only copy the
+// pre-rendered events, so N open streams cost one serialization per tick.
+//
+// Two event types are produced:
+// - "status": slowly changing state (mode, transport state, peer, config),
+//   sent to a subscriber only when it differs from what it last received
+// - "stats": counters and levels, sent at the subscriber's chosen interval
+class TelemetryHub {
+public:
+    using Renderer = std::function<std::string()>;
+
+    static constexpr int TICK_MS = 50;
+    static constexpr int MIN_INTERVAL_MS = TICK_MS;
+    static constexpr int MAX_INTERVAL_MS = 10000;
+    static constexpr int HEARTBEAT_MS = 15000;
+    static constexpr size_t MAX_SUBSCRIBERS = 32;
+
+    struct Subscriber {
+        std::chrono::milliseconds interval{TICK_MS};
+        std::chrono::steady_clock::time_point nextStats;
+        std::chrono::steady_clock::time_point lastSend;
+        uint64_t lastTick = 0;
+        uint64_t lastStatusVersion = 0;
+    };
+
+    TelemetryHub(Renderer renderStatus, Renderer renderStats);
+    ~TelemetryHub();
+
+    void start();
+    void stop();
+
+    // Returns nullptr when MAX_SUBSCRIBERS streams are already open
+    std::shared_ptr<Subscriber> subscribe(int intervalMs);
+    void unsubscribe(const std::shared_ptr<Subscriber>& subscriber);
+
+    // Blocks until the subscriber has events due and appends them to out.
+    // Returns false once the hub is stopping.
+    bool waitForEvents(Subscriber& subscriber, std::string& out);
+
+    size_t subscriberCount() const;
+
+private:
+    void producerThread();
+
+    Renderer renderStatus_;
+    Renderer renderStats_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread producer_;
+    bool running_ = false;
+    size_t subscribers_ = 0;
+
+    // Latest rendered events, replaced (never mutated) by the producer
+    std::shared_ptr<const std::string> statusEvent_;
+    std::shared_ptr<const std::string> statsEvent_;
+    std::string lastStatus_;
+    uint64_t tick_ = 0;
+    uint64_t statusVersion_ = 0;
+};
+
+} // namespace audioserver
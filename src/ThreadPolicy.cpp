@@ -0,0 +1,276 @@
+#include "ThreadPolicy.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <cerrno>
+#endif
+
+#ifdef __GLIBC__
+    #include <malloc.h>
+#endif
+
+namespace audioserver {
+
+namespace {
+    bool parseInt(const std::string& text, int& value) {
+        if (text.empty() || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return false;
+        }
+        value = std::stoi(text);
+        return true;
+    }
+
+    // "2,3,6-7"
+    bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find(',', start);
+            std::string item = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+            size_t dash = item.find('-');
+            int first = 0;
+            int last = 0;
+            if (dash == std::string::npos) {
+                if (!parseInt(item, first)) {
+                    return false;
+                }
+                last = first;
+            } else if (!parseInt(item.substr(0, dash), first) || !parseInt(item.substr(dash + 1), last)
+                       || last < first) {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+
+            if (end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        return !cpus.empty();
+    }
+
+#ifndef _WIN32
+    int toNative(SchedPolicy policy) {
+        switch (policy) {
+            case SchedPolicy::Fifo: return SCHED_FIFO;
+            case SchedPolicy::RoundRobin: return SCHED_RR;
+            default: return SCHED_OTHER;
+        }
+    }
+
+    SchedPolicy fromNative(int policy) {
+        switch (policy) {
+            case SCHED_FIFO: return SchedPolicy::Fifo;
+            case SCHED_RR: return SchedPolicy::RoundRobin;
+            default: return SchedPolicy::Other;
+        }
+    }
+#endif
+}
+
+bool ThreadPolicy::parse(const std::string& spec, ThreadPolicy& policy, std::string& error) {
+    policy = ThreadPolicy{};
+
+    std::string schedule = spec;
+    size_t at = spec.find('@');
+    if (at != std::string::npos) {
+        schedule = spec.substr(0, at);
+        if (!parseCpuList(spec.substr(at + 1), policy.cpus)) {
+            error = "Invalid CPU list in '" + spec + "'";
+            return false;
+        }
+    }
+
+    if (schedule.empty()) {
+        if (at == std::string::npos) {
+            error = "Empty thread policy";
+            return false;
+        }
+        return true;  // Affinity only
+    }
+
+    std::string name = schedule;
+    size_t colon = schedule.find(':');
+    if (colon != std::string::npos) {
+        name = schedule.substr(0, colon);
+        if (!parseInt(schedule.substr(colon + 1), policy.priority)) {
+            error = "Invalid priority in '" + spec + "'";
+            return false;
+        }
+    }
+
+    if (name == "fifo") {
+        policy.policy = SchedPolicy::Fifo;
+    } else if (name == "rr") {
+        policy.policy = SchedPolicy::RoundRobin;
+    } else if (name == "other") {
+        policy.policy = SchedPolicy::Other;
+    } else {
+        error = "Unknown scheduling policy '" + name + "' (expected fifo, rr or other)";
+        return false;
+    }
+
+    bool realtime = policy.policy == SchedPolicy::Fifo || policy.policy == SchedPolicy::RoundRobin;
+    if (realtime && (policy.priority < 1 || policy.priority > 99)) {
+        error = "Realtime priority must be between 1 and 99";
+        return false;
+    }
+    if (!realtime && policy.priority != 0) {
+        error = "Priority only applies to fifo and rr";
+        return false;
+    }
+    return true;
+}
+
+const char* roleToString(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::Audio: return "audio";
+        case ThreadRole::Network: return "network";
+        case ThreadRole::Api: return "api";
+    }
+    return "unknown";
+}
+
+const char* policyToString(SchedPolicy policy) {
+    switch (policy) {
+        case SchedPolicy::Default: return "default";
+        case SchedPolicy::Other: return "other";
+        case SchedPolicy::Fifo: return "fifo";
+        case SchedPolicy::RoundRobin: return "rr";
+    }
+    return "unknown";
+}
+
+ThreadScheduler& ThreadScheduler::shared() {
+    static ThreadScheduler scheduler;
+    return scheduler;
+}
+
+void ThreadScheduler::configure(ThreadRole role, const ThreadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policies_[static_cast<int>(role)] = policy;
+}
+
+void ThreadScheduler::applyToCurrentThread(ThreadRole role, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const ThreadPolicy& requested = policies_[static_cast<int>(role)];
+
+    ThreadInfo info;
+    info.name = name;
+    info.role = role;
+
+#ifdef _WIN32
+    if (requested.policy != SchedPolicy::Default || !requested.cpus.empty()) {
+        info.error = "Thread policies are not supported on this platform";
+    }
+#else
+    pthread_t self = pthread_self();
+
+    if (requested.policy != SchedPolicy::Default) {
+        sched_param param{};
+        param.sched_priority = requested.priority;
+        int result = pthread_setschedparam(self, toNative(requested.policy), &param);
+        if (result != 0) {
+            info.error = std::string("Failed to set ") + policyToString(requested.policy)
+                       + " scheduling: " + std::strerror(result);
+        }
+    }
+
+    #ifdef __linux__
+    if (!requested.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : requested.cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        int result = pthread_setaffinity_np(self, sizeof(set), &set);
+        if (result != 0 && info.error.empty()) {
+            info.error = std::string("Failed to set CPU affinity: ") + std::strerror(result);
+        }
+    }
+
+    cpu_set_t effective;
+    CPU_ZERO(&effective);
+    if (pthread_getaffinity_np(self, sizeof(effective), &effective) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &effective)) {
+                info.cpus.push_back(cpu);
+            }
+        }
+    }
+    #else
+    if (!requested.cpus.empty() && info.error.empty()) {
+        info.error = "CPU affinity is not supported on this platform";
+    }
+    #endif
+
+    int policy = SCHED_OTHER;
+    sched_param param{};
+    if (pthread_getschedparam(self, &policy, &param) == 0) {
+        info.policy = fromNative(policy);
+        info.priority = param.sched_priority;
+    }
+#endif
+
+    if (!info.error.empty()) {
+        std::cerr << "Thread '" << name << "': " << info.error << std::endl;
+    }
+
+    auto it = std::find_if(threads_.begin(), threads_.end(),
+                           [&](const ThreadInfo& existing) { return existing.name == name; });
+    if (it != threads_.end()) {
+        *it = std::move(info);
+    } else {
+        threads_.push_back(std::move(info));
+    }
+}
+
+bool ThreadScheduler::lockMemory(std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memoryLock_.requested = true;
+    if (memoryLock_.locked) {
+        return true;
+    }
+
+#ifdef _WIN32
+    memoryLock_.error = "Memory locking is not supported on this platform";
+#else
+    #ifdef __GLIBC__
+    // Keep freed memory (and large blocks) on the locked heap instead of
+    // trimming or mapping it separately
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    #endif
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+        memoryLock_.locked = true;
+        memoryLock_.error.clear();
+    } else {
+        memoryLock_.error = std::string("mlockall failed: ") + std::strerror(errno);
+    }
+#endif
+
+    error = memoryLock_.error;
+    return memoryLock_.locked;
+}
+
+std::vector<ThreadScheduler::ThreadInfo> ThreadScheduler::threads() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return threads_;
+}
+
+ThreadScheduler::MemoryLock ThreadScheduler::memoryLock() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryLock_;
+}
+
+} // namespace audioserver
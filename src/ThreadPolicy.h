@@ -0,0 +1,87 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+
+// Threads are configured by what they do, not by who created them:
+//   Audio   - device callbacks (hardware or headless) and the test tone source;
+//             sender network writes happen here too
+//   Network - the transport event loop (receive, accept, keepalives, reconnects)
+//   Api     - the HTTP listener; its worker threads inherit the policy
+enum class ThreadRole {
+    Audio,
+    Network,
+    Api
+};
+
+enum class SchedPolicy {
+    Default,  // Leave whatever the thread was created with
+    Other,
+    Fifo,
+    RoundRobin
+};
+
+struct ThreadPolicy {
+    SchedPolicy policy = SchedPolicy::Default;
+    int priority = 0;       // 1-99 for fifo/rr
+    std::vector<int> cpus;  // Empty = leave affinity alone
+
+    // "<policy>[:<priority>][@<cpus>]" or "@<cpus>", e.g. "fifo:80@2,3" or
+    // "rr:60@4-7". Policies: fifo, rr, other.
+    static bool parse(const std::string& spec, ThreadPolicy& policy, std::string& error);
+};
+
+const char* roleToString(ThreadRole role);
+const char* policyToString(SchedPolicy policy);
+
+// Applies the configured policy to threads as they start and records what
+// each one actually ended up with, since realtime priorities and memory
+// locking both depend on privileges (RLIMIT_RTPRIO / RLIMIT_MEMLOCK or
+// CAP_SYS_NICE / CAP_IPC_LOCK). Failures are reported, never fatal.
+class ThreadScheduler {
+public:
+    struct ThreadInfo {
+        std::string name;
+        ThreadRole role = ThreadRole::Audio;
+        SchedPolicy policy = SchedPolicy::Other;  // Effective
+        int priority = 0;
+        std::vector<int> cpus;  // Effective affinity (empty where unsupported)
+        std::string error;      // Why the requested policy was not applied
+    };
+
+    struct MemoryLock {
+        bool requested = false;
+        bool locked = false;
+        std::string error;
+    };
+
+    static ThreadScheduler& shared();
+
+    void configure(ThreadRole role, const ThreadPolicy& policy);
+
+    // Call from the thread itself. Takes a lock and allocates, so audio
+    // threads should call it once when they first run, not every callback.
+    void applyToCurrentThread(ThreadRole role, const std::string& name);
+
+    // mlockall(MCL_CURRENT | MCL_FUTURE): everything mapped now is faulted in
+    // and locked, and later allocations are populated as they are mapped.
+    // Also stops glibc returning freed heap to the OS, so buffers that are
+    // reallocated keep reusing resident pages.
+    bool lockMemory(std::string& error);
+
+    std::vector<ThreadInfo> threads() const;
+    MemoryLock memoryLock() const;
+
+private:
+    ThreadScheduler() = default;
+
+    mutable std::mutex mutex_;
+    ThreadPolicy policies_[3];
+    std::vector<ThreadInfo> threads_;  // One entry per name; restarts replace it
+    MemoryLock memoryLock_;
+};
+
+} // namespace audioserver
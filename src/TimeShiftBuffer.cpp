@@ -0,0 +1,162 @@
+#include "TimeShiftBuffer.h"
+#include "Interleave.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace audioserver {
+
+namespace {
+    constexpr size_t CHUNK_FLOATS = TimeShiftBuffer::CHUNK_BYTES / sizeof(float);
+}
+
+TimeShiftBuffer::TimeShiftBuffer() = default;
+TimeShiftBuffer::~TimeShiftBuffer() = default;
+
+void TimeShiftBuffer::allocate(uint64_t memoryBytes) {
+    chunks_.clear();
+    size_t count = static_cast<size_t>(memoryBytes / CHUNK_BYTES);
+    chunks_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Value-initialized, so every page is touched now rather than on the
+        // audio thread's first pass over it
+        chunks_.push_back(std::make_unique<float[]>(CHUNK_FLOATS));
+    }
+
+    writerLayout_ = Layout{};
+    written_ = 0;
+    layout_.store(writerLayout_);
+}
+
+void TimeShiftBuffer::prepare(double sampleRate) {
+    preparedRate_.store(static_cast<uint32_t>(sampleRate), std::memory_order_relaxed);
+}
+
+void TimeShiftBuffer::restart(int channels, uint32_t sampleRate) {
+    Layout layout;
+    layout.generation = writerLayout_.generation + 1;
+    layout.sampleRate = sampleRate;
+    layout.channels = channels;
+    layout.framesPerChunk = CHUNK_FLOATS / static_cast<size_t>(channels);
+    layout.capacityFrames = layout.framesPerChunk * chunks_.size();
+
+    writerLayout_ = layout;
+    written_.store(0, std::memory_order_relaxed);
+    layout_.store(layout);
+}
+
+void TimeShiftBuffer::push(const float* const* channelData, int numChannels, int numSamples) {
+    if (chunks_.empty() || numChannels <= 0) {
+        return;
+    }
+    numChannels = std::min(numChannels, MAX_CHANNELS);
+
+    uint32_t sampleRate = preparedRate_.load(std::memory_order_relaxed);
+    if (numChannels != writerLayout_.channels || sampleRate != writerLayout_.sampleRate) {
+        restart(numChannels, sampleRate);
+    }
+
+    const auto& layout = writerLayout_;
+    std::array<const float*, MAX_CHANNELS> inputs{};
+    uint64_t written = written_.load(std::memory_order_relaxed);
+    int done = 0;
+
+    // Publishing after every MAX_PUSH_FRAMES bounds how far ahead of
+    // written_ the writer can be, which is what read() checks against
+    while (done < numSamples) {
+        uint64_t slot = written % layout.capacityFrames;
+        uint64_t chunk = slot / layout.framesPerChunk;
+        uint64_t index = slot % layout.framesPerChunk;
+        int frames = static_cast<int>(std::min<uint64_t>(
+            {static_cast<uint64_t>(numSamples - done), layout.framesPerChunk - index,
+             static_cast<uint64_t>(MAX_PUSH_FRAMES)}));
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            inputs[static_cast<size_t>(ch)] = channelData[ch] + done;
+        }
+        interleave(inputs.data(), numChannels, frames,
+                   chunks_[chunk].get() + index * static_cast<uint64_t>(numChannels));
+
+        written += static_cast<uint64_t>(frames);
+        done += frames;
+        written_.store(written, std::memory_order_release);
+    }
+}
+
+bool TimeShiftBuffer::retained(const Layout& layout, uint64_t frame) const {
+    // The writer may be up to MAX_PUSH_FRAMES past written_ without having
+    // published it yet
+    uint64_t written = written_.load(std::memory_order_relaxed);
+    return written + MAX_PUSH_FRAMES <= frame + layout.capacityFrames;
+}
+
+bool TimeShiftBuffer::window(uint64_t fromMs, uint64_t durationMs, Window& window) const {
+    Layout layout = layout_.load();
+    uint64_t written = written_.load(std::memory_order_acquire);
+    if (layout.sampleRate == 0 || layout.capacityFrames <= MAX_PUSH_FRAMES || written == 0) {
+        return false;
+    }
+
+    // Keep one push clear of the write head so a fresh window is readable
+    uint64_t held = std::min(written, layout.capacityFrames - MAX_PUSH_FRAMES);
+    uint64_t from = fromMs * layout.sampleRate / 1000;
+    if (from == 0 || from > held) {
+        from = held;
+    }
+    uint64_t frames = durationMs * layout.sampleRate / 1000;
+    if (frames == 0 || frames > from) {
+        frames = from;
+    }
+
+    window.layout = layout;
+    window.startFrame = written - from;
+    window.frames = frames;
+    return true;
+}
+
+bool TimeShiftBuffer::read(const Window& window, uint64_t offset, uint64_t frames, float* dest) const {
+    const auto& layout = window.layout;
+    const uint64_t first = window.startFrame + offset;
+    if (offset + frames > window.frames || !retained(layout, first)) {
+        return false;
+    }
+
+    const auto channels = static_cast<uint64_t>(layout.channels);
+    uint64_t frame = first;
+    uint64_t remaining = frames;
+    while (remaining > 0) {
+        uint64_t slot = frame % layout.capacityFrames;
+        uint64_t chunk = slot / layout.framesPerChunk;
+        uint64_t index = slot % layout.framesPerChunk;
+        uint64_t run = std::min(remaining, layout.framesPerChunk - index);
+
+        std::memcpy(dest, chunks_[chunk].get() + index * channels, run * channels * sizeof(float));
+
+        dest += run * channels;
+        frame += run;
+        remaining -= run;
+    }
+
+    // Only now is it known whether the writer lapped the copy
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return layout_.load().generation == layout.generation && retained(layout, first);
+}
+
+TimeShiftBuffer::Status TimeShiftBuffer::status() const {
+    Status status;
+    status.enabled = isEnabled();
+    status.memoryBytes = static_cast<uint64_t>(chunks_.size()) * CHUNK_BYTES;
+
+    Layout layout = layout_.load();
+    uint64_t written = written_.load(std::memory_order_relaxed);
+    status.sampleRate = layout.sampleRate;
+    status.channels = layout.channels;
+    if (layout.sampleRate > 0 && layout.capacityFrames > MAX_PUSH_FRAMES) {
+        uint64_t capacity = layout.capacityFrames - MAX_PUSH_FRAMES;
+        status.capacitySeconds = static_cast<double>(capacity) / layout.sampleRate;
+        status.availableSeconds = static_cast<double>(std::min(written, capacity)) / layout.sampleRate;
+    }
+    return status;
+}
+
+} // namespace audioserver
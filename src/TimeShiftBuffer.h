@@ -0,0 +1,95 @@
+#pragma once
+
+#include "SeqLock.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+
+// Rolling in-memory capture of the last N seconds of audio, for replaying a
+// past window over the API after something went wrong.
+//
+// The memory is allocated (and touched) once up front as CHUNK_BYTES chunks,
+// so the footprint is fixed by configuration, can be many gigabytes without
+// one huge allocation, and never grows; how many seconds it holds depends on
+// the stream format. Each chunk holds whole interleaved frames.
+//
+// push() runs on the audio thread and never blocks or allocates. Readers
+// copy without locking and then check that the writer has not come round
+// and overwritten what they copied (seqlock style), so a reader that falls
+// too far behind gets a failed read, never mixed-up audio. A change of
+// channel count or sample rate starts the history afresh.
+class TimeShiftBuffer {
+public:
+    static constexpr size_t CHUNK_BYTES = 1 << 20;
+    static constexpr int MAX_CHANNELS = 64;
+    static constexpr int MAX_PUSH_FRAMES = 8192;
+
+    // The stream format the history was captured in. generation changes
+    // whenever it restarts, which invalidates any window taken before.
+    struct Layout {
+        uint32_t generation = 0;
+        uint32_t sampleRate = 0;
+        int channels = 0;
+        uint64_t framesPerChunk = 0;
+        uint64_t capacityFrames = 0;
+    };
+
+    // A span of history, in frames counted from the start of the generation
+    struct Window {
+        Layout layout;
+        uint64_t startFrame = 0;
+        uint64_t frames = 0;
+    };
+
+    struct Status {
+        bool enabled = false;
+        uint64_t memoryBytes = 0;
+        uint32_t sampleRate = 0;
+        int channels = 0;
+        double capacitySeconds = 0.0;   // What fits at the current format
+        double availableSeconds = 0.0;  // What has been captured so far
+    };
+
+    TimeShiftBuffer();
+    ~TimeShiftBuffer();
+
+    TimeShiftBuffer(const TimeShiftBuffer&) = delete;
+    TimeShiftBuffer& operator=(const TimeShiftBuffer&) = delete;
+
+    // Allocates memoryBytes (rounded down to whole chunks). Call before the
+    // audio starts; 0 leaves the buffer disabled.
+    void allocate(uint64_t memoryBytes);
+    bool isEnabled() const { return !chunks_.empty(); }
+
+    // Called before the device starts calling back (any thread)
+    void prepare(double sampleRate);
+
+    void push(const float* const* channelData, int numChannels, int numSamples);
+
+    // The window starting fromMs before now and lasting durationMs (0 = up
+    // to now), clamped to what is still held. False if nothing is.
+    bool window(uint64_t fromMs, uint64_t durationMs, Window& window) const;
+
+    // Copies frames [offset, offset + frames) of the window, interleaved.
+    // False if they have since been overwritten or the format has changed.
+    bool read(const Window& window, uint64_t offset, uint64_t frames, float* dest) const;
+
+    Status status() const;
+
+private:
+    void restart(int channels, uint32_t sampleRate);
+    bool retained(const Layout& layout, uint64_t frame) const;
+
+    std::vector<std::unique_ptr<float[]>> chunks_;
+
+    std::atomic<uint32_t> preparedRate_{0};
+    Layout writerLayout_;  // Audio thread only
+    SeqLock<Layout> layout_;
+    std::atomic<uint64_t> written_{0};  // Frames pushed in the current generation
+};
+
+} // namespace audioserver
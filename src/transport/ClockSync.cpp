@@ -0,0 +1,42 @@
+#include "ClockSync.h"
+
+namespace audioserver {
+
+void ClockSync::reset() {
+    count_ = 0;
+    next_ = 0;
+    exchanges_ = 0;
+    published_.store(ClockEstimate{});
+}
+
+void ClockSync::addExchange(int64_t originate, int64_t receive, int64_t transmit, int64_t arrival) {
+    Sample sample;
+    sample.rttNs = (arrival - originate) - (transmit - receive);
+    sample.offsetNs = ((receive - originate) + (transmit - arrival)) / 2;
+    if (sample.rttNs < 0) {
+        return;  // A real exchange cannot come back before it left
+    }
+
+    window_[next_] = sample;
+    next_ = (next_ + 1) % WINDOW;
+    if (count_ < WINDOW) {
+        ++count_;
+    }
+    ++exchanges_;
+
+    const Sample* best = &window_[0];
+    for (size_t i = 1; i < count_; ++i) {
+        if (window_[i].rttNs < best->rttNs) {
+            best = &window_[i];
+        }
+    }
+
+    ClockEstimate estimate;
+    estimate.locked = exchanges_ >= MIN_EXCHANGES;
+    estimate.offsetNs = best->offsetNs;
+    estimate.rttNs = best->rttNs;
+    estimate.exchanges = exchanges_;
+    published_.store(estimate);
+}
+
+} // namespace audioserver
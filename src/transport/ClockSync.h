@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../SeqLock.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace audioserver {
+
+// Media time of a chunk from a sender that does not stamp them
+constexpr int64_t NO_TIMESTAMP = INT64_MIN;
+
+// A receiver's view of its sender's clock
+struct ClockEstimate {
+    bool locked = false;    // Enough exchanges to trust offsetNs
+    int64_t offsetNs = 0;   // Sender's steady clock minus ours
+    int64_t rttNs = 0;      // Round trip of the exchange offsetNs came from
+    uint64_t exchanges = 0; // Since the connection was made
+};
+
+// Estimates the offset between a sender's steady clock and ours from
+// NTP-style four-timestamp exchanges.
+//
+// Every exchange gives offset = ((t2 - t1) + (t3 - t4)) / 2, which is exact
+// when the two directions take equally long; queueing behind audio makes
+// them differ, and then the round trip is long as well. So of the last
+// WINDOW exchanges the one with the shortest round trip wins, which keeps
+// queueing delay (the large, one-sided part of the error) out of the
+// estimate while still following slow drift between the two clocks.
+//
+// addExchange() and reset() must be called from one thread at a time;
+// estimate() is safe from any thread, the audio thread included.
+class ClockSync {
+public:
+    static constexpr size_t WINDOW = 16;
+    static constexpr uint64_t MIN_EXCHANGES = 4;
+
+    ClockSync() = default;
+
+    ClockSync(const ClockSync&) = delete;
+    ClockSync& operator=(const ClockSync&) = delete;
+
+    void reset();
+
+    // t1, t4 on our clock; t2, t3 on the sender's
+    void addExchange(int64_t originate, int64_t receive, int64_t transmit, int64_t arrival);
+
+    ClockEstimate estimate() const { return published_.load(); }
+
+    // Whether the window still lacks samples; callers exchange faster until then
+    bool filling() const { return count_ < WINDOW; }
+
+private:
+    struct Sample {
+        int64_t offsetNs = 0;
+        int64_t rttNs = 0;
+    };
+
+    std::array<Sample, WINDOW> window_{};
+    size_t count_ = 0;
+    size_t next_ = 0;
+    uint64_t exchanges_ = 0;
+    SeqLock<ClockEstimate> published_;
+};
+
+} // namespace audioserver
@@ -0,0 +1,373 @@
+#include "EventLoop.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/timerfd.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #define AUDIOSERVER_EPOLL 1
+#elif defined(_WIN32)
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define CLOSE_SOCKET closesocket
+    #define poll WSAPoll
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #define CLOSE_SOCKET close
+#endif
+
+namespace audioserver {
+
+namespace {
+    constexpr uint64_t WAKE_TOKEN = 0;
+    constexpr uint64_t TIMER_TOKEN = UINT64_MAX;
+    constexpr int MAX_EVENTS = 64;
+
+#ifdef AUDIOSERVER_EPOLL
+    uint32_t toEpoll(uint32_t events) {
+        uint32_t mask = 0;
+        if (events & EventLoop::READABLE) mask |= EPOLLIN;
+        if (events & EventLoop::WRITABLE) mask |= EPOLLOUT;
+        return mask;
+    }
+
+    uint32_t fromEpoll(uint32_t mask) {
+        uint32_t events = 0;
+        if (mask & EPOLLIN) events |= EventLoop::READABLE;
+        if (mask & EPOLLOUT) events |= EventLoop::WRITABLE;
+        if (mask & (EPOLLERR | EPOLLHUP)) events |= EventLoop::HANGUP;
+        return events;
+    }
+#else
+    short toPoll(uint32_t events) {
+        short mask = 0;
+        if (events & EventLoop::READABLE) mask |= POLLIN;
+        if (events & EventLoop::WRITABLE) mask |= POLLOUT;
+        return mask;
+    }
+
+    uint32_t fromPoll(short mask) {
+        uint32_t events = 0;
+        if (mask & POLLIN) events |= EventLoop::READABLE;
+        if (mask & POLLOUT) events |= EventLoop::WRITABLE;
+        if (mask & (POLLERR | POLLHUP | POLLNVAL)) events |= EventLoop::HANGUP;
+        return events;
+    }
+#endif
+}
+
+EventLoop& EventLoop::shared() {
+    static EventLoop loop;
+    return loop;
+}
+
+EventLoop::EventLoop() {
+#ifdef AUDIOSERVER_EPOLL
+    pollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeSendFd_ = wakeFd_;
+
+    epoll_event wakeEvent{};
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.u64 = WAKE_TOKEN;
+    epoll_ctl(pollFd_, EPOLL_CTL_ADD, wakeFd_, &wakeEvent);
+
+    epoll_event timerEvent{};
+    timerEvent.events = EPOLLIN;
+    timerEvent.data.u64 = TIMER_TOKEN;
+    epoll_ctl(pollFd_, EPOLL_CTL_ADD, timerFd_, &timerEvent);
+
+    if (pollFd_ < 0 || wakeFd_ < 0 || timerFd_ < 0) {
+        std::cerr << "Failed to create transport event loop" << std::endl;
+    }
+#else
+    // A UDP socket connected to itself: portable to every poll() flavour,
+    // including WSAPoll, which only accepts sockets
+    auto sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &length);
+    connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(sock, FIONBIO, &nonBlocking);
+#else
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    wakeFd_ = static_cast<int>(sock);
+    wakeSendFd_ = wakeFd_;
+#endif
+
+    thread_ = std::thread(&EventLoop::run, this);
+    threadId_ = thread_.get_id();
+}
+
+EventLoop::~EventLoop() {
+    post([this] { running_ = false; });
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+#ifdef AUDIOSERVER_EPOLL
+    close(timerFd_);
+    close(wakeFd_);
+    close(pollFd_);
+#else
+    CLOSE_SOCKET(wakeFd_);
+#endif
+}
+
+void EventLoop::watch(int fd, uint32_t events, IoCallback callback) {
+    unwatch(fd);
+
+    uint64_t token = nextToken_++;
+    watches_[token] = Watch{fd, events, std::move(callback)};
+    tokensByFd_[fd] = token;
+
+#ifdef AUDIOSERVER_EPOLL
+    epoll_event event{};
+    event.events = toEpoll(events);
+    event.data.u64 = token;
+    epoll_ctl(pollFd_, EPOLL_CTL_ADD, fd, &event);
+#endif
+}
+
+void EventLoop::unwatch(int fd) {
+    auto it = tokensByFd_.find(fd);
+    if (it == tokensByFd_.end()) {
+        return;
+    }
+
+#ifdef AUDIOSERVER_EPOLL
+    epoll_ctl(pollFd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+    watches_.erase(it->second);
+    tokensByFd_.erase(it);
+}
+
+EventLoop::TimerId EventLoop::addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds period,
+                                       TimerCallback callback) {
+    TimerId id = nextTimerId_++;
+    timers_[id] = Timer{Clock::now() + delay, period, std::move(callback)};
+    return id;
+}
+
+void EventLoop::cancelTimer(TimerId id) {
+    timers_.erase(id);
+}
+
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        posted_.push_back(std::move(task));
+    }
+    wake();
+}
+
+void EventLoop::runSync(const std::function<void()>& task) {
+    if (isLoopThread()) {
+        task();
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+
+    post([&] {
+        task();
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        done.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return finished; });
+}
+
+void EventLoop::wake() {
+#ifdef AUDIOSERVER_EPOLL
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = write(wakeSendFd_, &one, sizeof(one));
+#else
+    char byte = 0;
+    send(wakeSendFd_, &byte, 1, 0);
+#endif
+}
+
+void EventLoop::drainWake() {
+#ifdef AUDIOSERVER_EPOLL
+    uint64_t count;
+    [[maybe_unused]] auto bytesRead = read(wakeFd_, &count, sizeof(count));
+#else
+    char buffer[64];
+    while (recv(wakeFd_, buffer, sizeof(buffer), 0) > 0) {
+    }
+#endif
+}
+
+void EventLoop::runPosted() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        tasks.swap(posted_);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::runDueTimers() {
+    auto now = Clock::now();
+
+    // Collect first: callbacks may add or cancel timers
+    std::vector<TimerId> due;
+    for (const auto& [id, timer] : timers_) {
+        if (timer.deadline <= now) {
+            due.push_back(id);
+        }
+    }
+    std::sort(due.begin(), due.end());
+
+    for (TimerId id : due) {
+        auto it = timers_.find(id);
+        if (it == timers_.end()) {
+            continue;  // Cancelled by an earlier callback
+        }
+
+        TimerCallback callback = it->second.callback;
+        if (it->second.period.count() > 0) {
+            // Keep the cadence, but never try to catch up on missed ticks
+            it->second.deadline = std::max(it->second.deadline + it->second.period, now);
+        } else {
+            timers_.erase(it);
+        }
+        callback();
+    }
+}
+
+EventLoop::Clock::time_point EventLoop::nextDeadline() const {
+    auto next = Clock::time_point::max();
+    for (const auto& [id, timer] : timers_) {
+        next = std::min(next, timer.deadline);
+    }
+    return next;
+}
+
+void EventLoop::armTimerFd() {
+#ifdef AUDIOSERVER_EPOLL
+    auto next = nextDeadline();
+    if (next == armedDeadline_) {
+        return;
+    }
+    armedDeadline_ = next;
+
+    // steady_clock is CLOCK_MONOTONIC, so deadlines can be armed as absolute
+    // times; an all-zero value disarms
+    itimerspec spec{};
+    if (next != Clock::time_point::max()) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+        ns = std::max<int64_t>(ns, 1);
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+    timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+#endif
+}
+
+void EventLoop::dispatch(uint64_t token, uint32_t events) {
+    auto it = watches_.find(token);
+    if (it == watches_.end()) {
+        return;  // Unwatched by an earlier callback in this batch
+    }
+
+    // Copy: the callback may unwatch (and so destroy) itself
+    IoCallback callback = it->second.callback;
+    callback(events);
+}
+
+void EventLoop::run() {
+#ifdef AUDIOSERVER_EPOLL
+    epoll_event events[MAX_EVENTS];
+
+    while (running_) {
+        armTimerFd();
+
+        int count = epoll_wait(pollFd_, events, MAX_EVENTS, -1);
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "Transport event loop failed" << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            uint64_t token = events[i].data.u64;
+            if (token == WAKE_TOKEN) {
+                drainWake();
+            } else if (token == TIMER_TOKEN) {
+                uint64_t expirations;
+                [[maybe_unused]] auto bytesRead = read(timerFd_, &expirations, sizeof(expirations));
+                armedDeadline_ = Clock::time_point::max();
+            } else {
+                dispatch(token, fromEpoll(events[i].events));
+            }
+        }
+
+        runPosted();
+        runDueTimers();
+    }
+#else
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> tokens;
+
+    while (running_) {
+        fds.clear();
+        tokens.clear();
+        fds.push_back(pollfd{static_cast<decltype(pollfd::fd)>(wakeFd_), POLLIN, 0});
+        tokens.push_back(WAKE_TOKEN);
+        for (const auto& [token, watch] : watches_) {
+            fds.push_back(pollfd{static_cast<decltype(pollfd::fd)>(watch.fd), toPoll(watch.events), 0});
+            tokens.push_back(token);
+        }
+
+        int timeoutMs = -1;
+        auto next = nextDeadline();
+        if (next != Clock::time_point::max()) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next - Clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<int64_t>(remaining, 0));
+        }
+
+        int count = poll(fds.data(), static_cast<unsigned long>(fds.size()), timeoutMs);
+        if (count > 0) {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (fds[i].revents == 0) {
+                    continue;
+                }
+                if (tokens[i] == WAKE_TOKEN) {
+                    drainWake();
+                } else {
+                    dispatch(tokens[i], fromPoll(fds[i].revents));
+                }
+            }
+        }
+
+        runPosted();
+        runDueTimers();
+    }
+#endif
+}
+
+} // namespace audioserver
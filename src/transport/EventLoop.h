@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace audioserver {
+
+// Single-threaded reactor shared by every transport connection: socket
+// readiness and timers (keepalives, disconnect deadlines, connect timeouts,
+// reconnect backoff) are all dispatched from one thread.
+//
+// On Linux this is epoll with one timerfd armed for the earliest pending
+// timer and an eventfd for cross-thread wakeups. Elsewhere the same loop
+// runs on poll() with the timer deadline as its timeout and a loopback
+// socket for wakeups.
+//
+// watch(), unwatch(), addTimer() and cancelTimer() must be called on the
+// loop thread; other threads hand work over with post() or runSync().
+// Callbacks run on the loop thread and must not block.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using IoCallback = std::function<void(uint32_t events)>;
+    using TimerCallback = std::function<void()>;
+    using TimerId = uint64_t;
+
+    static constexpr uint32_t READABLE = 1 << 0;
+    static constexpr uint32_t WRITABLE = 1 << 1;
+    static constexpr uint32_t HANGUP = 1 << 2;  // Error or peer hangup; always reported
+
+    // The process-wide loop, started on first use
+    static EventLoop& shared();
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool isLoopThread() const { return std::this_thread::get_id() == threadId_; }
+
+    // Replaces any existing watch on fd
+    void watch(int fd, uint32_t events, IoCallback callback);
+    void unwatch(int fd);
+
+    // period of zero makes a one-shot timer
+    TimerId addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds period, TimerCallback callback);
+    void cancelTimer(TimerId id);
+
+    void post(std::function<void()> task);
+
+    // Runs task on the loop thread and waits for it; inline when already there
+    void runSync(const std::function<void()>& task);
+
+private:
+    struct Watch {
+        int fd = -1;
+        uint32_t events = 0;
+        IoCallback callback;
+    };
+
+    struct Timer {
+        Clock::time_point deadline;
+        std::chrono::milliseconds period{0};
+        TimerCallback callback;
+    };
+
+    void run();
+    void wake();
+    void drainWake();
+    void runPosted();
+    void runDueTimers();
+    Clock::time_point nextDeadline() const;
+    void armTimerFd();
+    void dispatch(uint64_t token, uint32_t events);
+
+    std::thread thread_;
+    std::thread::id threadId_;
+    bool running_ = true;  // Loop thread only, after construction
+
+    int pollFd_ = -1;   // epoll instance (Linux)
+    int timerFd_ = -1;  // timerfd (Linux)
+    int wakeFd_ = -1;   // eventfd (Linux) or the receiving end of the wake socket
+    int wakeSendFd_ = -1;
+
+    // Watches are keyed by a token that is never reused, so an event already
+    // returned for an fd that was closed and reopened is not misdelivered
+    std::unordered_map<uint64_t, Watch> watches_;
+    std::unordered_map<int, uint64_t> tokensByFd_;
+    uint64_t nextToken_ = 1;
+
+    std::unordered_map<TimerId, Timer> timers_;
+    TimerId nextTimerId_ = 1;
+    Clock::time_point armedDeadline_ = Clock::time_point::max();
+
+    std::mutex postMutex_;
+    std::vector<std::function<void()>> posted_;
+};
+
+} // namespace audioserver
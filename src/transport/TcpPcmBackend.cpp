@@ -1,7 +1,13 @@
 #include "TcpPcmBackend.h"
+#include "../Interleave.h"
 #include <iostream>
 #include <cstring>
 #include <chrono>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <iterator>
+#include <utility>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -10,6 +16,7 @@
     using socket_t = SOCKET;
     #define CLOSE_SOCKET closesocket
     #define SOCKET_ERROR_CODE WSAGetLastError()
+    #define SEND_FLAGS 0
 #else
     #include <sys/socket.h>
     #include <netinet/in.h>
@@ -21,11 +28,63 @@
     #define INVALID_SOCKET -1
     #define CLOSE_SOCKET close
     #define SOCKET_ERROR_CODE errno
+    // A peer that goes away must surface as a send error, not kill us with SIGPIPE
+    #ifdef MSG_NOSIGNAL
+        #define SEND_FLAGS MSG_NOSIGNAL
+    #else
+        #define SEND_FLAGS 0
+    #endif
 #endif
 
 namespace audioserver {
 
-TcpPcmBackend::TcpPcmBackend() {
+namespace {
+    void setNonBlocking(int sock, bool nonBlocking) {
+#ifdef _WIN32
+        u_long mode = nonBlocking ? 1 : 0;
+        ioctlsocket(static_cast<socket_t>(sock), FIONBIO, &mode);
+#else
+        int flags = fcntl(sock, F_GETFL, 0);
+        fcntl(sock, F_SETFL, nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+    }
+
+    bool wouldBlock() {
+#ifdef _WIN32
+        int error = WSAGetLastError();
+        return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS || errno == EINTR;
+#endif
+    }
+
+    void closeSocket(int& sock) {
+        if (sock != -1) {
+            CLOSE_SOCKET(sock);
+            sock = -1;
+        }
+    }
+
+    EventLoop& transportLoop() {
+#ifdef _WIN32
+        // Winsock must be up before the loop creates its wake socket
+        static const bool winsockReady = [] {
+            WSADATA wsaData;
+            return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+        }();
+        (void)winsockReady;
+#endif
+        return EventLoop::shared();
+    }
+
+    int64_t steadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+TcpPcmBackend::TcpPcmBackend()
+    : loop_(transportLoop()) {
 #ifdef _WIN32
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -44,14 +103,28 @@ bool TcpPcmBackend::startSender(const std::string& targetHost, uint16_t port, co
         return false;
     }
 
+    sockaddr_in addr{};
+    if (inet_pton(AF_INET, targetHost.c_str(), &addr.sin_addr) <= 0) {
+        setError("Invalid address: " + targetHost);
+        state_ = TransportState::Error;
+        return false;
+    }
+
     targetHost_ = targetHost;
     port_ = port;
     streamConfig_ = config;
     running_ = true;
+
+    // Touch the packet buffers now so the first chunks neither allocate nor fault
+    interleavedBuffer_.assign(static_cast<size_t>(config.channels) * config.bufferSize, 0.0f);
+    txBacklog_.reserve(CHUNK_HEADER_SIZE + CHUNK_TIMESTAMP_SIZE + interleavedBuffer_.size() * sizeof(float));
     state_ = TransportState::Connecting;
 
-    workerThread_ = std::thread(&TcpPcmBackend::senderThread, this);
-    keepaliveThread_ = std::thread(&TcpPcmBackend::keepaliveThread, this);
+    loop_.runSync([this] {
+        backoffMs_ = RECONNECT_INITIAL_MS;
+        everConnected_ = false;
+        beginConnect();
+    });
 
     return true;
 }
@@ -65,12 +138,14 @@ bool TcpPcmBackend::startReceiver(uint16_t port, const StreamConfig& config) {
     streamConfig_ = config;
     running_ = true;
     state_ = TransportState::Connecting;
+    audioBuffer_.assign(static_cast<size_t>(config.channels) * config.bufferSize, 0.0f);
 
     // Create server socket
     serverSocket_ = static_cast<int>(socket(AF_INET, SOCK_STREAM, 0));
     if (serverSocket_ == INVALID_SOCKET) {
-        errorMessage_ = "Failed to create socket";
+        setError("Failed to create socket");
         state_ = TransportState::Error;
+        running_ = false;
         return false;
     }
 
@@ -83,104 +158,194 @@ bool TcpPcmBackend::startReceiver(uint16_t port, const StreamConfig& config) {
     addr.sin_port = htons(port);
 
     if (bind(serverSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-        errorMessage_ = "Failed to bind to port " + std::to_string(port);
-        CLOSE_SOCKET(serverSocket_);
-        serverSocket_ = -1;
+        setError("Failed to bind to port " + std::to_string(port));
+        closeSocket(serverSocket_);
         state_ = TransportState::Error;
+        running_ = false;
         return false;
     }
 
     if (listen(serverSocket_, 1) < 0) {
-        errorMessage_ = "Failed to listen";
-        CLOSE_SOCKET(serverSocket_);
-        serverSocket_ = -1;
+        setError("Failed to listen");
+        closeSocket(serverSocket_);
         state_ = TransportState::Error;
+        running_ = false;
         return false;
     }
 
-    acceptThread_ = std::thread(&TcpPcmBackend::acceptThread, this);
-    keepaliveThread_ = std::thread(&TcpPcmBackend::keepaliveThread, this);
+    setNonBlocking(serverSocket_, true);
+    loop_.runSync([this] {
+        loop_.watch(serverSocket_, EventLoop::READABLE, [this](uint32_t) { onAcceptReady(); });
+    });
 
     return true;
 }
 
 void TcpPcmBackend::stop() {
+    if (!running_) {
+        state_ = TransportState::Disconnected;
+        return;
+    }
+
+    // Everything the loop does for this backend happens inside callbacks,
+    // so once teardown has run on the loop thread nothing refers to us
+    loop_.runSync([this] { teardown(); });
+
     running_ = false;
-    cv_.notify_all();
+    state_ = TransportState::Disconnected;
+}
 
-    if (socket_ != -1) {
-        CLOSE_SOCKET(socket_);
-        socket_ = -1;
-    }
-    if (clientSocket_ != -1) {
-        CLOSE_SOCKET(clientSocket_);
-        clientSocket_ = -1;
-    }
-    if (serverSocket_ != -1) {
-        CLOSE_SOCKET(serverSocket_);
-        serverSocket_ = -1;
+void TcpPcmBackend::teardown() {
+    for (auto* timer : {&connectTimer_, &retryTimer_, &keepaliveTimer_, &watchdogTimer_, &clockSyncTimer_}) {
+        if (*timer != 0) {
+            loop_.cancelTimer(*timer);
+            *timer = 0;
+        }
     }
 
-    if (workerThread_.joinable()) {
-        workerThread_.join();
-    }
-    if (acceptThread_.joinable()) {
-        acceptThread_.join();
+    bool peerConnected = socket_ != -1 || clientSocket_ != -1;
+
+    for (int sock : {socket_, pendingSocket_, clientSocket_, serverSocket_}) {
+        if (sock != -1) {
+            loop_.unwatch(sock);
+        }
     }
-    if (keepaliveThread_.joinable()) {
-        keepaliveThread_.join();
+
+    if (socket_ != -1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeSocket(socket_);
     }
+    closeSocket(pendingSocket_);
+    closeSocket(clientSocket_);
+    closeSocket(serverSocket_);
 
-    state_ = TransportState::Disconnected;
+    if (peerConnected && connectionCallback_) {
+        connectionCallback_(false);
+    }
 }
 
 bool TcpPcmBackend::sendAudio(const float* const* channelData, int numChannels, int numSamples) {
-    if (state_ != TransportState::Streaming || socket_ == -1) {
+    // While reconnecting, audio is dropped rather than queued
+    if (state_ != TransportState::Streaming) {
         return false;
     }
 
     // Interleave audio data
     size_t totalSamples = static_cast<size_t>(numChannels * numSamples);
     interleavedBuffer_.resize(totalSamples);
-
-    for (int i = 0; i < numSamples; ++i) {
-        for (int ch = 0; ch < numChannels; ++ch) {
-            interleavedBuffer_[static_cast<size_t>(i * numChannels + ch)] = channelData[ch][i];
-        }
-    }
+    interleave(channelData, numChannels, numSamples, interleavedBuffer_.data());
 
     // Create chunk header
     ChunkHeader chunkHeader;
     chunkHeader.size = static_cast<uint32_t>(totalSamples * sizeof(float));
     chunkHeader.sequence = sequence_++;
+    size_t payloadSize = chunkHeader.size;
 
-    auto headerData = chunkHeader.serialize();
-
-    // Send header and data
+    // The media clock advances under the same lock a reconnect resets it
+    // under, and keeps advancing over dropped chunks
     std::lock_guard<std::mutex> lock(mutex_);
-    if (!sendAll(socket_, headerData.data(), headerData.size())) {
+    if (socket_ == -1) {
         return false;
     }
-    if (!sendAll(socket_, interleavedBuffer_.data(), chunkHeader.size)) {
+    int64_t timestamp = mediaTimestamp(numSamples);
+    bool timestamped = timestamping_.load(std::memory_order_acquire);
+    if (timestamped) {
+        chunkHeader.size |= CHUNK_TIMESTAMPED;
+    }
+    std::array<uint8_t, CHUNK_HEADER_SIZE + CHUNK_TIMESTAMP_SIZE> headerData;
+    size_t headerSize = CHUNK_HEADER_SIZE;
+    chunkHeader.serializeInto(headerData.data());
+    if (timestamped) {
+        std::memcpy(headerData.data() + CHUNK_HEADER_SIZE, &timestamp, CHUNK_TIMESTAMP_SIZE);
+        headerSize += CHUNK_TIMESTAMP_SIZE;
+    }
+
+    // Send header and data. A full send buffer drops the chunk, which the
+    // receiver counts as a sequence gap.
+    auto result = sendMessage(headerData.data(), headerSize, interleavedBuffer_.data(), payloadSize);
+    if (result == SendResult::Failed) {
+        // Stop sending; the loop sees the socket error and reconnects
+        auto streaming = TransportState::Streaming;
+        state_.compare_exchange_strong(streaming, TransportState::Connecting);
+        return false;
+    }
+    if (result == SendResult::Dropped) {
+        chunksDropped_++;
         return false;
     }
 
-    bytesSent_ += headerData.size() + chunkHeader.size;
+    bytesSent_ += headerSize + payloadSize;
+    chunksSent_++;
+    lastSendNs_.store(steadyNowNs(), std::memory_order_relaxed);
     return true;
 }
 
+int64_t TcpPcmBackend::mediaTimestamp(int numSamples) {
+    // The block was complete when it was handed over, so its first frame
+    // was captured one block earlier
+    const double nsPerFrame = 1.0e9 / streamConfig_.sampleRate;
+    int64_t captured = steadyNowNs() - static_cast<int64_t>(numSamples * nsPerFrame);
+
+    // Counted forward in frames and pulled gently toward the steady clock, so
+    // stamps neither jitter with the callback nor drift with the device clock
+    int64_t stamp = mediaBaseNs_ + static_cast<int64_t>(static_cast<double>(mediaFrames_) * nsPerFrame);
+    int64_t drift = captured - stamp;
+    if (!mediaAnchored_ || drift > MEDIA_CLOCK_RESYNC_NS || drift < -MEDIA_CLOCK_RESYNC_NS) {
+        mediaAnchored_ = true;
+        mediaBaseNs_ = captured;
+        mediaFrames_ = 0;
+        stamp = captured;
+    } else {
+        mediaBaseNs_ += drift / MEDIA_CLOCK_SMOOTHING;
+    }
+
+    mediaFrames_ += static_cast<uint64_t>(numSamples);
+    return stamp;
+}
+
 TransportStatus TcpPcmBackend::getStatus() const {
-    TransportStatus status;
+    // Peer and error come from the last publish; state and counters are
+    // always current
+    TransportStatus status = published_.load();
     status.state = state_;
-    status.peerAddress = peerAddress_;
-    status.peerPort = peerPort_;
     status.bytesSent = bytesSent_;
     status.bytesReceived = bytesReceived_;
     status.packetsLost = packetsLost_;
-    status.errorMessage = errorMessage_;
     return status;
 }
 
+void TcpPcmBackend::setPeer(std::string_view address, uint16_t port) {
+    std::lock_guard<std::mutex> lock(statusMutex_);
+    status_.peerAddress.assign(address);
+    status_.peerPort = port;
+    published_.store(status_);
+}
+
+void TcpPcmBackend::setError(std::string_view message) {
+    std::lock_guard<std::mutex> lock(statusMutex_);
+    status_.errorMessage.assign(message);
+    published_.store(status_);
+}
+
+TransportStats TcpPcmBackend::getStats() const {
+    TransportStats stats;
+    stats.bytesSent = bytesSent_;
+    stats.bytesReceived = bytesReceived_;
+    stats.chunksSent = chunksSent_;
+    stats.chunksDropped = chunksDropped_;
+    stats.chunksReceived = chunksReceived_;
+    stats.sequenceGaps = packetsLost_;
+    stats.keepalivesSent = keepalivesSent_;
+    stats.keepalivesReceived = keepalivesReceived_;
+    stats.connections = connections_;
+    stats.reconnects = reconnects_;
+    stats.connectFailures = connectFailures_;
+    stats.downtimeMs = downtimeMs_;
+    stats.peerTimeouts = peerTimeouts_;
+    stats.clockExchanges = clockExchanges_;
+    return stats;
+}
+
 void TcpPcmBackend::setAudioReceivedCallback(AudioReceivedCallback callback) {
     audioCallback_ = std::move(callback);
 }
@@ -189,193 +354,517 @@ void TcpPcmBackend::setConnectionCallback(ConnectionCallback callback) {
     connectionCallback_ = std::move(callback);
 }
 
-void TcpPcmBackend::senderThread() {
-    // Connect to receiver
-    socket_ = static_cast<int>(socket(AF_INET, SOCK_STREAM, 0));
-    if (socket_ == INVALID_SOCKET) {
-        errorMessage_ = "Failed to create socket";
-        state_ = TransportState::Error;
-        return;
-    }
+void TcpPcmBackend::setStreamConfigCallback(StreamConfigCallback callback) {
+    streamConfigCallback_ = std::move(callback);
+}
 
-    // Disable Nagle's algorithm for lower latency
-    int flag = 1;
-    setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
+void TcpPcmBackend::beginConnect() {
+    retryTimer_ = 0;
+    state_ = TransportState::Connecting;
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_port = htons(port_);
+    inet_pton(AF_INET, targetHost_.c_str(), &addr.sin_addr);
 
-    if (inet_pton(AF_INET, targetHost_.c_str(), &addr.sin_addr) <= 0) {
-        errorMessage_ = "Invalid address: " + targetHost_;
-        state_ = TransportState::Error;
-        CLOSE_SOCKET(socket_);
-        socket_ = -1;
+    pendingSocket_ = static_cast<int>(socket(AF_INET, SOCK_STREAM, 0));
+    if (pendingSocket_ == INVALID_SOCKET) {
+        pendingSocket_ = -1;
+        failConnect("Failed to create socket");
         return;
     }
 
-    if (connect(socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-        errorMessage_ = "Failed to connect to " + targetHost_ + ":" + std::to_string(port_);
-        state_ = TransportState::Error;
-        CLOSE_SOCKET(socket_);
-        socket_ = -1;
+    // Disable Nagle's algorithm for lower latency
+    int flag = 1;
+    setsockopt(pendingSocket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
+#ifdef SO_NOSIGPIPE
+    setsockopt(pendingSocket_, SOL_SOCKET, SO_NOSIGPIPE, &flag, sizeof(flag));
+#endif
+
+    // Connect without blocking the loop; completion shows up as writability
+    setNonBlocking(pendingSocket_, true);
+    if (connect(pendingSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 && !wouldBlock()) {
+        failConnect("Failed to connect to " + targetHost_ + ":" + std::to_string(port_));
         return;
     }
 
-    peerAddress_ = targetHost_;
-    peerPort_ = port_;
-    state_ = TransportState::Connected;
+    loop_.watch(pendingSocket_, EventLoop::WRITABLE, [this](uint32_t) { onConnectReady(); });
+    connectTimer_ = loop_.addTimer(std::chrono::milliseconds(CONNECT_TIMEOUT_MS), std::chrono::milliseconds(0),
+                                   [this] {
+        connectTimer_ = 0;
+        failConnect("Timed out connecting to " + targetHost_ + ":" + std::to_string(port_));
+    });
+}
 
-    if (connectionCallback_) {
-        connectionCallback_(true);
+void TcpPcmBackend::onConnectReady() {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(pendingSocket_, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length);
+    if (error != 0) {
+        failConnect("Failed to connect to " + targetHost_ + ":" + std::to_string(port_));
+        return;
     }
 
-    // Send stream header
+    loop_.unwatch(pendingSocket_);
+    loop_.cancelTimer(connectTimer_);
+    connectTimer_ = 0;
+
+    int sock = pendingSocket_;
+    pendingSocket_ = -1;
+
+    // Send stream header. A fresh sequence keeps the receiver's loss count
+    // meaningful across reconnects.
     StreamHeader header = StreamHeader::fromConfig(streamConfig_);
     auto headerData = header.serialize();
-
-    if (!sendAll(socket_, headerData.data(), headerData.size())) {
-        errorMessage_ = "Failed to send stream header";
-        state_ = TransportState::Error;
+    if (!sendAll(sock, headerData.data(), headerData.size())) {
+        pendingSocket_ = sock;
+        failConnect("Failed to send stream header");
         return;
     }
 
-    state_ = TransportState::Streaming;
+    onConnected(sock);
+}
 
-    // Sender is passive - audio is sent via sendAudio()
-    // Just wait until stopped
-    while (running_ && state_ == TransportState::Streaming) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait_for(lock, std::chrono::milliseconds(100));
+void TcpPcmBackend::failConnect(const std::string& reason) {
+    if (pendingSocket_ != -1) {
+        loop_.unwatch(pendingSocket_);
+        closeSocket(pendingSocket_);
     }
+    if (connectTimer_ != 0) {
+        loop_.cancelTimer(connectTimer_);
+        connectTimer_ = 0;
+    }
+
+    connectFailures_++;
+    setError(reason + ", retrying in " + std::to_string(backoffMs_) + " ms");
+    state_ = TransportState::Connecting;
+
+    // Equal jitter: half the delay is fixed, half random, so a receiver
+    // restart does not get every sender back in the same instant
+    std::uniform_int_distribution<int> jitter(0, backoffMs_ / 2);
+    int delayMs = backoffMs_ - backoffMs_ / 2 + jitter(rng_);
+    backoffMs_ = std::min(backoffMs_ * 2, RECONNECT_MAX_MS);
+
+    retryTimer_ = loop_.addTimer(std::chrono::milliseconds(delayMs), std::chrono::milliseconds(0),
+                                 [this] { beginConnect(); });
 }
 
-void TcpPcmBackend::acceptThread() {
-    while (running_) {
-        sockaddr_in clientAddr{};
-        socklen_t clientLen = sizeof(clientAddr);
+void TcpPcmBackend::onConnected(int sock) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        socket_ = sock;
+        sequence_ = 0;
+        mediaAnchored_ = false;
+        txBacklog_.clear();
+        txBacklogSent_ = 0;
+    }
+    timestamping_ = false;  // Until this receiver asks for clock sync
+    syncRequestFilled_ = 0;
 
-        clientSocket_ = static_cast<int>(accept(serverSocket_,
-            reinterpret_cast<sockaddr*>(&clientAddr), &clientLen));
+    if (everConnected_) {
+        reconnects_++;
+        downtimeMs_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            EventLoop::Clock::now() - disconnectedAt_).count());
+    }
+    everConnected_ = true;
+    backoffMs_ = RECONNECT_INITIAL_MS;
 
-        if (clientSocket_ == INVALID_SOCKET) {
-            if (running_) {
-                errorMessage_ = "Accept failed";
-            }
-            continue;
-        }
+    setPeer(targetHost_, port_);
+    setError({});
+    connections_++;
 
-        // Disable Nagle's algorithm
-        int flag = 1;
-        setsockopt(clientSocket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
+    // Streaming before the callback, so a listener woken by it can send
+    lastSendNs_.store(steadyNowNs(), std::memory_order_relaxed);
+    state_ = TransportState::Streaming;
 
-        char addrStr[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &clientAddr.sin_addr, addrStr, INET_ADDRSTRLEN);
-        peerAddress_ = addrStr;
-        peerPort_ = ntohs(clientAddr.sin_port);
+    if (connectionCallback_) {
+        connectionCallback_(true);
+    }
 
-        state_ = TransportState::Connected;
+    // The receiver only sends clock sync requests; anything else readable
+    // means it closed or reset
+    loop_.watch(socket_, EventLoop::READABLE, [this](uint32_t) { onSenderReadable(); });
+    keepaliveTimer_ = loop_.addTimer(std::chrono::milliseconds(KEEPALIVE_INTERVAL_MS),
+                                     std::chrono::milliseconds(KEEPALIVE_INTERVAL_MS),
+                                     [this] { onKeepaliveTimer(); });
+}
 
-        if (connectionCallback_) {
-            connectionCallback_(true);
+void TcpPcmBackend::onSenderReadable() {
+    uint8_t buffer[256];
+    auto received = recv(socket_, reinterpret_cast<char*>(buffer), sizeof(buffer), 0);
+    if (received < 0 && wouldBlock()) {
+        return;
+    }
+    if (received <= 0) {
+        dropSender("Connection lost");
+        return;
+    }
+
+    int64_t receivedNs = steadyNowNs();
+    for (size_t offset = 0; offset < static_cast<size_t>(received);) {
+        size_t count = std::min(CLOCK_SYNC_REQUEST_SIZE - syncRequestFilled_, static_cast<size_t>(received) - offset);
+        std::memcpy(syncRequest_.data() + syncRequestFilled_, buffer + offset, count);
+        syncRequestFilled_ += count;
+        offset += count;
+        if (syncRequestFilled_ == CLOCK_SYNC_REQUEST_SIZE) {
+            syncRequestFilled_ = 0;
+            answerClockSync(receivedNs);
         }
+    }
+}
 
-        // Start receiver thread for this client
-        workerThread_ = std::thread(&TcpPcmBackend::receiverThread, this);
-        workerThread_.join();
+void TcpPcmBackend::answerClockSync(int64_t receivedNs) {
+    timestamping_.store(true, std::memory_order_release);
 
-        if (connectionCallback_) {
-            connectionCallback_(false);
-        }
+    // Like keepalives, never queue behind the audio thread; the receiver
+    // simply gets no answer to this request and asks again
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || socket_ == -1) {
+        return;
+    }
 
-        CLOSE_SOCKET(clientSocket_);
-        clientSocket_ = -1;
-        state_ = TransportState::Connecting;
+    ClockSyncReply reply;
+    std::memcpy(&reply.originate, syncRequest_.data(), CLOCK_SYNC_REQUEST_SIZE);
+    reply.receive = receivedNs;
+
+    ChunkHeader header;
+    header.size = CHUNK_CLOCK_SYNC | static_cast<uint32_t>(CLOCK_SYNC_REPLY_SIZE);
+    auto data = header.serialize();
+    reply.transmit = steadyNowNs();
+    auto body = reply.serialize();
+    data.insert(data.end(), body.begin(), body.end());
+
+    auto result = sendMessage(data.data(), data.size(), nullptr, 0);
+    if (result == SendResult::Failed) {
+        // The keepalive timer notices the broken connection and reconnects
+        auto streaming = TransportState::Streaming;
+        state_.compare_exchange_strong(streaming, TransportState::Connecting);
+        return;
+    }
+    if (result == SendResult::Dropped) {
+        return;
     }
+    clockExchanges_++;
+    lastSendNs_.store(steadyNowNs(), std::memory_order_relaxed);
 }
 
-void TcpPcmBackend::receiverThread() {
-    // Receive stream header
-    std::vector<uint8_t> headerBuffer(STREAM_HEADER_SIZE);
-    if (!receiveAll(clientSocket_, headerBuffer.data(), STREAM_HEADER_SIZE)) {
-        errorMessage_ = "Failed to receive stream header";
-        state_ = TransportState::Error;
+void TcpPcmBackend::onKeepaliveTimer() {
+    if (state_ != TransportState::Streaming) {
+        dropSender("Connection lost");  // A send failed on the audio thread
         return;
     }
 
-    StreamHeader header;
-    if (!StreamHeader::deserialize(headerBuffer.data(), headerBuffer.size(), header)) {
-        errorMessage_ = "Invalid stream header";
-        state_ = TransportState::Error;
+    // Audio chunks already prove liveness; only fill silences
+    auto idleNs = steadyNowNs() - lastSendNs_.load(std::memory_order_relaxed);
+    if (idleNs < static_cast<int64_t>(KEEPALIVE_INTERVAL_MS) * 1000000 / 2) {
         return;
     }
 
-    streamConfig_ = header.toConfig();
-    state_ = TransportState::Streaming;
+    // Never queue behind the audio thread; if it holds the lock, audio is flowing
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    // A full send buffer already has data on its way to the receiver
+    ChunkHeader keepalive;
+    keepalive.size = 0;  // Zero-size chunk = keepalive
+    auto data = keepalive.serialize();
+    auto result = sendMessage(data.data(), data.size(), nullptr, 0);
+    if (result == SendResult::Failed) {
+        lock.unlock();
+        dropSender("Connection lost");
+        return;
+    }
+    if (result == SendResult::Dropped) {
+        return;
+    }
+    keepalivesSent_++;
+    lastSendNs_.store(steadyNowNs(), std::memory_order_relaxed);
+}
+
+void TcpPcmBackend::dropSender(const std::string& reason) {
+    if (socket_ == -1) {
+        return;
+    }
+
+    loop_.unwatch(socket_);
+    loop_.cancelTimer(keepaliveTimer_);
+    keepaliveTimer_ = 0;
+
+    state_ = TransportState::Connecting;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeSocket(socket_);
+    }
+
+    setError(reason);
+    disconnectedAt_ = EventLoop::Clock::now();
+
+    if (connectionCallback_) {
+        connectionCallback_(false);
+    }
+
+    beginConnect();
+}
+
+void TcpPcmBackend::onAcceptReady() {
+    sockaddr_in clientAddr{};
+    socklen_t clientLen = sizeof(clientAddr);
+
+    int sock = static_cast<int>(accept(serverSocket_,
+        reinterpret_cast<sockaddr*>(&clientAddr), &clientLen));
+    if (sock == INVALID_SOCKET) {
+        if (!wouldBlock()) {
+            setError("Accept failed");
+        }
+        return;
+    }
+
+    setNonBlocking(sock, true);
+
+    // Disable Nagle's algorithm
+    int flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag));
 
-    // Receive audio chunks
-    std::vector<uint8_t> chunkHeaderBuffer(CHUNK_HEADER_SIZE);
-    std::vector<float> audioBuffer;
-    uint32_t expectedSequence = 0;
+    char addrStr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &clientAddr.sin_addr, addrStr, INET_ADDRSTRLEN);
+    setPeer(addrStr, ntohs(clientAddr.sin_port));
 
-    while (running_ && state_ == TransportState::Streaming) {
-        if (!receiveAll(clientSocket_, chunkHeaderBuffer.data(), CHUNK_HEADER_SIZE)) {
-            if (running_) {
-                errorMessage_ = "Connection lost";
-                state_ = TransportState::Disconnected;
+    clientSocket_ = sock;
+    state_ = TransportState::Connected;
+    connections_++;
+
+    if (connectionCallback_) {
+        connectionCallback_(true);
+    }
+
+    // One sender at a time: later ones wait in the listen backlog until
+    // this one is dropped
+    loop_.unwatch(serverSocket_);
+
+    rxPhase_ = RxPhase::StreamHeader;
+    rxFilled_ = 0;
+    rxExpected_ = STREAM_HEADER_SIZE;
+    expectedSequence_ = 0;
+    lastActivity_ = EventLoop::Clock::now();
+
+    loop_.watch(clientSocket_, EventLoop::READABLE, [this](uint32_t) { onClientReadable(); });
+    watchdogTimer_ = loop_.addTimer(std::chrono::milliseconds(DISCONNECT_TIMEOUT_MS), std::chrono::milliseconds(0),
+                                    [this] { onWatchdogTimer(); });
+}
+
+void TcpPcmBackend::onClientReadable() {
+    for (int i = 0; i < MAX_READS_PER_WAKE; ++i) {
+        // Headers land in rxHeader_, payloads straight in the float buffer
+        auto* target = rxPhase_ == RxPhase::Payload
+            ? reinterpret_cast<char*>(audioBuffer_.data())
+            : reinterpret_cast<char*>(rxHeader_.data());
+
+        auto received = recv(clientSocket_, target + rxFilled_, static_cast<int>(rxExpected_ - rxFilled_), 0);
+        if (received == 0) {
+            dropClient("Connection lost");
+            return;
+        }
+        if (received < 0) {
+            if (!wouldBlock()) {
+                dropClient("Connection lost");
             }
-            break;
+            return;
+        }
+
+        lastActivity_ = EventLoop::Clock::now();
+        rxFilled_ += static_cast<size_t>(received);
+        if (rxFilled_ == rxExpected_ && !handleFrame()) {
+            return;
         }
+    }
+}
+
+bool TcpPcmBackend::handleFrame() {
+    rxFilled_ = 0;
 
-        ChunkHeader chunkHeader;
-        if (!ChunkHeader::deserialize(chunkHeaderBuffer.data(), chunkHeaderBuffer.size(), chunkHeader)) {
-            continue;
+    switch (rxPhase_) {
+        case RxPhase::StreamHeader: {
+            StreamHeader header;
+            if (!StreamHeader::deserialize(rxHeader_.data(), STREAM_HEADER_SIZE, header)) {
+                dropClient("Invalid stream header");
+                return false;
+            }
+
+            // Chunks are split into frames by channel count and played at the
+            // sender's rate, so a format the server would refuse goes no further
+            std::string error;
+            if (!header.toConfig().validate(error)) {
+                dropClient("Invalid stream header: " + error);
+                return false;
+            }
+            if (header.bitsPerSample != 32) {
+                dropClient("Invalid stream header: only 32-bit float audio is supported");
+                return false;
+            }
+
+            streamConfig_ = header.toConfig();
+            if (streamConfigCallback_) {
+                streamConfigCallback_(streamConfig_);
+            }
+            state_ = TransportState::Streaming;
+
+            // Start estimating this sender's clock
+            clockSync_.reset();
+            onClockSyncTimer();
+            if (clientSocket_ == -1) {
+                return false;
+            }
+
+            rxPhase_ = RxPhase::ChunkHeader;
+            rxExpected_ = CHUNK_HEADER_SIZE;
+            return true;
         }
 
-        // Handle keepalive packets (size = 0)
-        if (chunkHeader.size == 0) {
-            continue;
+        case RxPhase::ChunkHeader: {
+            ChunkHeader::deserialize(rxHeader_.data(), CHUNK_HEADER_SIZE, rxChunk_);
+
+            // Handle keepalive packets (size = 0)
+            if (rxChunk_.size == 0) {
+                keepalivesReceived_++;
+                return true;
+            }
+
+            if (rxChunk_.clockSync()) {
+                if (rxChunk_.payloadSize() != CLOCK_SYNC_REPLY_SIZE) {
+                    dropClient("Invalid clock sync reply");
+                    return false;
+                }
+                rxPhase_ = RxPhase::ClockSyncReply;
+                rxExpected_ = CLOCK_SYNC_REPLY_SIZE;
+                return true;
+            }
+
+            const uint32_t payloadSize = rxChunk_.payloadSize();
+            if (payloadSize == 0 || payloadSize % sizeof(float) != 0 || payloadSize > MAX_CHUNK_BYTES) {
+                dropClient("Invalid chunk size " + std::to_string(payloadSize));
+                return false;
+            }
+
+            // Check for packet loss
+            if (rxChunk_.sequence != expectedSequence_) {
+                packetsLost_ += rxChunk_.sequence - expectedSequence_;
+            }
+            expectedSequence_ = rxChunk_.sequence + 1;
+
+            audioBuffer_.resize(payloadSize / sizeof(float));
+            rxTimestamp_ = NO_TIMESTAMP;
+            if (rxChunk_.timestamped()) {
+                rxPhase_ = RxPhase::Timestamp;
+                rxExpected_ = CHUNK_TIMESTAMP_SIZE;
+            } else {
+                rxPhase_ = RxPhase::Payload;
+                rxExpected_ = payloadSize;
+            }
+            return true;
         }
 
-        // Check for packet loss
-        if (chunkHeader.sequence != expectedSequence) {
-            packetsLost_ += chunkHeader.sequence - expectedSequence;
+        case RxPhase::Timestamp: {
+            std::memcpy(&rxTimestamp_, rxHeader_.data(), CHUNK_TIMESTAMP_SIZE);
+            rxPhase_ = RxPhase::Payload;
+            rxExpected_ = rxChunk_.payloadSize();
+            return true;
         }
-        expectedSequence = chunkHeader.sequence + 1;
-
-        // Receive audio data
-        audioBuffer.resize(chunkHeader.size / sizeof(float));
-        if (!receiveAll(clientSocket_, audioBuffer.data(), chunkHeader.size)) {
-            if (running_) {
-                errorMessage_ = "Failed to receive audio data";
-                state_ = TransportState::Error;
+
+        case RxPhase::Payload: {
+            bytesReceived_ += CHUNK_HEADER_SIZE + rxChunk_.payloadSize()
+                            + (rxChunk_.timestamped() ? CHUNK_TIMESTAMP_SIZE : 0);
+            chunksReceived_++;
+
+            // Invoke callback with received audio
+            if (audioCallback_) {
+                int numSamples = static_cast<int>(audioBuffer_.size()) / streamConfig_.channels;
+                audioCallback_(audioBuffer_.data(), streamConfig_.channels, numSamples, rxTimestamp_);
             }
-            break;
+
+            rxPhase_ = RxPhase::ChunkHeader;
+            rxExpected_ = CHUNK_HEADER_SIZE;
+            return true;
         }
 
-        bytesReceived_ += CHUNK_HEADER_SIZE + chunkHeader.size;
+        case RxPhase::ClockSyncReply: {
+            int64_t arrivalNs = steadyNowNs();
+            ClockSyncReply reply;
+            ClockSyncReply::deserialize(rxHeader_.data(), CLOCK_SYNC_REPLY_SIZE, reply);
+            clockSync_.addExchange(reply.originate, reply.receive, reply.transmit, arrivalNs);
+            clockExchanges_++;
 
-        // Invoke callback with received audio
-        if (audioCallback_) {
-            int numSamples = static_cast<int>(audioBuffer.size()) / streamConfig_.channels;
-            audioCallback_(audioBuffer.data(), streamConfig_.channels, numSamples);
+            rxPhase_ = RxPhase::ChunkHeader;
+            rxExpected_ = CHUNK_HEADER_SIZE;
+            return true;
         }
     }
+    return true;
 }
 
-void TcpPcmBackend::keepaliveThread() {
-    ChunkHeader keepalive;
-    keepalive.size = 0;  // Zero-size chunk = keepalive
+void TcpPcmBackend::onClockSyncTimer() {
+    clockSyncTimer_ = 0;
+
+    // The loop thread is the only writer on a receiver's socket, and eight
+    // bytes into an idle send buffer never come back short
+    int64_t originate = steadyNowNs();
+    auto sent = send(clientSocket_, reinterpret_cast<const char*>(&originate),
+                     static_cast<int>(CLOCK_SYNC_REQUEST_SIZE), SEND_FLAGS);
+    if (sent < 0 && !wouldBlock()) {
+        dropClient("Connection lost");
+        return;
+    }
+    if (sent > 0 && static_cast<size_t>(sent) != CLOCK_SYNC_REQUEST_SIZE) {
+        dropClient("Failed to send clock sync request");
+        return;
+    }
+
+    // Fill the estimator's window quickly, then settle to a slow refresh
+    int delayMs = clockSync_.filling() ? CLOCK_SYNC_FAST_INTERVAL_MS : CLOCK_SYNC_INTERVAL_MS;
+    clockSyncTimer_ = loop_.addTimer(std::chrono::milliseconds(delayMs), std::chrono::milliseconds(0),
+                                     [this] { onClockSyncTimer(); });
+}
+
+void TcpPcmBackend::onWatchdogTimer() {
+    watchdogTimer_ = 0;
+
+    // A peer that lost power or its cable never sends a FIN. Keepalives
+    // arrive every KEEPALIVE_INTERVAL_MS, so silence this long means it is gone.
+    auto timeout = std::chrono::milliseconds(DISCONNECT_TIMEOUT_MS);
+    auto idle = EventLoop::Clock::now() - lastActivity_;
+    if (idle >= timeout) {
+        peerTimeouts_++;
+        dropClient(state_ == TransportState::Streaming ? "Peer timed out" : "Peer sent no stream header");
+        return;
+    }
 
-    while (running_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(KEEPALIVE_INTERVAL_MS));
+    // Re-arm lazily for the remaining time rather than on every read
+    watchdogTimer_ = loop_.addTimer(std::chrono::duration_cast<std::chrono::milliseconds>(timeout - idle) +
+                                        std::chrono::milliseconds(1),
+                                    std::chrono::milliseconds(0), [this] { onWatchdogTimer(); });
+}
 
-        if (state_ == TransportState::Streaming && socket_ != -1) {
-            auto data = keepalive.serialize();
-            std::lock_guard<std::mutex> lock(mutex_);
-            sendAll(socket_, data.data(), data.size());
+void TcpPcmBackend::dropClient(const std::string& reason) {
+    loop_.unwatch(clientSocket_);
+    for (auto* timer : {&watchdogTimer_, &clockSyncTimer_}) {
+        if (*timer != 0) {
+            loop_.cancelTimer(*timer);
+            *timer = 0;
         }
     }
+    closeSocket(clientSocket_);
+    clockSync_.reset();
+
+    setError(reason);
+
+    if (connectionCallback_) {
+        connectionCallback_(false);
+    }
+
+    // Free the slot; a queued sender is accepted on the next loop iteration
+    state_ = TransportState::Connecting;
+    loop_.watch(serverSocket_, EventLoop::READABLE, [this](uint32_t) { onAcceptReady(); });
 }
 
 bool TcpPcmBackend::sendAll(int sock, const void* data, size_t size) {
@@ -383,7 +872,7 @@ bool TcpPcmBackend::sendAll(int sock, const void* data, size_t size) {
     size_t remaining = size;
 
     while (remaining > 0) {
-        auto sent = send(sock, ptr, static_cast<int>(remaining), 0);
+        auto sent = send(sock, ptr, static_cast<int>(remaining), SEND_FLAGS);
         if (sent <= 0) {
             return false;
         }
@@ -394,20 +883,52 @@ bool TcpPcmBackend::sendAll(int sock, const void* data, size_t size) {
     return true;
 }
 
-bool TcpPcmBackend::receiveAll(int sock, void* data, size_t size) {
-    auto* ptr = static_cast<char*>(data);
-    size_t remaining = size;
-
-    while (remaining > 0) {
-        auto received = recv(sock, ptr, static_cast<int>(remaining), 0);
-        if (received <= 0) {
-            return false;
+TcpPcmBackend::SendResult TcpPcmBackend::sendMessage(const void* head, size_t headSize,
+                                                     const void* body, size_t bodySize) {
+    // The rest of a message cut short last time must go out before anything new
+    while (txBacklogSent_ < txBacklog_.size()) {
+        auto sent = send(socket_, reinterpret_cast<const char*>(txBacklog_.data() + txBacklogSent_),
+                         static_cast<int>(txBacklog_.size() - txBacklogSent_), SEND_FLAGS);
+        if (sent < 0 && wouldBlock()) {
+            return SendResult::Dropped;
+        }
+        if (sent <= 0) {
+            return SendResult::Failed;
         }
-        ptr += received;
-        remaining -= static_cast<size_t>(received);
+        txBacklogSent_ += static_cast<size_t>(sent);
     }
-
-    return true;
+    txBacklog_.clear();
+    txBacklogSent_ = 0;
+
+    const std::pair<const uint8_t*, size_t> parts[] = {
+        {static_cast<const uint8_t*>(head), headSize},
+        {static_cast<const uint8_t*>(body), bodySize},
+    };
+    size_t total = 0;
+    for (size_t i = 0; i < std::size(parts); ++i) {
+        size_t done = 0;
+        while (done < parts[i].second) {
+            auto sent = send(socket_, reinterpret_cast<const char*>(parts[i].first + done),
+                             static_cast<int>(parts[i].second - done), SEND_FLAGS);
+            if (sent < 0 && wouldBlock()) {
+                if (total == 0) {
+                    return SendResult::Dropped;
+                }
+                // Started: keep the rest, within the capacity reserved at start
+                txBacklog_.insert(txBacklog_.end(), parts[i].first + done, parts[i].first + parts[i].second);
+                for (size_t j = i + 1; j < std::size(parts); ++j) {
+                    txBacklog_.insert(txBacklog_.end(), parts[j].first, parts[j].first + parts[j].second);
+                }
+                return SendResult::Sent;
+            }
+            if (sent <= 0) {
+                return SendResult::Failed;
+            }
+            done += static_cast<size_t>(sent);
+            total += static_cast<size_t>(sent);
+        }
+    }
+    return SendResult::Sent;
 }
 
 } // namespace audioserver
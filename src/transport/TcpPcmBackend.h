@@ -2,16 +2,44 @@
 
 #include "TransportBackend.h"
 #include "TcpPcmProtocol.h"
+#include "ClockSync.h"
+#include "EventLoop.h"
+#include "../SeqLock.h"
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <thread>
 #include <mutex>
-#include <condition_variable>
+#include <random>
 #include <vector>
 
 namespace audioserver {
 
+// Owns no threads: connecting, accepting, receiving, keepalives and
+// disconnect deadlines all run as callbacks on the shared EventLoop, and
+// sendAudio() writes from the caller's (audio) thread. Sockets stay
+// non-blocking, so a stalled receiver costs dropped chunks, never a stalled
+// audio callback.
+//
+// Senders reconnect on their own: a failed connect or a dropped connection
+// is retried with jittered exponential backoff until stop(). Audio captured
+// while disconnected is dropped, so a reconnected stream resumes at the
+// current capture point rather than replaying a backlog.
+//
+// Receivers keep an estimate of the sender's clock (see ClockSync) by sending
+// clock sync requests over the otherwise idle return direction. A sender
+// that has been asked answers them and from then on stamps every chunk with
+// its media clock: the steady clock time its first frame was captured,
+// counted forward in frames so callback jitter does not reach the stamps.
 class TcpPcmBackend : public TransportBackend {
 public:
+    static constexpr int CONNECT_TIMEOUT_MS = 2000;
+    static constexpr int RECONNECT_INITIAL_MS = 250;
+    static constexpr int RECONNECT_MAX_MS = 10000;
+    static constexpr uint32_t MAX_CHUNK_BYTES = 16 * 1024 * 1024;
+    static constexpr int MAX_READS_PER_WAKE = 16;  // Keeps one busy peer from starving the loop
+    static constexpr int64_t MEDIA_CLOCK_RESYNC_NS = 20000000;  // Re-anchor after a capture gap this long
+    static constexpr int64_t MEDIA_CLOCK_SMOOTHING = 64;        // Blocks to pull a stamp back onto the clock
+
     TcpPcmBackend();
     ~TcpPcmBackend() override;
 
@@ -25,50 +53,136 @@ public:
     bool sendAudio(const float* const* channelData, int numChannels, int numSamples) override;
 
     TransportStatus getStatus() const override;
+    TransportState state() const override { return state_; }
+    TransportStats getStats() const override;
+    ClockEstimate getClockEstimate() const override { return clockSync_.estimate(); }
 
     void setAudioReceivedCallback(AudioReceivedCallback callback) override;
     void setConnectionCallback(ConnectionCallback callback) override;
+    void setStreamConfigCallback(StreamConfigCallback callback) override;
 
 private:
-    void senderThread();
-    void receiverThread();
-    void acceptThread();
-    void keepaliveThread();
+    enum class RxPhase { StreamHeader, ChunkHeader, Timestamp, Payload, ClockSyncReply };
+
+    // Sender (loop thread)
+    void beginConnect();
+    void onConnectReady();
+    void failConnect(const std::string& reason);
+    void onConnected(int sock);
+    void onSenderReadable();
+    void answerClockSync(int64_t receivedNs);
+    void onKeepaliveTimer();
+    void dropSender(const std::string& reason);
+
+    // Receiver (loop thread)
+    void onAcceptReady();
+    void onClientReadable();
+    bool handleFrame();
+    void onClockSyncTimer();
+    void onWatchdogTimer();
+    void dropClient(const std::string& reason);
+
+    // Loop thread: cancels timers, unwatches and closes every socket
+    void teardown();
+
     bool sendAll(int socket, const void* data, size_t size);
-    bool receiveAll(int socket, void* data, size_t size);
+
+    enum class SendResult { Sent, Dropped, Failed };
+
+    // Sender, under mutex_: writes head then body to socket_ without
+    // blocking. Finishes a message cut short earlier first; a message that
+    // cannot start is Dropped, one that starts is completed on later sends.
+    SendResult sendMessage(const void* head, size_t headSize, const void* body, size_t bodySize);
+
+    // Sender, under mutex_: media clock time of the first of the next numSamples frames
+    int64_t mediaTimestamp(int numSamples);
+
+    // Update the peer/error part of the published status (empty clears)
+    void setPeer(std::string_view address, uint16_t port);
+    void setError(std::string_view message);
+
+    EventLoop& loop_;
 
     std::atomic<bool> running_{false};
     std::atomic<TransportState> state_{TransportState::Disconnected};
 
-    std::thread workerThread_;
-    std::thread acceptThread_;
-    std::thread keepaliveThread_;
-
-    int socket_ = -1;
+    int socket_ = -1;         // Sender: connected socket, written by sendAudio()
+    int pendingSocket_ = -1;  // Sender: connect in progress
     int clientSocket_ = -1;
     int serverSocket_ = -1;
 
+    EventLoop::TimerId connectTimer_ = 0;
+    EventLoop::TimerId retryTimer_ = 0;
+    EventLoop::TimerId keepaliveTimer_ = 0;
+    EventLoop::TimerId watchdogTimer_ = 0;
+    EventLoop::TimerId clockSyncTimer_ = 0;
+
     std::string targetHost_;
     uint16_t port_ = 0;
     StreamConfig streamConfig_;
 
     AudioReceivedCallback audioCallback_;
     ConnectionCallback connectionCallback_;
-
-    mutable std::mutex mutex_;
-    std::condition_variable cv_;
+    StreamConfigCallback streamConfigCallback_;
+
+    mutable std::mutex mutex_;  // Serializes writes to the socket
+
+    // Sender, under mutex_: the unsent tail of a message the send buffer
+    // could not take whole, so chunks stay framed
+    std::vector<uint8_t> txBacklog_;
+    size_t txBacklogSent_ = 0;
+
+    // Reconnect state (loop thread)
+    std::mt19937 rng_{std::random_device{}()};
+    int backoffMs_ = RECONNECT_INITIAL_MS;
+    bool everConnected_ = false;
+    EventLoop::Clock::time_point disconnectedAt_;
+
+    // Clock sync, sender side: requests arrive on the loop thread; the media
+    // clock is advanced under mutex_ by whichever thread sends audio
+    std::array<uint8_t, CLOCK_SYNC_REQUEST_SIZE> syncRequest_{};
+    size_t syncRequestFilled_ = 0;
+    std::atomic<bool> timestamping_{false};  // The receiver asked, so it understands stamps
+    bool mediaAnchored_ = false;
+    int64_t mediaBaseNs_ = 0;
+    uint64_t mediaFrames_ = 0;
+
+    // Receive state (loop thread)
+    RxPhase rxPhase_ = RxPhase::StreamHeader;
+    std::array<uint8_t, std::max(STREAM_HEADER_SIZE, CLOCK_SYNC_REPLY_SIZE)> rxHeader_{};
+    size_t rxFilled_ = 0;
+    size_t rxExpected_ = 0;
+    ChunkHeader rxChunk_;
+    int64_t rxTimestamp_ = NO_TIMESTAMP;
+    uint32_t expectedSequence_ = 0;
+    EventLoop::Clock::time_point lastActivity_;
+    std::vector<float> audioBuffer_;
+    ClockSync clockSync_;
+
+    std::atomic<int64_t> lastSendNs_{0};  // steady_clock; lets keepalives skip while audio flows
 
     std::atomic<uint64_t> bytesSent_{0};
     std::atomic<uint64_t> bytesReceived_{0};
     std::atomic<uint32_t> packetsLost_{0};
     std::atomic<uint32_t> sequence_{0};
+    std::atomic<uint64_t> chunksSent_{0};
+    std::atomic<uint64_t> chunksDropped_{0};
+    std::atomic<uint64_t> chunksReceived_{0};
+    std::atomic<uint64_t> keepalivesSent_{0};
+    std::atomic<uint64_t> keepalivesReceived_{0};
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> reconnects_{0};
+    std::atomic<uint64_t> connectFailures_{0};
+    std::atomic<uint64_t> downtimeMs_{0};
+    std::atomic<uint64_t> peerTimeouts_{0};
+    std::atomic<uint64_t> clockExchanges_{0};
 
-    std::vector<uint8_t> sendBuffer_;
     std::vector<float> interleavedBuffer_;
 
-    std::string errorMessage_;
-    std::string peerAddress_;
-    uint16_t peerPort_ = 0;
+    // Written from the loop and control threads, read from anywhere
+    std::mutex statusMutex_;          // Serializes writers
+    TransportStatus status_;          // Writers' copy
+    SeqLock<TransportStatus> published_;
 };
 
 } // namespace audioserver
@@ -15,6 +15,8 @@ constexpr size_t STREAM_HEADER_SIZE = 20;
 constexpr size_t CHUNK_HEADER_SIZE = 8;
 constexpr uint16_t KEEPALIVE_INTERVAL_MS = 2000;
 constexpr uint16_t DISCONNECT_TIMEOUT_MS = 5000;
+constexpr uint16_t CLOCK_SYNC_INTERVAL_MS = 250;
+constexpr uint16_t CLOCK_SYNC_FAST_INTERVAL_MS = 20;  // Until the estimator's window is full
 
 // Stream header format (20 bytes):
 // - Magic: 4 bytes "ACAU"
@@ -117,18 +119,38 @@ struct StreamHeader {
 // Chunk header format (8 bytes):
 // - Size: 4 bytes (number of bytes of audio data)
 // - Sequence: 4 bytes (monotonically increasing)
+//
+// The top bits of size are flags, only ever set once the receiver has sent a
+// clock sync request, so older receivers never see them:
+// - CHUNK_TIMESTAMPED: an 8-byte media timestamp (the sender's steady clock,
+//   in ns, when the chunk's first frame was captured) precedes the audio
+// - CHUNK_CLOCK_SYNC: not audio but a ClockSyncReply; sequence is unused
+
+constexpr uint32_t CHUNK_TIMESTAMPED = 0x80000000u;
+constexpr uint32_t CHUNK_CLOCK_SYNC = 0x40000000u;
+constexpr uint32_t CHUNK_SIZE_MASK = 0x3FFFFFFFu;
+constexpr size_t CHUNK_TIMESTAMP_SIZE = 8;
 
 struct ChunkHeader {
     uint32_t size = 0;
     uint32_t sequence = 0;
 
+    uint32_t payloadSize() const { return size & CHUNK_SIZE_MASK; }
+    bool timestamped() const { return (size & CHUNK_TIMESTAMPED) != 0; }
+    bool clockSync() const { return (size & CHUNK_CLOCK_SYNC) != 0; }
+
     std::vector<uint8_t> serialize() const {
         std::vector<uint8_t> data(CHUNK_HEADER_SIZE);
-        std::memcpy(data.data(), &size, 4);
-        std::memcpy(data.data() + 4, &sequence, 4);
+        serializeInto(data.data());
         return data;
     }
 
+    // Writes CHUNK_HEADER_SIZE bytes without allocating, for the audio thread
+    void serializeInto(uint8_t* data) const {
+        std::memcpy(data, &size, 4);
+        std::memcpy(data + 4, &sequence, 4);
+    }
+
     static bool deserialize(const uint8_t* data, size_t dataSize, ChunkHeader& header) {
         if (dataSize < CHUNK_HEADER_SIZE) {
             return false;
@@ -139,4 +161,39 @@ struct ChunkHeader {
     }
 };
 
+// Clock sync exchange, receiver -> sender -> receiver (NTP's four timestamps,
+// each endpoint's steady clock in ns):
+// - Request (8 bytes), the only thing a receiver ever sends: originate (t1)
+// - Reply (24 bytes, framed as a CHUNK_CLOCK_SYNC chunk): originate (t1,
+//   echoed), receive (t2) and transmit (t3) on the sender's clock
+// The receiver notes t4 on arrival. Senders that predate the exchange read
+// and discard requests, so the receiver just never locks.
+
+constexpr size_t CLOCK_SYNC_REQUEST_SIZE = 8;
+constexpr size_t CLOCK_SYNC_REPLY_SIZE = 24;
+
+struct ClockSyncReply {
+    int64_t originate = 0;
+    int64_t receive = 0;
+    int64_t transmit = 0;
+
+    std::vector<uint8_t> serialize() const {
+        std::vector<uint8_t> data(CLOCK_SYNC_REPLY_SIZE);
+        std::memcpy(data.data(), &originate, 8);
+        std::memcpy(data.data() + 8, &receive, 8);
+        std::memcpy(data.data() + 16, &transmit, 8);
+        return data;
+    }
+
+    static bool deserialize(const uint8_t* data, size_t dataSize, ClockSyncReply& reply) {
+        if (dataSize < CLOCK_SYNC_REPLY_SIZE) {
+            return false;
+        }
+        std::memcpy(&reply.originate, data, 8);
+        std::memcpy(&reply.receive, data + 8, 8);
+        std::memcpy(&reply.transmit, data + 16, 8);
+        return true;
+    }
+};
+
 } // namespace audioserver
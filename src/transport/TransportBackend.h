@@ -1,8 +1,12 @@
 #pragma once
 
 #include "../Config.h"
+#include "ClockSync.h"
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace audioserver {
 
@@ -14,20 +18,62 @@ enum class TransportState {
     Error
 };
 
+// NUL-terminated text of bounded length, so a TransportStatus can be copied
+// without allocating. Longer values are truncated.
+template <size_t N>
+struct FixedString {
+    char text[N] = {};
+
+    void assign(std::string_view value) {
+        size_t length = std::min(value.size(), N - 1);
+        std::memcpy(text, value.data(), length);
+        text[length] = '\0';
+    }
+
+    bool empty() const { return text[0] == '\0'; }
+    const char* c_str() const { return text; }
+    std::string str() const { return text; }
+    operator std::string_view() const { return text; }
+};
+
+// Trivially copyable: backends publish it through a seqlock, so readers on
+// any thread (audio included) get a consistent copy without locking
 struct TransportStatus {
     TransportState state = TransportState::Disconnected;
-    std::string peerAddress;
+    FixedString<64> peerAddress;
     uint16_t peerPort = 0;
     uint64_t bytesSent = 0;
     uint64_t bytesReceived = 0;
     uint32_t packetsLost = 0;
-    std::string errorMessage;
+    FixedString<192> errorMessage;
+};
+
+// Monotonic counters since the backend was created. Read from atomics, so
+// safe to sample from any thread without contending with the stream.
+struct TransportStats {
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t chunksSent = 0;
+    uint64_t chunksDropped = 0;  // Sender: chunks dropped because the socket's send buffer was full
+    uint64_t chunksReceived = 0;
+    uint64_t sequenceGaps = 0;
+    uint64_t keepalivesSent = 0;
+    uint64_t keepalivesReceived = 0;
+    uint64_t connections = 0;
+    uint64_t reconnects = 0;     // Connections re-established after a drop or failed attempt
+    uint64_t connectFailures = 0;
+    uint64_t downtimeMs = 0;     // Total time spent reconnecting
+    uint64_t peerTimeouts = 0;   // Receiver: silent peers dropped after DISCONNECT_TIMEOUT_MS
+    uint64_t clockExchanges = 0; // Clock sync replies sent (sender) or received (receiver)
 };
 
 class TransportBackend {
 public:
-    using AudioReceivedCallback = std::function<void(const float*, int, int)>;
+    // Interleaved audio, channels, frames, and the sender's media clock time
+    // of the first frame (NO_TIMESTAMP from senders that do not stamp chunks)
+    using AudioReceivedCallback = std::function<void(const float*, int, int, int64_t)>;
     using ConnectionCallback = std::function<void(bool connected)>;
+    using StreamConfigCallback = std::function<void(const StreamConfig&)>;
 
     virtual ~TransportBackend() = default;
 
@@ -41,9 +87,22 @@ public:
     virtual bool sendAudio(const float* const* channelData, int numChannels, int numSamples) = 0;
 
     virtual TransportStatus getStatus() const = 0;
+    // Just the state, for loops that check it on every buffer
+    virtual TransportState state() const = 0;
+    virtual TransportStats getStats() const = 0;
+
+    // Receiver: the connected sender's clock relative to ours (never locked
+    // in sender mode, where this end is the reference)
+    virtual ClockEstimate getClockEstimate() const = 0;
 
     virtual void setAudioReceivedCallback(AudioReceivedCallback callback) = 0;
+    // Senders report connected once audio can be sent (state is Streaming)
     virtual void setConnectionCallback(ConnectionCallback callback) = 0;
+
+    // Receiver: called with the sender's format when a stream header arrives,
+    // before any of that connection's audio is delivered. Like the other
+    // callbacks it runs on the transport's thread and must not block.
+    virtual void setStreamConfigCallback(StreamConfigCallback callback) = 0;
 };
 
 } // namespace audioserver
@@ -0,0 +1,46 @@
+#include "ChannelRouter.h"
+#include "TestHarness.h"
+#include <string>
+#include <vector>
+
+using audioserver::ChannelRouting;
+
+namespace {
+
+ChannelRouting parsed(const std::string& spec) {
+    ChannelRouting routing;
+    std::string error;
+    CHECK(ChannelRouting::parse(spec, routing, error));
+    return routing;
+}
+
+}
+
+TEST_CASE("ChannelRouting claims the first channels when straight through") {
+    ChannelRouting routing;
+    CHECK(routing.claimedChannels(false, 2) == (std::vector<int>{0, 1}));
+    CHECK(routing.claimedChannels(true, 0).empty());
+}
+
+TEST_CASE("ChannelRouting claims the device side of its routes") {
+    auto routing = parsed("0-1:8-9,0:12");
+    CHECK(routing.claimedChannels(false, 2) == (std::vector<int>{8, 9, 12}));
+    CHECK(routing.claimedChannels(true, 2) == (std::vector<int>{0, 1}));
+}
+
+// Streams split across one interface, as in the README example: the
+// limitation is that they may share the device but never its channels
+TEST_CASE("ChannelRouting overlap between streams on one device") {
+    auto primary = parsed("0-1:0-1").claimedChannels(false, 2);
+    auto drums = parsed("0-7:8-15").claimedChannels(false, 8);
+    auto keys = parsed("0-1:16-17").claimedChannels(false, 2);
+    CHECK(ChannelRouting::overlap(primary, drums).empty());
+    CHECK(ChannelRouting::overlap(drums, keys).empty());
+
+    auto clash = parsed("0-1:15-16").claimedChannels(false, 2);
+    CHECK(ChannelRouting::overlap(drums, clash) == (std::vector<int>{15}));
+    CHECK(ChannelRouting::overlap(keys, clash) == (std::vector<int>{16}));
+
+    ChannelRouting straight;
+    CHECK(ChannelRouting::overlap(primary, straight.claimedChannels(false, 2)) == (std::vector<int>{0, 1}));
+}
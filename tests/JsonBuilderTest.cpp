@@ -0,0 +1,44 @@
+#include "JsonBuilder.h"
+#include "TestHarness.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using audioserver::JsonBuilder;
+
+namespace {
+
+template<typename T>
+std::string valueOf(T v) {
+    JsonBuilder json;
+    json.value(v);
+    return json.build();
+}
+
+}
+
+TEST_CASE("JsonBuilder formats every integer type") {
+    // size_t, long and long long alias different fixed-width types per platform
+    CHECK_EQ(valueOf(size_t{42}), "42");
+    CHECK_EQ(valueOf(std::numeric_limits<unsigned long>::max()),
+             std::to_string(std::numeric_limits<unsigned long>::max()));
+    CHECK_EQ(valueOf(std::numeric_limits<unsigned long long>::max()), "18446744073709551615");
+    CHECK_EQ(valueOf(std::numeric_limits<long long>::min()), "-9223372036854775808");
+    CHECK_EQ(valueOf(-7L), "-7");
+    CHECK_EQ(valueOf(uint16_t{65535}), "65535");
+    CHECK_EQ(valueOf(int8_t{-128}), "-128");
+    CHECK_EQ(valueOf(-3), "-3");
+}
+
+TEST_CASE("JsonBuilder keeps bool, floating point and strings apart") {
+    CHECK_EQ(valueOf(true), "true");
+    CHECK_EQ(valueOf(0.5), "0.5");
+    CHECK_EQ(valueOf(-6.02f), "-6.02");
+    CHECK_EQ(valueOf("text"), "\"text\"");
+
+    JsonBuilder json;
+    const unsigned long long count = 3;
+    json.beginObject().keyValue("count", count).keyValue("size", size_t{2}).endObject();
+    CHECK_EQ(json.build(), "{\"count\":3,\"size\":2}");
+}
@@ -0,0 +1,92 @@
+#include "JsonReader.h"
+#include "TestHarness.h"
+#include <string>
+
+using audioserver::JsonReader;
+
+namespace {
+
+// The text of a top-level field, or "<absent>"
+std::string field(const JsonReader& reader, const char* key) {
+    const auto* value = reader.find(key);
+    return value ? value->text : std::string("<absent>");
+}
+
+bool parses(const std::string& text) {
+    JsonReader reader;
+    std::string error;
+    return reader.parse(text, error);
+}
+
+}
+
+TEST_CASE("JsonReader does not take a value for a key") {
+    JsonReader reader;
+    std::string error;
+    CHECK(reader.parse(R"({"name":"sampleRate","sampleRate":48000})", error));
+    CHECK_EQ(field(reader, "name"), "sampleRate");
+    CHECK_EQ(field(reader, "sampleRate"), "48000");
+    CHECK(reader.find("sampleRate")->type == JsonReader::Type::Number);
+
+    CHECK(reader.parse(R"({"device":"channels"})", error));
+    CHECK_EQ(field(reader, "channels"), "<absent>");
+}
+
+TEST_CASE("JsonReader does not match a key inside another key") {
+    JsonReader reader;
+    std::string error;
+    CHECK(reader.parse(R"({"maxChannels": 64, "xchannels": 3, "channels": 2})", error));
+    CHECK_EQ(field(reader, "channels"), "2");
+    CHECK(reader.parse(R"({"maxChannels": 64})", error));
+    CHECK_EQ(field(reader, "channels"), "<absent>");
+}
+
+TEST_CASE("JsonReader unescapes strings") {
+    JsonReader reader;
+    std::string error;
+    CHECK(reader.parse(R"({"file": "take \"1\"\\a.wav", "sampleRate": 44100})", error));
+    CHECK_EQ(field(reader, "file"), "take \"1\"\\a.wav");
+    CHECK_EQ(field(reader, "sampleRate"), "44100");
+
+    CHECK(reader.parse(R"({"device": "Caf\u00e9 \ud83c\udfb9\n"})", error));
+    CHECK_EQ(field(reader, "device"), "Caf\xc3\xa9 \xf0\x9f\x8e\xb9\n");
+
+    // An escaped quote followed by something that looks like a key
+    CHECK(reader.parse(R"({"name": "a\",\"port\":1", "port": 9877})", error));
+    CHECK_EQ(field(reader, "port"), "9877");
+}
+
+TEST_CASE("JsonReader keeps nested values whole") {
+    JsonReader reader;
+    std::string error;
+    CHECK(reader.parse(R"({"meta": {"channels": 8, "list": [1, "}"]}, "channels": 2})", error));
+    CHECK_EQ(field(reader, "channels"), "2");
+    CHECK(reader.find("meta")->type == JsonReader::Type::Object);
+    CHECK_EQ(reader.size(), 2u);
+}
+
+TEST_CASE("JsonReader literals and duplicates") {
+    JsonReader reader;
+    std::string error;
+    CHECK(reader.parse(R"({"loop": true, "routes": null, "delayMs": 10, "delayMs": 20})", error));
+    CHECK(reader.find("loop")->type == JsonReader::Type::Bool);
+    CHECK(reader.find("routes")->type == JsonReader::Type::Null);
+    CHECK_EQ(field(reader, "delayMs"), "20");
+}
+
+TEST_CASE("JsonReader rejects malformed bodies") {
+    CHECK(parses("{}"));
+    CHECK(parses(" { \"a\" : -1.5e3 } "));
+    CHECK(!parses(""));
+    CHECK(!parses("[1, 2]"));
+    CHECK(!parses("{\"a\": 1"));
+    CHECK(!parses("{\"a\" 1}"));
+    CHECK(!parses("{\"a\": 01}"));
+    CHECK(!parses("{\"a\": \"unterminated}"));
+    CHECK(!parses("{\"a\": \"bad \\x escape\"}"));
+    CHECK(!parses("{\"a\": \"\\ud83c\"}"));
+    CHECK(!parses("{\"a\": 1} trailing"));
+    CHECK(!parses("{a: 1}"));
+    CHECK(!parses(std::string(100, '[') + "{}" ));
+    CHECK(!parses("{\"a\": " + std::string(40, '[') + std::string(40, ']') + "}"));
+}
@@ -0,0 +1,35 @@
+#include "MetricsBuilder.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <string>
+
+using audioserver::Histogram;
+using audioserver::MetricsBuilder;
+
+TEST_CASE("MetricsBuilder declares a family once for every stream's sample") {
+    MetricsBuilder metrics;
+    metrics.family("audioserver_audio_underruns", "counter", "Dropouts");
+    metrics.counterSample("audioserver_audio_underruns", {{"stream", "main"}}, uint64_t{3});
+    metrics.counterSample("audioserver_audio_underruns", {{"stream", "drums"}}, uint64_t{0});
+
+    CHECK_EQ(metrics.build(),
+             std::string("# TYPE audioserver_audio_underruns counter\n"
+                         "# HELP audioserver_audio_underruns Dropouts\n"
+                         "audioserver_audio_underruns_total{stream=\"main\"} 3\n"
+                         "audioserver_audio_underruns_total{stream=\"drums\"} 0\n"
+                         "# EOF\n"));
+}
+
+TEST_CASE("MetricsBuilder labels every line of a summary") {
+    Histogram histogram;
+    histogram.record(1000);
+
+    MetricsBuilder metrics;
+    metrics.summarySample("latency_seconds", {{"stream", "a\"b"}}, histogram.snapshot(), 1.0e9);
+    std::string text = metrics.build();
+
+    CHECK(text.find("latency_seconds{stream=\"a\\\"b\",quantile=\"0.5\"} ") != std::string::npos);
+    CHECK(text.find("latency_seconds{stream=\"a\\\"b\",quantile=\"0.99\"} ") != std::string::npos);
+    CHECK(text.find("latency_seconds_sum{stream=\"a\\\"b\"} 1e-06\n") != std::string::npos);
+    CHECK(text.find("latency_seconds_count{stream=\"a\\\"b\"} 1\n") != std::string::npos);
+}
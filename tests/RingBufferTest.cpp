@@ -0,0 +1,88 @@
+#include "RingBuffer.h"
+#include "TestHarness.h"
+#include <vector>
+
+using audioserver::RingBuffer;
+
+namespace {
+
+// Stereo frames whose samples name their frame and channel: frame f is
+// {2f, 2f + 1}, so a shifted frame shows up as an odd left sample
+std::vector<float> stereoFrames(size_t first, size_t count) {
+    std::vector<float> data;
+    for (size_t f = first; f < first + count; ++f) {
+        data.push_back(static_cast<float>(2 * f));
+        data.push_back(static_cast<float>(2 * f + 1));
+    }
+    return data;
+}
+
+bool channelsInOrder(const std::vector<float>& data, size_t count) {
+    for (size_t i = 0; i + 1 < count; i += 2) {
+        if (static_cast<long>(data[i]) % 2 != 0 || data[i + 1] != data[i] + 1.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+TEST_CASE("RingBuffer keeps one slot free") {
+    RingBuffer<float> ring(8);
+    std::vector<float> data(16, 1.0f);
+    CHECK_EQ(ring.write(data.data(), data.size()), 7u);
+    CHECK_EQ(ring.size(), 7u);
+    CHECK_EQ(ring.available(), 0u);
+}
+
+TEST_CASE("RingBuffer wraps around") {
+    RingBuffer<float> ring(5);
+    std::vector<float> out(4);
+    for (int round = 0; round < 10; ++round) {
+        std::vector<float> in = {float(round), float(round + 1), float(round + 2)};
+        CHECK_EQ(ring.write(in.data(), in.size()), 3u);
+        CHECK_EQ(ring.read(out.data(), out.size()), 3u);
+        CHECK(out[0] == in[0] && out[1] == in[1] && out[2] == in[2]);
+    }
+}
+
+TEST_CASE("RingBuffer overrun stores whole frames only") {
+    // 960 samples hold 479 stereo frames and a spare sample, which a plain
+    // write would fill with half a frame
+    RingBuffer<float> ring(960, 2);
+    auto burst = stereoFrames(0, 600);
+    size_t written = ring.write(burst.data(), burst.size());
+    CHECK_EQ(written % 2, 0u);
+    CHECK_EQ(written, 958u);
+
+    // Then run steadily: 64-frame blocks in, 64-frame blocks out, with the
+    // buffer staying full so every write is cut short
+    std::vector<float> out(128);
+    size_t next = written / 2;
+    size_t swapped = 0;
+    for (int block = 0; block < 50; ++block) {
+        auto frames = stereoFrames(next, 64);
+        size_t accepted = ring.write(frames.data(), frames.size());
+        CHECK_EQ(accepted % 2, 0u);
+        next += accepted / 2;
+
+        size_t read = ring.read(out.data(), out.size());
+        CHECK_EQ(read % 2, 0u);
+        if (!channelsInOrder(out, read)) {
+            swapped++;
+        }
+    }
+    CHECK_EQ(swapped, 0u);
+}
+
+TEST_CASE("RingBuffer skip drops the oldest items") {
+    RingBuffer<float> ring(16, 2);
+    auto frames = stereoFrames(0, 4);
+    ring.write(frames.data(), frames.size());
+    CHECK_EQ(ring.skip(4), 4u);
+    std::vector<float> out(4);
+    CHECK_EQ(ring.read(out.data(), out.size()), 4u);
+    CHECK(out[0] == 4.0f && out[1] == 5.0f);
+    CHECK_EQ(ring.skip(100), 0u);
+}
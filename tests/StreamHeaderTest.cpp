@@ -0,0 +1,51 @@
+#include "transport/TcpPcmProtocol.h"
+#include "TestHarness.h"
+#include <string>
+
+using audioserver::StreamConfig;
+using audioserver::StreamHeader;
+
+namespace {
+
+// A header as it arrives off the wire, checked the way the receiver does
+bool accepted(const StreamHeader& sent) {
+    auto data = sent.serialize();
+    StreamHeader received;
+    std::string error;
+    return StreamHeader::deserialize(data.data(), data.size(), received)
+        && received.toConfig().validate(error);
+}
+
+}
+
+TEST_CASE("StreamHeader accepts the default format") {
+    CHECK(accepted(StreamHeader{}));
+}
+
+TEST_CASE("StreamHeader rejects formats outside the stream limits") {
+    StreamHeader header;
+    header.channels = 0;  // Would divide by zero splitting chunks into frames
+    CHECK(!accepted(header));
+    header.channels = StreamConfig::MAX_CHANNELS + 1;
+    CHECK(!accepted(header));
+
+    header = StreamHeader{};
+    header.sampleRate = 0;
+    CHECK(!accepted(header));
+    header.sampleRate = StreamConfig::MAX_SAMPLE_RATE + 1;
+    CHECK(!accepted(header));
+
+    header = StreamHeader{};
+    header.bufferSize = StreamConfig::MIN_BUFFER_SIZE - 1;
+    CHECK(!accepted(header));
+    header.bufferSize = StreamConfig::MAX_BUFFER_SIZE + 1;
+    CHECK(!accepted(header));
+}
+
+TEST_CASE("StreamHeader validation explains the rejection") {
+    StreamConfig config;
+    config.channels = 0;
+    std::string error;
+    CHECK(!config.validate(error));
+    CHECK_EQ(error, "channels must be between 1 and 64");
+}
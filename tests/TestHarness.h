@@ -0,0 +1,77 @@
+#pragma once
+
+// Minimal test harness for the unit tests: no dependencies, so the tests
+// build without JUCE like the benchmarks.
+//
+// TEST_CASE registers a function; CHECK records a failure with its location
+// and carries on, so one run reports every broken expectation.
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace audioserver {
+namespace test {
+
+struct TestCase {
+    const char* name;
+    std::function<void()> body;
+};
+
+inline std::vector<TestCase>& registry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> body) {
+        registry().push_back({name, std::move(body)});
+    }
+};
+
+inline void fail(const char* file, int line, const std::string& expression) {
+    std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", file, line, expression.c_str());
+    failures()++;
+}
+
+// Runs every registered case; the exit code is the number of failures, capped
+inline int runAll() {
+    for (const auto& test : registry()) {
+        int before = failures();
+        test.body();
+        std::fprintf(stderr, "%s %s\n", failures() == before ? "[pass]" : "[FAIL]", test.name);
+    }
+    std::fprintf(stderr, "%zu cases, %d failed checks\n", registry().size(), failures());
+    return failures() > 0 ? 1 : 0;
+}
+
+} // namespace test
+} // namespace audioserver
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST_CASE(name) \
+    static void TEST_CONCAT(testBody_, __LINE__)(); \
+    static audioserver::test::Registrar TEST_CONCAT(testRegistrar_, __LINE__)(name, TEST_CONCAT(testBody_, __LINE__)); \
+    static void TEST_CONCAT(testBody_, __LINE__)()
+
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) { \
+            audioserver::test::fail(__FILE__, __LINE__, #expression); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        if (!((actual) == (expected))) { \
+            audioserver::test::fail(__FILE__, __LINE__, #actual " == " #expected); \
+        } \
+    } while (0)
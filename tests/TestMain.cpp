@@ -0,0 +1,7 @@
+// audio-server-tests: unit tests for the parts that run without a device.
+
+#include "TestHarness.h"
+
+int main() {
+    return audioserver::test::runAll();
+}